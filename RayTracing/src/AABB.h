@@ -0,0 +1,55 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cfloat>
+
+#include "Ray.h"
+
+// 轴对齐包围盒
+struct AABB
+{
+	glm::vec3 Min{ FLT_MAX };
+	glm::vec3 Max{ -FLT_MAX };
+
+	void Grow(const glm::vec3& point)
+	{
+		Min = glm::min(Min, point);
+		Max = glm::max(Max, point);
+	}
+
+	void Grow(const AABB& other)
+	{
+		Min = glm::min(Min, other.Min);
+		Max = glm::max(Max, other.Max);
+	}
+
+	bool IsValid() const { return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z; }
+
+	glm::vec3 GetExtent() const { return Max - Min; }
+	glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+
+	// 表面积，SAH 代价计算使用
+	float GetSurfaceArea() const
+	{
+		if (!IsValid())
+			return 0.0f;
+
+		glm::vec3 e = GetExtent();
+		return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+	}
+
+	// 平板法求交，返回进入距离，未命中返回 FLT_MAX
+	float Intersect(const Ray& ray, const glm::vec3& inverseDirection, float maxDistance) const
+	{
+		glm::vec3 t0 = (Min - ray.Origin) * inverseDirection;
+		glm::vec3 t1 = (Max - ray.Origin) * inverseDirection;
+		glm::vec3 tNear = glm::min(t0, t1);
+		glm::vec3 tFar = glm::max(t0, t1);
+
+		float tEnter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+		float tExit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, maxDistance));
+
+		return tEnter <= tExit ? tEnter : FLT_MAX;
+	}
+};
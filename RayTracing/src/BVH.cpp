@@ -0,0 +1,864 @@
+#include "BVH.h"
+#include "SphereArray.h"
+
+#include "Walnut/Timer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <execution>
+#include <future>
+#include <numeric>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace Utils
+{
+	// SAH 代价常数：遍历一个内部节点与求交一个球体的相对开销
+	static constexpr float TraversalCost = 1.0f;
+	static constexpr float IntersectionCost = 1.0f;
+
+	static constexpr uint32_t MaxLeafSize = 8;
+	// 遍历栈的大小即为最大深度
+	static constexpr uint32_t MaxDepth = 64;
+
+	static constexpr uint32_t MaxBinCount = 32;
+	// 图元数不少于该值的节点在节点内部并行（包围盒归约、分箱、划分）
+	static constexpr uint32_t ParallelThreshold = 1 << 16;
+	// 并行分箱时每个任务处理的图元数
+	static constexpr uint32_t BinChunkSize = 1 << 14;
+	// 图元数不少于该值的子树作为独立任务构建
+	static constexpr uint32_t TaskThreshold = 1 << 12;
+
+	static uint32_t GetBinCount(BVH::BuildQuality quality)
+	{
+		switch (quality)
+		{
+			case BVH::BuildQuality::Fast:     return 8;
+			case BVH::BuildQuality::Balanced: return 32;
+			default:                          return 0;
+		}
+	}
+
+	static AABB SphereBounds(const Sphere& sphere)
+	{
+		glm::vec3 radius{ glm::abs(sphere.Radius) };
+
+		AABB bounds;
+		bounds.Min = sphere.Position - radius;
+		bounds.Max = sphere.Position + radius;
+		return bounds;
+	}
+
+	static AABB Merge(AABB a, const AABB& b)
+	{
+		a.Grow(b);
+		return a;
+	}
+
+	// 任务深度限制在线程数的几倍以内，避免创建过多线程
+	static uint32_t GetTaskDepth()
+	{
+		uint32_t threadCount = glm::max(std::thread::hardware_concurrency(), 1u);
+		uint32_t depth = 0;
+		while ((1u << depth) < threadCount * 4)
+			depth++;
+		return depth;
+	}
+}
+
+struct BVH::BuildContext
+{
+	// 构建期间直接划分图元引用本身而非索引，分箱与划分都是顺序访存
+	struct Reference
+	{
+		AABB Bounds;
+		glm::vec3 Centroid;
+		uint32_t Index;
+	};
+	std::vector<Reference> References;
+	// References[0] 对应的图元位置，局部重建时只为子树内的图元创建引用
+	uint32_t FirstPrimitive = 0;
+
+	std::vector<Reference>::iterator Begin(const Node& node) { return References.begin() + (node.LeftFirst - FirstPrimitive); }
+	std::vector<Reference>::const_iterator Begin(const Node& node) const { return References.begin() + (node.LeftFirst - FirstPrimitive); }
+
+	uint32_t BinCount = 0;
+	bool Multithreaded = true;
+	uint32_t MaxTaskDepth = 0;
+
+	std::atomic<uint32_t> NodeCount{ 0 };
+};
+
+struct BVH::Split
+{
+	int Axis = -1;
+	float Cost = FLT_MAX;
+
+	// 划分后左右子节点的包围盒，子节点无需再遍历图元求包围盒
+	AABB LeftBounds;
+	AABB RightBounds;
+
+	// 分箱：质心所在箱号小于 Bin 的图元归入左侧
+	uint32_t Bin = 0;
+	float BinOrigin = 0.0f;
+	float BinScale = 0.0f;
+
+	// 扫描：已按该轴排好序的图元，前 Index 个归入左侧
+	uint32_t Index = 0;
+	std::vector<BuildContext::Reference> SortedReferences;
+};
+
+void BVH::Build(const std::vector<Sphere>& spheres, BuildQuality quality, bool multithreaded)
+{
+	Walnut::Timer timer;
+
+	Clear();
+
+	m_Quality = quality;
+	m_Multithreaded = multithreaded;
+
+	uint32_t primitiveCount = (uint32_t)spheres.size();
+	if (primitiveCount == 0)
+		return;
+
+	BuildContext context;
+	context.BinCount = Utils::GetBinCount(quality);
+	context.Multithreaded = multithreaded;
+
+	context.MaxTaskDepth = Utils::GetTaskDepth();
+
+	m_PrimitiveIndices.resize(primitiveCount);
+	std::iota(m_PrimitiveIndices.begin(), m_PrimitiveIndices.end(), 0);
+
+	context.References.resize(primitiveCount);
+	auto createReference = [&](uint32_t i)
+	{
+		context.References[i] = { Utils::SphereBounds(spheres[i]), spheres[i].Position, i };
+	};
+	if (multithreaded)
+		std::for_each(std::execution::par, m_PrimitiveIndices.begin(), m_PrimitiveIndices.end(), createReference);
+	else
+		std::for_each(m_PrimitiveIndices.begin(), m_PrimitiveIndices.end(), createReference);
+
+	// n 个图元的二叉树最多有 2n - 1 个节点，预先分配后各任务只需原子地领取节点索引
+	m_Nodes.resize(primitiveCount * 2 - 1);
+	Node& root = m_Nodes[0];
+	root.LeftFirst = 0;
+	root.PrimitiveCount = primitiveCount;
+	UpdateNodeBounds(root, context, multithreaded);
+	context.NodeCount = 1;
+
+	BuildNode(0, 0, context);
+
+	m_NodeCount = context.NodeCount;
+	m_Nodes.resize(m_NodeCount);
+	m_Nodes.shrink_to_fit();
+
+	// 按叶节点顺序重排球体数据
+	m_PrimitiveData.resize(primitiveCount);
+	auto gatherPrimitive = [&](uint32_t& index)
+	{
+		index = context.References[index].Index;
+
+		const Sphere& sphere = spheres[index];
+		m_PrimitiveData[&index - m_PrimitiveIndices.data()] = glm::vec4(sphere.Position, sphere.Radius * sphere.Radius);
+	};
+	if (multithreaded)
+		std::for_each(std::execution::par, m_PrimitiveIndices.begin(), m_PrimitiveIndices.end(), gatherPrimitive);
+	else
+		std::for_each(m_PrimitiveIndices.begin(), m_PrimitiveIndices.end(), gatherPrimitive);
+
+	m_BuildAreas.resize(m_NodeCount);
+	for (uint32_t i = 0; i < m_NodeCount; i++)
+		m_BuildAreas[i] = m_Nodes[i].GetBounds().GetSurfaceArea();
+	m_BuildSAHCost = GetSAHCost();
+
+	m_BuildTime = timer.ElapsedMillis();
+	m_UpdateTime = m_BuildTime;
+	m_LastUpdateType = UpdateType::Rebuild;
+}
+
+void BVH::Clear()
+{
+	m_Nodes.clear();
+	m_NodeCount = 0;
+	m_UnusedNodeCount = 0;
+	m_BuildAreas.clear();
+	m_BuildSAHCost = 0.0f;
+	m_PrimitiveIndices.clear();
+	m_PrimitiveData.clear();
+	m_BuildTime = 0.0f;
+}
+
+void BVH::UpdateNodeBounds(Node& node, const BuildContext& context, bool parallel)
+{
+	auto begin = context.Begin(node);
+	auto end = begin + node.PrimitiveCount;
+	auto primitiveBounds = [](const BuildContext::Reference& reference) { return reference.Bounds; };
+
+	AABB nodeBounds = parallel
+		? std::transform_reduce(std::execution::par, begin, end, AABB(), Utils::Merge, primitiveBounds)
+		: std::transform_reduce(begin, end, AABB(), Utils::Merge, primitiveBounds);
+
+	node.BoundsMin = nodeBounds.Min;
+	node.BoundsMax = nodeBounds.Max;
+}
+
+// 自顶向下递归构建，左右子树足够大时并行。进入时节点包围盒已由父节点的划分给出
+void BVH::BuildNode(uint32_t nodeIndex, uint32_t depth, BuildContext& context)
+{
+	Node& node = m_Nodes[nodeIndex];
+	uint32_t first = node.LeftFirst;
+	uint32_t count = node.PrimitiveCount;
+
+	bool parallel = context.Multithreaded && count >= Utils::ParallelThreshold;
+
+	if (count <= 1 || depth + 1 >= Utils::MaxDepth)
+		return;
+
+	Split split;
+	// 图元数不超过分箱数时全扫描既更精确也更省
+	bool found = context.BinCount > 0 && count > context.BinCount
+		? FindBinnedSplit(node, context, parallel, split)
+		: FindSweepSplit(node, context, parallel, split);
+
+	float parentArea = node.GetBounds().GetSurfaceArea();
+	float splitCost = Utils::TraversalCost + Utils::IntersectionCost * (parentArea > 0.0f ? split.Cost / parentArea : (float)count);
+	float leafCost = Utils::IntersectionCost * (float)count;
+	if (count <= Utils::MaxLeafSize && (!found || leafCost <= splitCost))
+		return;
+
+	uint32_t leftCount = found ? Partition(node, context, parallel, split) : 0;
+
+	uint32_t leftIndex = context.NodeCount.fetch_add(2);
+	Node& leftChild = m_Nodes[leftIndex];
+	Node& rightChild = m_Nodes[leftIndex + 1];
+
+	if (leftCount == 0 || leftCount == count)
+	{
+		// 质心全部重合，无法按 SAH 划分，退化为按图元数对半分
+		leftCount = count / 2;
+
+		leftChild.LeftFirst = first;
+		leftChild.PrimitiveCount = leftCount;
+		rightChild.LeftFirst = first + leftCount;
+		rightChild.PrimitiveCount = count - leftCount;
+
+		UpdateNodeBounds(leftChild, context, parallel);
+		UpdateNodeBounds(rightChild, context, parallel);
+	}
+	else
+	{
+		leftChild.LeftFirst = first;
+		leftChild.PrimitiveCount = leftCount;
+		leftChild.BoundsMin = split.LeftBounds.Min;
+		leftChild.BoundsMax = split.LeftBounds.Max;
+
+		rightChild.LeftFirst = first + leftCount;
+		rightChild.PrimitiveCount = count - leftCount;
+		rightChild.BoundsMin = split.RightBounds.Min;
+		rightChild.BoundsMax = split.RightBounds.Max;
+	}
+
+	node.LeftFirst = leftIndex;
+	node.PrimitiveCount = 0;
+
+	if (context.Multithreaded && count >= Utils::TaskThreshold && depth < context.MaxTaskDepth)
+	{
+		auto leftTask = std::async(std::launch::async, [this, leftIndex, depth, &context]()
+			{
+				BuildNode(leftIndex, depth + 1, context);
+			});
+		BuildNode(leftIndex + 1, depth + 1, context);
+		leftTask.get();
+	}
+	else
+	{
+		BuildNode(leftIndex, depth + 1, context);
+		BuildNode(leftIndex + 1, depth + 1, context);
+	}
+}
+
+bool BVH::FindBinnedSplit(const Node& node, const BuildContext& context, bool parallel, Split& split)
+{
+	struct Bin
+	{
+		AABB Bounds;
+		uint32_t Count = 0;
+	};
+
+	struct BinSet
+	{
+		Bin Bins[3][Utils::MaxBinCount];
+	};
+
+	auto begin = context.Begin(node);
+	auto end = begin + node.PrimitiveCount;
+
+	// 质心包围盒决定分箱范围
+	auto centroidBounds = [](const BuildContext::Reference& reference)
+	{
+		AABB bounds;
+		bounds.Min = bounds.Max = reference.Centroid;
+		return bounds;
+	};
+	AABB centroids = parallel
+		? std::transform_reduce(std::execution::par, begin, end, AABB(), Utils::Merge, centroidBounds)
+		: std::transform_reduce(begin, end, AABB(), Utils::Merge, centroidBounds);
+
+	uint32_t binCount = context.BinCount;
+	glm::vec3 extent = centroids.GetExtent();
+	glm::vec3 scale;
+	for (int axis = 0; axis < 3; axis++)
+		scale[axis] = extent[axis] > 0.0f ? (float)binCount / extent[axis] : 0.0f;
+
+	auto binPrimitives = [&](uint32_t from, uint32_t to, BinSet& binSet)
+	{
+		for (uint32_t i = from; i < to; i++)
+		{
+			const BuildContext::Reference& reference = context.Begin(node)[i];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				uint32_t bin = (uint32_t)glm::min((int)binCount - 1, (int)((reference.Centroid[axis] - centroids.Min[axis]) * scale[axis]));
+				binSet.Bins[axis][bin].Count++;
+				binSet.Bins[axis][bin].Bounds.Grow(reference.Bounds);
+			}
+		}
+	};
+
+	BinSet binSet;
+	if (parallel)
+	{
+		uint32_t chunkCount = (node.PrimitiveCount + Utils::BinChunkSize - 1) / Utils::BinChunkSize;
+		std::vector<uint32_t> chunks(chunkCount);
+		std::iota(chunks.begin(), chunks.end(), 0);
+
+		std::vector<BinSet> chunkBins(chunkCount);
+		std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](uint32_t chunk)
+			{
+				uint32_t from = chunk * Utils::BinChunkSize;
+				uint32_t to = glm::min(from + Utils::BinChunkSize, node.PrimitiveCount);
+				binPrimitives(from, to, chunkBins[chunk]);
+			});
+
+		for (const BinSet& chunkBin : chunkBins)
+		{
+			for (int axis = 0; axis < 3; axis++)
+			{
+				for (uint32_t bin = 0; bin < binCount; bin++)
+				{
+					binSet.Bins[axis][bin].Count += chunkBin.Bins[axis][bin].Count;
+					binSet.Bins[axis][bin].Bounds.Grow(chunkBin.Bins[axis][bin].Bounds);
+				}
+			}
+		}
+	}
+	else
+	{
+		binPrimitives(0, node.PrimitiveCount, binSet);
+	}
+
+	// 在 binCount - 1 个划分平面上求 SAH 代价
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (scale[axis] == 0.0f)
+			continue;
+
+		const Bin* bins = binSet.Bins[axis];
+
+		AABB rightBounds[Utils::MaxBinCount];
+		uint32_t rightCounts[Utils::MaxBinCount];
+		AABB right;
+		uint32_t rightCount = 0;
+		for (uint32_t bin = binCount - 1; bin > 0; bin--)
+		{
+			right.Grow(bins[bin].Bounds);
+			rightCount += bins[bin].Count;
+			rightBounds[bin] = right;
+			rightCounts[bin] = rightCount;
+		}
+
+		AABB left;
+		uint32_t leftCount = 0;
+		for (uint32_t bin = 1; bin < binCount; bin++)
+		{
+			left.Grow(bins[bin - 1].Bounds);
+			leftCount += bins[bin - 1].Count;
+			if (leftCount == 0 || rightCounts[bin] == 0)
+				continue;
+
+			float cost = left.GetSurfaceArea() * (float)leftCount + rightBounds[bin].GetSurfaceArea() * (float)rightCounts[bin];
+			if (cost < split.Cost)
+			{
+				split.Cost = cost;
+				split.Axis = axis;
+				split.LeftBounds = left;
+				split.RightBounds = rightBounds[bin];
+				split.Bin = bin;
+				split.BinOrigin = centroids.Min[axis];
+				split.BinScale = scale[axis];
+			}
+		}
+	}
+
+	return split.Axis >= 0;
+}
+
+bool BVH::FindSweepSplit(const Node& node, const BuildContext& context, bool parallel, Split& split)
+{
+	uint32_t count = node.PrimitiveCount;
+
+	std::vector<BuildContext::Reference> sorted;
+	std::vector<AABB> rightBounds(count);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		sorted.assign(context.Begin(node), context.Begin(node) + count);
+
+		auto compare = [axis](const BuildContext::Reference& a, const BuildContext::Reference& b)
+		{
+			return a.Centroid[axis] < b.Centroid[axis];
+		};
+		if (parallel)
+			std::sort(std::execution::par, sorted.begin(), sorted.end(), compare);
+		else
+			std::sort(sorted.begin(), sorted.end(), compare);
+
+		// 从右往左累积右侧包围盒面积
+		AABB right;
+		for (uint32_t i = count - 1; i > 0; i--)
+		{
+			right.Grow(sorted[i].Bounds);
+			rightBounds[i] = right;
+		}
+
+		// 从左往右扫描每个划分位置
+		AABB left;
+		bool improved = false;
+		for (uint32_t i = 1; i < count; i++)
+		{
+			left.Grow(sorted[i - 1].Bounds);
+			float cost = left.GetSurfaceArea() * (float)i + rightBounds[i].GetSurfaceArea() * (float)(count - i);
+			if (cost < split.Cost)
+			{
+				split.Cost = cost;
+				split.Axis = axis;
+				split.LeftBounds = left;
+				split.RightBounds = rightBounds[i];
+				split.Index = i;
+				improved = true;
+			}
+		}
+
+		if (improved)
+			split.SortedReferences.swap(sorted);
+	}
+
+	return split.Axis >= 0;
+}
+
+uint32_t BVH::Partition(const Node& node, BuildContext& context, bool parallel, const Split& split)
+{
+	auto begin = context.Begin(node);
+	auto end = begin + node.PrimitiveCount;
+
+	if (!split.SortedReferences.empty())
+	{
+		std::copy(split.SortedReferences.begin(), split.SortedReferences.end(), begin);
+		return split.Index;
+	}
+
+	uint32_t binCount = context.BinCount;
+	auto isLeft = [&split, binCount](const BuildContext::Reference& reference)
+	{
+		float offset = reference.Centroid[split.Axis] - split.BinOrigin;
+		return (uint32_t)glm::min((int)binCount - 1, (int)(offset * split.BinScale)) < split.Bin;
+	};
+
+	auto middle = parallel
+		? std::partition(std::execution::par, begin, end, isLeft)
+		: std::partition(begin, end, isLeft);
+
+	return (uint32_t)(middle - begin);
+}
+
+bool BVH::Intersect(const Ray& ray, float& hitDistance, int& objectIndex) const
+{
+	if (m_Nodes.empty())
+		return false;
+
+	struct StackEntry
+	{
+		uint32_t NodeIndex;
+		float Distance;
+	};
+
+	glm::vec3 inverseDirection = SafeInverse(ray.Direction);
+	float a = glm::dot(ray.Direction, ray.Direction);
+
+	bool hit = false;
+
+	StackEntry stack[Utils::MaxDepth];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = { 0, m_Nodes[0].GetBounds().Intersect(ray, inverseDirection, hitDistance) };
+
+	while (stackSize > 0)
+	{
+		StackEntry entry = stack[--stackSize];
+		if (entry.Distance >= hitDistance)
+			continue;
+
+		const Node* node = &m_Nodes[entry.NodeIndex];
+
+		// 沿最近子节点下降，较远的子节点压栈
+		while (!node->IsLeaf())
+		{
+			uint32_t nearIndex = node->LeftFirst;
+			uint32_t farIndex = node->LeftFirst + 1;
+
+			AABB nearBounds, farBounds;
+			nearBounds.Min = m_Nodes[nearIndex].BoundsMin;
+			nearBounds.Max = m_Nodes[nearIndex].BoundsMax;
+			farBounds.Min = m_Nodes[farIndex].BoundsMin;
+			farBounds.Max = m_Nodes[farIndex].BoundsMax;
+
+			float nearDistance = nearBounds.Intersect(ray, inverseDirection, hitDistance);
+			float farDistance = farBounds.Intersect(ray, inverseDirection, hitDistance);
+			if (farDistance < nearDistance)
+			{
+				std::swap(nearIndex, farIndex);
+				std::swap(nearDistance, farDistance);
+			}
+
+			if (nearDistance == FLT_MAX)
+			{
+				node = nullptr;
+				break;
+			}
+
+			if (farDistance != FLT_MAX)
+				stack[stackSize++] = { farIndex, farDistance };
+
+			node = &m_Nodes[nearIndex];
+		}
+
+		if (!node)
+			continue;
+
+		// 叶节点：与 Renderer::TraceRay 相同的求根公式
+		for (uint32_t i = 0; i < node->PrimitiveCount; i++)
+		{
+			const glm::vec4& sphere = m_PrimitiveData[node->LeftFirst + i];
+
+			glm::vec3 origin = ray.Origin - glm::vec3(sphere);
+			float b = 2.0f * glm::dot(origin, ray.Direction);
+			float c = glm::dot(origin, origin) - sphere.w;
+
+			float discriminant = b * b - 4.0f * a * c;
+			if (discriminant < 0.0f)
+				continue;
+
+			float tclose = (-b - glm::sqrt(discriminant)) / (2.0f * a);
+			if (tclose < hitDistance && tclose > 0.0f)
+			{
+				hitDistance = tclose;
+				objectIndex = (int)m_PrimitiveIndices[node->LeftFirst + i];
+				hit = true;
+			}
+		}
+	}
+
+	return hit;
+}
+
+void BVH::IntersectPacket(const RayPacket& packet, RayPacketHit& hit) const
+{
+	if (m_Nodes.empty())
+		return;
+
+#if defined(__AVX2__)
+	alignas(32) float inverseDirection[3][RayPacket::Width];
+	glm::vec3 directionSum{ 0.0f };
+	for (uint32_t lane = 0; lane < RayPacket::Width; lane++)
+	{
+		glm::vec3 direction = packet.GetRay(lane).Direction;
+		glm::vec3 inverse = SafeInverse(direction);
+		for (int axis = 0; axis < 3; axis++)
+			inverseDirection[axis][lane] = inverse[axis];
+		directionSum += direction;
+	}
+
+	__m256 rayOrigin[3], rayInverse[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		rayOrigin[axis] = _mm256_set1_ps(packet.Origin[axis]);
+		rayInverse[axis] = _mm256_load_ps(inverseDirection[axis]);
+	}
+
+	uint32_t stack[Utils::MaxDepth];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const Node& node = m_Nodes[stack[--stackSize]];
+
+		// 出栈时再与整组光线求交，此时各光线的最近交点已尽可能更新
+		__m256 tEnter = _mm256_setzero_ps();
+		__m256 tExit = _mm256_load_ps(hit.HitDistance);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			__m256 t0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.BoundsMin[axis]), rayOrigin[axis]), rayInverse[axis]);
+			__m256 t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.BoundsMax[axis]), rayOrigin[axis]), rayInverse[axis]);
+			tEnter = _mm256_max_ps(tEnter, _mm256_min_ps(t0, t1));
+			tExit = _mm256_min_ps(tExit, _mm256_max_ps(t0, t1));
+		}
+		if (_mm256_movemask_ps(_mm256_cmp_ps(tEnter, tExit, _CMP_LE_OQ)) == 0)
+			continue;
+
+		if (node.IsLeaf())
+		{
+			for (uint32_t i = node.LeftFirst; i < node.LeftFirst + node.PrimitiveCount; i++)
+				SphereArray::IntersectPacket(packet, m_PrimitiveData[i], (int)m_PrimitiveIndices[i], hit);
+			continue;
+		}
+
+		// 按整组光线的平均方向决定远近，远的子节点先压栈
+		uint32_t nearIndex = node.LeftFirst;
+		uint32_t farIndex = node.LeftFirst + 1;
+		glm::vec3 nearCenter = (m_Nodes[nearIndex].BoundsMin + m_Nodes[nearIndex].BoundsMax) * 0.5f;
+		glm::vec3 farCenter = (m_Nodes[farIndex].BoundsMin + m_Nodes[farIndex].BoundsMax) * 0.5f;
+		if (glm::dot(farCenter - nearCenter, directionSum) < 0.0f)
+			std::swap(nearIndex, farIndex);
+
+		stack[stackSize++] = farIndex;
+		stack[stackSize++] = nearIndex;
+	}
+#else
+	for (uint32_t lane = 0; lane < RayPacket::Width; lane++)
+		Intersect(packet.GetRay(lane), hit.HitDistance[lane], hit.ObjectIndex[lane]);
+#endif
+}
+
+float BVH::GetSAHCost() const
+{
+	if (m_Nodes.empty())
+		return 0.0f;
+
+	float rootArea = m_Nodes[0].GetBounds().GetSurfaceArea();
+	if (rootArea <= 0.0f)
+		return 0.0f;
+
+	// 从根节点遍历，跳过局部重建遗留的旧节点
+	float cost = 0.0f;
+	uint32_t stack[Utils::MaxDepth];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const Node& node = m_Nodes[stack[--stackSize]];
+
+		float area = node.GetBounds().GetSurfaceArea();
+		if (node.IsLeaf())
+		{
+			cost += area * Utils::IntersectionCost * (float)node.PrimitiveCount;
+		}
+		else
+		{
+			cost += area * Utils::TraversalCost;
+			stack[stackSize++] = node.LeftFirst;
+			stack[stackSize++] = node.LeftFirst + 1;
+		}
+	}
+
+	return cost / rootArea;
+}
+
+BVH::UpdateType BVH::Refit(const std::vector<Sphere>& spheres, float threshold)
+{
+	Walnut::Timer timer;
+
+	if (m_Nodes.empty() || spheres.size() != m_PrimitiveIndices.size())
+	{
+		Build(spheres, m_Quality, m_Multithreaded);
+		return m_LastUpdateType;
+	}
+
+	for (size_t i = 0; i < m_PrimitiveIndices.size(); i++)
+	{
+		const Sphere& sphere = spheres[m_PrimitiveIndices[i]];
+		m_PrimitiveData[i] = glm::vec4(sphere.Position, sphere.Radius * sphere.Radius);
+	}
+
+	// 更新包围盒的同时累计 SAH 代价，省去额外的一次遍历
+	float cost = 0.0f;
+	AABB rootBounds = RefitNode(0, cost);
+	float rootArea = rootBounds.GetSurfaceArea();
+	cost = rootArea > 0.0f ? cost / rootArea : 0.0f;
+
+	UpdateType type = UpdateType::Refit;
+	if (cost > m_BuildSAHCost * threshold)
+	{
+		struct SearchEntry
+		{
+			uint32_t NodeIndex;
+			uint32_t Depth;
+		};
+
+		// 自顶向下找出包围盒相对构建时膨胀超过阈值的最高层内部节点
+		std::vector<SearchEntry> degraded;
+		uint32_t degradedPrimitives = 0;
+
+		SearchEntry stack[Utils::MaxDepth];
+		uint32_t stackSize = 0;
+		stack[stackSize++] = { 0, 0 };
+		while (stackSize > 0)
+		{
+			SearchEntry entry = stack[--stackSize];
+			const Node& node = m_Nodes[entry.NodeIndex];
+			if (node.IsLeaf())
+				continue;
+
+			float area = node.GetBounds().GetSurfaceArea();
+			if (area > m_BuildAreas[entry.NodeIndex] * threshold)
+			{
+				uint32_t first, count;
+				GetSubtreeRange(entry.NodeIndex, first, count);
+
+				degraded.push_back(entry);
+				degradedPrimitives += count;
+				continue;
+			}
+
+			stack[stackSize++] = { node.LeftFirst, entry.Depth + 1 };
+			stack[stackSize++] = { node.LeftFirst + 1, entry.Depth + 1 };
+		}
+
+		// 劣化遍布全树、需要重建的图元过多或旧节点堆积过多时直接整体重建
+		uint32_t primitiveCount = (uint32_t)m_PrimitiveIndices.size();
+		if (degraded.empty() || degradedPrimitives * 2 > primitiveCount || m_UnusedNodeCount > GetNodeCount())
+		{
+			Build(spheres, m_Quality, m_Multithreaded);
+			return m_LastUpdateType;
+		}
+
+		for (const SearchEntry& entry : degraded)
+			RebuildSubtree(entry.NodeIndex, entry.Depth, spheres);
+
+		// 重建的子树已按新位置记录了表面积，整棵树的基准代价也随之更新
+		m_BuildSAHCost = GetSAHCost();
+		type = UpdateType::PartialRebuild;
+	}
+
+	m_UpdateTime = timer.ElapsedMillis();
+	m_LastUpdateType = type;
+	return type;
+}
+
+AABB BVH::RefitNode(uint32_t nodeIndex, float& cost)
+{
+	Node& node = m_Nodes[nodeIndex];
+
+	AABB bounds;
+	if (node.IsLeaf())
+	{
+		for (uint32_t i = 0; i < node.PrimitiveCount; i++)
+		{
+			const glm::vec4& sphere = m_PrimitiveData[node.LeftFirst + i];
+			glm::vec3 radius{ glm::sqrt(sphere.w) };
+			bounds.Grow(glm::vec3(sphere) - radius);
+			bounds.Grow(glm::vec3(sphere) + radius);
+		}
+		cost += bounds.GetSurfaceArea() * Utils::IntersectionCost * (float)node.PrimitiveCount;
+	}
+	else
+	{
+		bounds = RefitNode(node.LeftFirst, cost);
+		bounds.Grow(RefitNode(node.LeftFirst + 1, cost));
+		cost += bounds.GetSurfaceArea() * Utils::TraversalCost;
+	}
+
+	node.BoundsMin = bounds.Min;
+	node.BoundsMax = bounds.Max;
+	return bounds;
+}
+
+// 子树的叶节点图元在 m_PrimitiveIndices 中连续，返回子树节点数
+uint32_t BVH::GetSubtreeRange(uint32_t nodeIndex, uint32_t& first, uint32_t& count) const
+{
+	first = UINT32_MAX;
+	uint32_t last = 0;
+	uint32_t nodeCount = 0;
+
+	uint32_t stack[Utils::MaxDepth];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = nodeIndex;
+	while (stackSize > 0)
+	{
+		const Node& node = m_Nodes[stack[--stackSize]];
+		nodeCount++;
+
+		if (node.IsLeaf())
+		{
+			first = glm::min(first, node.LeftFirst);
+			last = glm::max(last, node.LeftFirst + node.PrimitiveCount);
+		}
+		else
+		{
+			stack[stackSize++] = node.LeftFirst;
+			stack[stackSize++] = node.LeftFirst + 1;
+		}
+	}
+
+	count = last - first;
+	return nodeCount;
+}
+
+// 原地重建子树：根节点索引不变，新节点追加在数组末尾，旧的子孙节点记为废弃
+void BVH::RebuildSubtree(uint32_t nodeIndex, uint32_t depth, const std::vector<Sphere>& spheres)
+{
+	uint32_t first, count;
+	m_UnusedNodeCount += GetSubtreeRange(nodeIndex, first, count) - 1;
+
+	BuildContext context;
+	context.BinCount = Utils::GetBinCount(m_Quality);
+	context.Multithreaded = m_Multithreaded;
+	context.MaxTaskDepth = depth + Utils::GetTaskDepth();
+	context.FirstPrimitive = first;
+
+	context.References.resize(count);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t index = m_PrimitiveIndices[first + i];
+		context.References[i] = { Utils::SphereBounds(spheres[index]), spheres[index].Position, index };
+	}
+
+	uint32_t oldNodeCount = m_NodeCount;
+	m_Nodes.resize(oldNodeCount + count * 2 - 2);
+	context.NodeCount = oldNodeCount;
+
+	Node& node = m_Nodes[nodeIndex];
+	node.LeftFirst = first;
+	node.PrimitiveCount = count;
+	UpdateNodeBounds(node, context, false);
+
+	BuildNode(nodeIndex, depth, context);
+
+	m_NodeCount = context.NodeCount;
+	m_Nodes.resize(m_NodeCount);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t index = context.References[i].Index;
+		const Sphere& sphere = spheres[index];
+		m_PrimitiveIndices[first + i] = index;
+		m_PrimitiveData[first + i] = glm::vec4(sphere.Position, sphere.Radius * sphere.Radius);
+	}
+
+	m_BuildAreas.resize(m_NodeCount);
+	m_BuildAreas[nodeIndex] = m_Nodes[nodeIndex].GetBounds().GetSurfaceArea();
+	for (uint32_t i = oldNodeCount; i < m_NodeCount; i++)
+		m_BuildAreas[i] = m_Nodes[i].GetBounds().GetSurfaceArea();
+}
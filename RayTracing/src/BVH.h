@@ -0,0 +1,106 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "AABB.h"
+#include "Ray.h"
+#include "Scene.h"
+
+// 基于表面积启发式（SAH）构建的球体层次包围盒
+class BVH
+{
+public:
+	// 构建质量与构建速度的取舍
+	enum class BuildQuality
+	{
+		Fast = 0, // 8 个分箱
+		Balanced, // 32 个分箱
+		High      // 按质心排序后扫描全部划分位置
+	};
+
+	struct Node
+	{
+		glm::vec3 BoundsMin;
+		uint32_t LeftFirst = 0; // 内部节点为左子节点索引（右子节点紧随其后），叶节点为第一个图元索引
+		glm::vec3 BoundsMax;
+		uint32_t PrimitiveCount = 0; // 为 0 表示内部节点
+
+		bool IsLeaf() const { return PrimitiveCount > 0; }
+		AABB GetBounds() const
+		{
+			AABB bounds;
+			bounds.Min = BoundsMin;
+			bounds.Max = BoundsMax;
+			return bounds;
+		}
+	};
+
+	// 图元移动但数量不变时实际采取的更新方式
+	enum class UpdateType
+	{
+		Refit = 0,      // 只更新节点包围盒
+		PartialRebuild, // 重建劣化的子树
+		Rebuild
+	};
+
+	BVH() = default;
+
+	// 多线程时节点内部并行分箱与划分，足够大的子树作为独立任务构建
+	void Build(const std::vector<Sphere>& spheres, BuildQuality quality = BuildQuality::Balanced, bool multithreaded = true);
+	void Clear();
+
+	// 保持树结构只更新包围盒；SAH 代价劣化超过构建时的 threshold 倍时，重建包围盒膨胀超过该倍数的最高层子树
+	UpdateType Refit(const std::vector<Sphere>& spheres, float threshold = 1.5f);
+
+	// 与 Renderer::TraceRay 的暴力求交结果一致：返回最近的 t > 0 交点
+	bool Intersect(const Ray& ray, float& hitDistance, int& objectIndex) const;
+	// 整组光线一起遍历：只要有一条光线与节点相交就进入该节点，叶内对整组光线 SIMD 求交
+	void IntersectPacket(const RayPacket& packet, RayPacketHit& hit) const;
+
+	bool IsEmpty() const { return m_Nodes.empty(); }
+	uint32_t GetNodeCount() const { return m_NodeCount - m_UnusedNodeCount; }
+	uint32_t GetPrimitiveCount() const { return (uint32_t)m_PrimitiveIndices.size(); }
+	float GetBuildTime() const { return m_BuildTime; }
+	float GetUpdateTime() const { return m_UpdateTime; }
+	UpdateType GetLastUpdateType() const { return m_LastUpdateType; }
+	float GetSAHCost() const;
+	size_t GetNodeMemory() const { return m_NodeCount * sizeof(Node); }
+
+	const std::vector<Node>& GetNodes() const { return m_Nodes; }
+	const std::vector<uint32_t>& GetPrimitiveIndices() const { return m_PrimitiveIndices; }
+	const std::vector<glm::vec4>& GetPrimitiveData() const { return m_PrimitiveData; }
+private:
+	struct BuildContext;
+	struct Split;
+
+	void BuildNode(uint32_t nodeIndex, uint32_t depth, BuildContext& context);
+	void UpdateNodeBounds(Node& node, const BuildContext& context, bool parallel);
+	bool FindBinnedSplit(const Node& node, const BuildContext& context, bool parallel, Split& split);
+	bool FindSweepSplit(const Node& node, const BuildContext& context, bool parallel, Split& split);
+	uint32_t Partition(const Node& node, BuildContext& context, bool parallel, const Split& split);
+
+	AABB RefitNode(uint32_t nodeIndex, float& cost);
+	void RebuildSubtree(uint32_t nodeIndex, uint32_t depth, const std::vector<Sphere>& spheres);
+	uint32_t GetSubtreeRange(uint32_t nodeIndex, uint32_t& first, uint32_t& count) const;
+private:
+	std::vector<Node> m_Nodes;
+	uint32_t m_NodeCount = 0;
+	// 局部重建后不再被引用的旧节点
+	uint32_t m_UnusedNodeCount = 0;
+
+	BuildQuality m_Quality = BuildQuality::Balanced;
+	bool m_Multithreaded = true;
+
+	// 构建（或局部重建）时各节点的表面积与整棵树的 SAH 代价，作为衡量 Refit 后质量劣化的基准
+	std::vector<float> m_BuildAreas;
+	float m_BuildSAHCost = 0.0f;
+
+	// 按叶节点顺序排列的图元索引与球体数据（xyz = 球心，w = 半径平方），叶内求交为连续访存
+	std::vector<uint32_t> m_PrimitiveIndices;
+	std::vector<glm::vec4> m_PrimitiveData;
+
+	float m_BuildTime = 0.0f;
+	float m_UpdateTime = 0.0f;
+	UpdateType m_LastUpdateType = UpdateType::Rebuild;
+};
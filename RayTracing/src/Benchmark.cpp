@@ -0,0 +1,1280 @@
+#include "Benchmark.h"
+
+#include "BVH.h"
+#include "Camera.h"
+#include "Grid.h"
+#include "Renderer.h"
+#include "SpaceFillingCurve.h"
+#include "SphereArray.h"
+#include "ThreadPool.h"
+#include "TileCuller.h"
+#include "VisibilityBuffer.h"
+#include "WideBVH.h"
+
+#include "Walnut/Timer.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <execution>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <thread>
+
+namespace Utils
+{
+	static void Report(std::string& output, const char* format, ...)
+	{
+		char line[256];
+
+		va_list args;
+		va_start(args, format);
+		vsnprintf(line, sizeof(line), format, args);
+		va_end(args);
+
+		std::cout << "[BENCH] " << line << "\n";
+		output += line;
+		output += "\n";
+	}
+
+	// 起点均匀分布在场景包围盒内、方向均匀分布的随机光线
+	static std::vector<Ray> GenerateRandomRays(const std::vector<Sphere>& spheres, uint32_t count, uint32_t seed)
+	{
+		AABB bounds;
+		for (const Sphere& sphere : spheres)
+			bounds.Grow(sphere.Position);
+
+		std::mt19937 engine(seed);
+		std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+
+		std::vector<Ray> rays(count);
+		for (Ray& ray : rays)
+		{
+			ray.Origin = bounds.Min + bounds.GetExtent() * glm::vec3(distribution(engine), distribution(engine), distribution(engine));
+
+			glm::vec3 direction;
+			do
+			{
+				direction = glm::vec3(distribution(engine), distribution(engine), distribution(engine)) * 2.0f - 1.0f;
+			} while (glm::dot(direction, direction) > 1.0f || glm::dot(direction, direction) < 1e-4f);
+			ray.Direction = glm::normalize(direction);
+		}
+
+		return rays;
+	}
+
+	// 从场景包围盒外一点沿 +z 看向场景中心的针孔相机
+	struct PinholeCamera
+	{
+		glm::vec3 Origin;
+		float TanHalfFov;
+		uint32_t Width, Height;
+
+		PinholeCamera(const std::vector<Sphere>& spheres, uint32_t width, uint32_t height)
+			: Width(width), Height(height)
+		{
+			AABB bounds;
+			for (const Sphere& sphere : spheres)
+				bounds.Grow(sphere.Position);
+
+			Origin = bounds.GetCenter() - glm::vec3(0.0f, 0.0f, glm::length(bounds.GetExtent()) + 1.0f);
+			TanHalfFov = glm::tan(glm::radians(22.5f));
+		}
+
+		// 像素中心 ((x + 0.5) / Width * 2 - 1, (y + 0.5) / Height * 2 - 1) 对应的方向，与 Camera 一样按增量生成
+		PrimaryRayGenerator GetPrimaryRays() const
+		{
+			float aspect = (float)Width / (float)Height;
+			PrimaryRayGenerator rays;
+			rays.Origin = Origin;
+			rays.Base = { (1.0f / Width - 1.0f) * TanHalfFov * aspect, (1.0f / Height - 1.0f) * TanHalfFov, 1.0f };
+			rays.StepX = { 2.0f / Width * TanHalfFov * aspect, 0.0f, 0.0f };
+			rays.StepY = { 0.0f, 2.0f / Height * TanHalfFov, 0.0f };
+			return rays;
+		}
+
+		glm::vec3 GetDirection(uint32_t x, uint32_t y) const
+		{
+			return GetPrimaryRays().GetDirection((float)x, (float)y);
+		}
+
+		// 与 GetDirection 对应的裁剪空间变换（w 为沿 +z 的深度），供屏幕空间投影使用；像素中心的半像素偏移由投影的余量覆盖
+		glm::mat4 GetViewProjection() const
+		{
+			float aspect = (float)Width / (float)Height;
+			glm::mat4 projection{ 0.0f };
+			projection[0][0] = 1.0f / (TanHalfFov * aspect);
+			projection[1][1] = 1.0f / TanHalfFov;
+			projection[2][2] = 1.0f;
+			projection[2][3] = 1.0f;
+			return projection * glm::translate(glm::mat4(1.0f), -Origin);
+		}
+	};
+
+	// 主光线按 4x2 像素分组
+	static std::vector<RayPacket> GenerateCameraPackets(const std::vector<Sphere>& spheres, uint32_t width, uint32_t height)
+	{
+		PinholeCamera camera(spheres, width, height);
+
+		std::vector<RayPacket> packets((width / 4) * (height / 2));
+		for (uint32_t packetY = 0; packetY < height / 2; packetY++)
+		{
+			for (uint32_t packetX = 0; packetX < width / 4; packetX++)
+			{
+				RayPacket& packet = packets[packetX + packetY * (width / 4)];
+				packet.Origin = camera.Origin;
+				for (uint32_t lane = 0; lane < RayPacket::Width; lane++)
+				{
+					glm::vec3 direction = camera.GetDirection(packetX * 4 + lane % 4, packetY * 2 + lane / 4);
+					packet.DirectionX[lane] = direction.x;
+					packet.DirectionY[lane] = direction.y;
+					packet.DirectionZ[lane] = direction.z;
+				}
+			}
+		}
+
+		return packets;
+	}
+
+	// 两幅 RGBA8 图像 RGB 通道的均方根误差
+	static float ImageRMSE(const uint32_t* image, const std::vector<uint32_t>& reference)
+	{
+		double error = 0.0;
+		for (size_t i = 0; i < reference.size(); i++)
+		{
+			for (uint32_t channel = 0; channel < 3; channel++)
+			{
+				double difference = (double)((image[i] >> (channel * 8)) & 0xff) - (double)((reference[i] >> (channel * 8)) & 0xff);
+				error += difference * difference;
+			}
+		}
+		return (float)glm::sqrt(error / (reference.size() * 3));
+	}
+
+	// 模拟 Renderer::PerPixel 的负载：主光线加两次漫反射弹射，结果累加到像素
+	static void TracePath(const BVH& bvh, const std::vector<Sphere>& spheres, const PinholeCamera& camera, uint32_t x, uint32_t y, glm::vec4& pixel)
+	{
+		Ray ray{ camera.Origin, camera.GetDirection(x, y) };
+		uint32_t seed = x * 1973 + y * 9277 + 1;
+
+		glm::vec3 light{ 0.0f };
+		for (int bounce = 0; bounce < 3; bounce++)
+		{
+			float hitDistance = FLT_MAX;
+			int objectIndex = -1;
+			if (!bvh.Intersect(ray, hitDistance, objectIndex))
+			{
+				light += glm::vec3(0.6f, 0.7f, 0.9f);
+				break;
+			}
+
+			glm::vec3 position = ray.Origin + ray.Direction * hitDistance;
+			glm::vec3 normal = glm::normalize(position - spheres[objectIndex].Position);
+
+			glm::vec3 random;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				seed = seed * 747796405u + 2891336453u;
+				random[axis] = (float)(seed >> 8) / (float)(1u << 24) * 2.0f - 1.0f;
+			}
+
+			ray.Origin = position + normal * 0.0001f;
+			ray.Direction = glm::normalize(normal + glm::normalize(random));
+		}
+
+		pixel += glm::vec4(light, 1.0f);
+	}
+
+	// 原 Renderer::TraceRay 的暴力求交：逐个按值拷贝球体，每次重新计算 a 与半径平方
+	static bool IntersectScalar(const std::vector<Sphere>& spheres, const Ray& ray, float& hitDistance, int& objectIndex)
+	{
+		bool hit = false;
+		for (size_t i = 0; i < spheres.size(); i++)
+		{
+			Sphere sphere = spheres[i];
+
+			glm::vec3 origin = ray.Origin - sphere.Position;
+
+			float a = glm::dot(ray.Direction, ray.Direction);
+			float b = 2.0f * glm::dot(origin, ray.Direction);
+			float c = glm::dot(origin, origin) - sphere.Radius * sphere.Radius;
+
+			float discriminant = b * b - 4.0f * a * c;
+			if (discriminant < 0.0f)
+				continue;
+
+			float tclose = (-b - glm::sqrt(discriminant)) / (2.0f * a);
+			if (tclose < hitDistance && tclose > 0.0f)
+			{
+				hitDistance = tclose;
+				objectIndex = (int)i;
+				hit = true;
+			}
+		}
+		return hit;
+	}
+
+	// 并行追踪所有光线，返回耗时（毫秒）
+	template<typename Intersector>
+	static float TraceRays(const std::vector<Ray>& rays, std::vector<int>& hits, Intersector intersect)
+	{
+		std::vector<uint32_t> indices(rays.size());
+		std::iota(indices.begin(), indices.end(), 0);
+		hits.resize(rays.size());
+
+		Walnut::Timer timer;
+		std::for_each(std::execution::par, indices.begin(), indices.end(), [&](uint32_t i)
+			{
+				float hitDistance = FLT_MAX;
+				int objectIndex = -1;
+				intersect(rays[i], hitDistance, objectIndex);
+				hits[i] = objectIndex;
+			});
+		return timer.ElapsedMillis();
+	}
+
+	// 地面上方散布 lightCount 个小光源（8 种颜色），照亮地面与三个漫反射球；光源越多半径越小，亮度不变时总功率（亮度 × 表面积之和）保持不变
+	static Scene CreateManyLightScene(uint32_t lightCount)
+	{
+		Scene scene;
+		scene.Materials.resize(9);
+		scene.Materials[0].Albedo = { 0.8f, 0.8f, 0.8f, 1.0f };
+		float lightRadius = 0.3f / glm::sqrt((float)lightCount);
+		std::mt19937 random(lightCount);
+		std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+		for (uint32_t i = 1; i < 9; i++)
+		{
+			scene.Materials[i].EmissionColor = glm::vec3(distribution(random), distribution(random), distribution(random)) * 0.5f + 0.5f;
+			scene.Materials[i].EmissionPower = 300.0f;
+		}
+
+		scene.Sphere.push_back({ { 0.0f, -101.0f, 0.0f }, 100.0f, 0 });
+		scene.Sphere.push_back({ { 0.0f, 0.0f, 0.0f }, 1.0f, 0 });
+		scene.Sphere.push_back({ { -3.0f, -0.2f, -2.0f }, 0.8f, 0 });
+		scene.Sphere.push_back({ { 3.0f, 0.5f, -4.0f }, 1.5f, 0 });
+		for (uint32_t i = 0; i < lightCount; i++)
+		{
+			glm::vec3 position(distribution(random) * 40.0f - 20.0f, -0.9f + distribution(random) * 0.6f, distribution(random) * 40.0f - 30.0f);
+			scene.Sphere.push_back({ position, lightRadius, 1 + (int)(i % 8) });
+		}
+
+		return scene;
+	}
+}
+
+std::vector<Sphere> Benchmark::GenerateRandomSpheres(uint32_t count, float radius, uint32_t seed)
+{
+	std::mt19937 engine(seed);
+	float extent = glm::max(std::cbrt((float)count), 1.0f);
+	std::uniform_real_distribution<float> distribution(-extent, extent);
+
+	std::vector<Sphere> spheres(count);
+	for (Sphere& sphere : spheres)
+	{
+		sphere.Position = { distribution(engine), distribution(engine), distribution(engine) };
+		sphere.Radius = radius;
+	}
+
+	return spheres;
+}
+
+std::string Benchmark::BVHBuild(uint32_t primitiveCount)
+{
+	std::string output;
+
+	std::vector<Sphere> spheres = GenerateRandomSpheres(primitiveCount, 0.25f);
+	float millions = (float)primitiveCount / 1000000.0f;
+
+	Utils::Report(output, "BVH build: %u spheres, %u hardware threads", primitiveCount, std::thread::hardware_concurrency());
+
+	const char* qualityNames[] = { "Fast", "Balanced", "High" };
+	for (int quality = 0; quality < 3; quality++)
+	{
+		BVH bvh;
+
+		// 全扫描构建单线程过慢，只比较分箱构建的加速比
+		float singleThreadTime = 0.0f;
+		if ((BVH::BuildQuality)quality != BVH::BuildQuality::High)
+		{
+			bvh.Build(spheres, (BVH::BuildQuality)quality, false);
+			singleThreadTime = bvh.GetBuildTime();
+		}
+
+		bvh.Build(spheres, (BVH::BuildQuality)quality, true);
+		float time = bvh.GetBuildTime();
+
+		Utils::Report(output, "  %-8s %9.2fms  %9.2fms/M prims  %8u nodes  SAH %.2f",
+			qualityNames[quality], time, time / millions, bvh.GetNodeCount(), bvh.GetSAHCost());
+		if (singleThreadTime > 0.0f)
+			Utils::Report(output, "  %-8s %9.2fms single-threaded, %.2fx speedup", "", singleThreadTime, singleThreadTime / time);
+	}
+
+	return output;
+}
+
+std::string Benchmark::BVHTraversal(uint32_t primitiveCount, uint32_t rayCount)
+{
+	std::string output;
+
+	std::vector<Sphere> spheres = GenerateRandomSpheres(primitiveCount, 0.25f);
+	std::vector<Ray> rays = Utils::GenerateRandomRays(spheres, rayCount, 2);
+
+	BVH bvh;
+	bvh.Build(spheres);
+	WideBVH wideBVH;
+	wideBVH.Build(bvh);
+
+	Utils::Report(output, "BVH traversal: %u spheres, %u random rays", primitiveCount, rayCount);
+
+	std::vector<int> binaryHits, wideHits;
+	float binaryTime = Utils::TraceRays(rays, binaryHits, [&bvh](const Ray& ray, float& t, int& index) { bvh.Intersect(ray, t, index); });
+	float wideTime = Utils::TraceRays(rays, wideHits, [&wideBVH](const Ray& ray, float& t, int& index) { wideBVH.Intersect(ray, t, index); });
+
+	uint32_t mismatches = 0;
+	for (uint32_t i = 0; i < rayCount; i++)
+		mismatches += binaryHits[i] != wideHits[i];
+
+	Utils::Report(output, "  Binary  %8u nodes  %6.1f bytes/prim  %8.2fms  %7.2f Mrays/s",
+		bvh.GetNodeCount(), (float)bvh.GetNodeMemory() / primitiveCount, binaryTime, rayCount / (binaryTime * 1000.0f));
+	Utils::Report(output, "  Wide    %8u nodes  %6.1f bytes/prim  %8.2fms  %7.2f Mrays/s",
+		wideBVH.GetNodeCount(), (float)wideBVH.GetNodeMemory() / primitiveCount, wideTime, rayCount / (wideTime * 1000.0f));
+	Utils::Report(output, "  %u of %u closest hits differ", mismatches, rayCount);
+
+	return output;
+}
+
+std::string Benchmark::BVHRefit(uint32_t primitiveCount, uint32_t frameCount)
+{
+	std::string output;
+
+	std::vector<Sphere> spheres = GenerateRandomSpheres(primitiveCount, 0.25f);
+
+	BVH bvh;
+	bvh.Build(spheres);
+	float buildTime = bvh.GetBuildTime();
+	float buildCost = bvh.GetSAHCost();
+
+	Utils::Report(output, "BVH refit: %u spheres, %u frames, full build %.2fms, SAH %.2f", primitiveCount, frameCount, buildTime, buildCost);
+
+	std::mt19937 engine(3);
+	std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+	const char* updateNames[] = { "refit", "partial", "rebuild" };
+	auto runFrames = [&](const char* name, auto&& animate)
+	{
+		uint32_t updateCounts[3] = {};
+		float totalTime = 0.0f, maxTime = 0.0f;
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			animate();
+			BVH::UpdateType type = bvh.Refit(spheres);
+			updateCounts[(int)type]++;
+			totalTime += bvh.GetUpdateTime();
+			maxTime = glm::max(maxTime, bvh.GetUpdateTime());
+		}
+
+		Utils::Report(output, "  %-8s avg %9.1fus  max %9.1fus  SAH %.2f  (%u %s, %u %s, %u %s)",
+			name, totalTime * 1000.0f / frameCount, maxTime * 1000.0f, bvh.GetSAHCost(),
+			updateCounts[0], updateNames[0], updateCounts[1], updateNames[1], updateCounts[2], updateNames[2]);
+	};
+
+	// 交互编辑：每帧拖动同一个球体
+	runFrames("Edit", [&]()
+		{
+			spheres[0].Position += glm::vec3(0.1f, 0.0f, 0.0f);
+		});
+
+	// 动画：所有球体每帧随机游走
+	runFrames("Animate", [&]()
+		{
+			for (Sphere& sphere : spheres)
+				sphere.Position += glm::vec3(distribution(engine), distribution(engine), distribution(engine)) * 0.05f;
+		});
+
+	return output;
+}
+
+std::string Benchmark::SphereKernel(uint32_t rayCount)
+{
+	std::string output;
+
+	Utils::Report(output, "Sphere kernel: brute-force closest hit, %u rays", rayCount);
+
+	for (uint32_t sphereCount : { 8u, 64u, 1024u })
+	{
+		std::vector<Sphere> spheres = GenerateRandomSpheres(sphereCount, 0.25f);
+		// 测试数固定在约 1 亿次左右
+		uint32_t count = glm::max(glm::min(rayCount, 100000000u / sphereCount), 1u);
+		std::vector<Ray> rays = Utils::GenerateRandomRays(spheres, count, 2);
+
+		SphereArray sphereArray;
+		sphereArray.Update(spheres);
+
+		std::vector<int> scalarHits, simdHits;
+		float scalarTime = Utils::TraceRays(rays, scalarHits, [&spheres](const Ray& ray, float& t, int& index) { Utils::IntersectScalar(spheres, ray, t, index); });
+		float simdTime = Utils::TraceRays(rays, simdHits, [&sphereArray](const Ray& ray, float& t, int& index) { sphereArray.Intersect(ray, t, index); });
+
+		uint32_t mismatches = 0;
+		for (uint32_t i = 0; i < count; i++)
+			mismatches += scalarHits[i] != simdHits[i];
+
+		float tests = (float)count * sphereCount;
+		Utils::Report(output, "  %5u spheres  scalar %8.2fms %8.1f Mtests/s  SoA %8.2fms %8.1f Mtests/s  %.2fx  (%u hits differ)",
+			sphereCount, scalarTime, tests / (scalarTime * 1000.0f), simdTime, tests / (simdTime * 1000.0f), scalarTime / simdTime, mismatches);
+	}
+
+	return output;
+}
+
+std::string Benchmark::PacketTracing(uint32_t width, uint32_t height)
+{
+	std::string output;
+
+	Utils::Report(output, "Packet tracing: %ux%u primary rays, 4x2 packets", width, height);
+
+	for (uint32_t sphereCount : { 64u, 100000u })
+	{
+		std::vector<Sphere> spheres = GenerateRandomSpheres(sphereCount, sphereCount > 1000 ? 0.25f : 1.0f);
+		std::vector<RayPacket> packets = Utils::GenerateCameraPackets(spheres, width, height);
+		uint32_t rayCount = (uint32_t)packets.size() * RayPacket::Width;
+
+		SphereArray sphereArray;
+		sphereArray.Update(spheres);
+		BVH bvh;
+		bvh.Build(spheres);
+
+		auto traceSingle = [&](auto&& intersect, std::vector<int>& hits)
+		{
+			hits.resize(rayCount);
+			Walnut::Timer timer;
+			std::for_each(std::execution::par, packets.begin(), packets.end(), [&](const RayPacket& packet)
+				{
+					uint32_t first = (uint32_t)(&packet - packets.data()) * RayPacket::Width;
+					for (uint32_t lane = 0; lane < RayPacket::Width; lane++)
+					{
+						float hitDistance = FLT_MAX;
+						int objectIndex = -1;
+						intersect(packet.GetRay(lane), hitDistance, objectIndex);
+						hits[first + lane] = objectIndex;
+					}
+				});
+			return timer.ElapsedMillis();
+		};
+		auto tracePacket = [&](auto&& intersect, std::vector<int>& hits)
+		{
+			hits.resize(rayCount);
+			Walnut::Timer timer;
+			std::for_each(std::execution::par, packets.begin(), packets.end(), [&](const RayPacket& packet)
+				{
+					RayPacketHit hit;
+					for (uint32_t lane = 0; lane < RayPacket::Width; lane++)
+					{
+						hit.HitDistance[lane] = FLT_MAX;
+						hit.ObjectIndex[lane] = -1;
+					}
+					intersect(packet, hit);
+
+					uint32_t first = (uint32_t)(&packet - packets.data()) * RayPacket::Width;
+					for (uint32_t lane = 0; lane < RayPacket::Width; lane++)
+						hits[first + lane] = hit.ObjectIndex[lane];
+				});
+			return timer.ElapsedMillis();
+		};
+
+		std::vector<int> singleHits, packetHits;
+		auto report = [&](const char* name, float singleTime, float packetTime)
+		{
+			uint32_t mismatches = 0;
+			for (uint32_t i = 0; i < rayCount; i++)
+				mismatches += singleHits[i] != packetHits[i];
+
+			Utils::Report(output, "  %6u spheres %-6s single %8.2fms %7.2f Mrays/s  packet %8.2fms %7.2f Mrays/s  %.2fx  (%u hits differ)",
+				sphereCount, name, singleTime, rayCount / (singleTime * 1000.0f), packetTime, rayCount / (packetTime * 1000.0f), singleTime / packetTime, mismatches);
+		};
+
+		if (sphereCount <= 1000)
+		{
+			float singleTime = traceSingle([&](const Ray& ray, float& t, int& index) { sphereArray.Intersect(ray, t, index); }, singleHits);
+			float packetTime = tracePacket([&](const RayPacket& packet, RayPacketHit& hit) { sphereArray.IntersectPacket(packet, hit); }, packetHits);
+			report("None", singleTime, packetTime);
+		}
+
+		float singleTime = traceSingle([&](const Ray& ray, float& t, int& index) { bvh.Intersect(ray, t, index); }, singleHits);
+		float packetTime = tracePacket([&](const RayPacket& packet, RayPacketHit& hit) { bvh.IntersectPacket(packet, hit); }, packetHits);
+		report("BVH", singleTime, packetTime);
+	}
+
+	return output;
+}
+
+std::string Benchmark::ThreadScaling(uint32_t width, uint32_t height)
+{
+	std::string output;
+
+	std::vector<Sphere> spheres = GenerateRandomSpheres(100000, 0.25f);
+	BVH bvh;
+	bvh.Build(spheres);
+
+	Utils::PinholeCamera camera(spheres, width, height);
+	std::vector<glm::vec4> accumulation(width * height);
+
+	uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	Utils::Report(output, "Thread scaling: %ux%u, 100000 spheres, 3 bounces, %u hardware threads", width, height, hardwareThreads);
+
+	// 原调度方式：行与列两层 std::for_each(par)，每个像素一个任务
+	std::vector<uint32_t> horizontalIterator(width), verticalIterator(height);
+	std::iota(horizontalIterator.begin(), horizontalIterator.end(), 0);
+	std::iota(verticalIterator.begin(), verticalIterator.end(), 0);
+
+	Walnut::Timer timer;
+	std::for_each(std::execution::par, verticalIterator.begin(), verticalIterator.end(), [&](uint32_t y)
+		{
+			std::for_each(std::execution::par, horizontalIterator.begin(), horizontalIterator.end(), [&](uint32_t x)
+				{
+					Utils::TracePath(bvh, spheres, camera, x, y, accumulation[x + y * width]);
+				});
+		});
+	float perPixelTime = timer.ElapsedMillis();
+	Utils::Report(output, "  for_each(par) per pixel   %9.2fms", perPixelTime);
+
+	const uint32_t tileSize = 32;
+	uint32_t tileCountX = (width + tileSize - 1) / tileSize;
+	uint32_t tileCountY = (height + tileSize - 1) / tileSize;
+
+	float singleThreadTime = 0.0f;
+	for (uint32_t threadCount = 1; ; threadCount = std::min(threadCount * 2, hardwareThreads))
+	{
+		ThreadPool pool(threadCount);
+
+		timer.Reset();
+		pool.ParallelFor(tileCountX * tileCountY, [&](uint32_t tileIndex, uint32_t threadIndex)
+			{
+				uint32_t minX = tileIndex % tileCountX * tileSize;
+				uint32_t minY = tileIndex / tileCountX * tileSize;
+				for (uint32_t y = minY; y < std::min(minY + tileSize, height); y++)
+					for (uint32_t x = minX; x < std::min(minX + tileSize, width); x++)
+						Utils::TracePath(bvh, spheres, camera, x, y, accumulation[x + y * width]);
+			});
+		float time = timer.ElapsedMillis();
+		if (threadCount == 1)
+			singleThreadTime = time;
+
+		Utils::Report(output, "  tiles 32x32, %3u threads  %9.2fms  %5.2fx speedup  %5.1f%% efficiency  %u stolen",
+			threadCount, time, singleThreadTime / time, 100.0f * singleThreadTime / time / threadCount, pool.GetStealCount());
+
+		if (threadCount == hardwareThreads)
+			break;
+	}
+
+	return output;
+}
+
+std::string Benchmark::PixelOrder(uint32_t width, uint32_t height)
+{
+	std::string output;
+
+	std::vector<Sphere> spheres = GenerateRandomSpheres(100000, 0.25f);
+	BVH bvh;
+	bvh.Build(spheres);
+
+	Utils::PinholeCamera camera(spheres, width, height);
+	std::vector<glm::vec4> accumulation(width * height);
+
+	const uint32_t tileSize = 32;
+	uint32_t tileCountX = (width + tileSize - 1) / tileSize;
+	uint32_t tileCountY = (height + tileSize - 1) / tileSize;
+
+	ThreadPool pool;
+	Utils::Report(output, "Pixel order: %ux%u, 100000 spheres, 3 bounces, tiles 32x32, %u threads", width, height, pool.GetThreadCount());
+
+	const char* names[] = { "row major", "Morton", "Hilbert" };
+	for (int tileType = 0; tileType < 3; tileType++)
+	{
+		std::vector<glm::uvec2> tileOrder = SpaceFillingCurve::GenerateOrder(tileCountX, tileCountY, (SpaceFillingCurve::Type)tileType);
+		for (int pixelType = 0; pixelType < 3; pixelType++)
+		{
+			std::vector<glm::uvec2> pixelOrder = SpaceFillingCurve::GenerateOrder(tileSize, tileSize, (SpaceFillingCurve::Type)pixelType);
+
+			Walnut::Timer timer;
+			pool.ParallelFor(tileCountX * tileCountY, [&](uint32_t taskIndex, uint32_t threadIndex)
+				{
+					uint32_t minX = tileOrder[taskIndex].x * tileSize;
+					uint32_t minY = tileOrder[taskIndex].y * tileSize;
+					for (const glm::uvec2& pixel : pixelOrder)
+					{
+						uint32_t x = minX + pixel.x;
+						uint32_t y = minY + pixel.y;
+						if (x < width && y < height)
+							Utils::TracePath(bvh, spheres, camera, x, y, accumulation[x + y * width]);
+					}
+				});
+			Utils::Report(output, "  tiles %-9s  pixels %-9s  %9.2fms", names[tileType], names[pixelType], timer.ElapsedMillis());
+		}
+	}
+
+	return output;
+}
+
+std::string Benchmark::PrimaryVisibility(uint32_t width, uint32_t height)
+{
+	std::string output;
+
+	ThreadPool pool;
+	const uint32_t tileSize = 32;
+	Utils::Report(output, "Primary visibility: %ux%u, tiles 32x32, %u threads", width, height, pool.GetThreadCount());
+
+	for (uint32_t sphereCount : { 1000u, 100000u })
+	{
+		std::vector<Sphere> spheres = GenerateRandomSpheres(sphereCount, 0.25f);
+		BVH bvh;
+		bvh.Build(spheres);
+
+		Utils::PinholeCamera camera(spheres, width, height);
+		PrimaryRayGenerator rays = camera.GetPrimaryRays();
+
+		auto tracePrimary = [&](auto&& intersect, std::vector<int>& hits)
+		{
+			hits.resize(width * height);
+			Walnut::Timer timer;
+			pool.ParallelFor(height, [&](uint32_t y, uint32_t threadIndex)
+				{
+					for (uint32_t x = 0; x < width; x++)
+					{
+						float hitDistance = FLT_MAX;
+						int objectIndex = -1;
+						intersect(x, y, rays.GetRay((float)x, (float)y), hitDistance, objectIndex);
+						hits[x + y * width] = objectIndex;
+					}
+				});
+			return timer.ElapsedMillis();
+		};
+
+		std::vector<int> bvhHits, culledHits, bufferHits(width * height);
+		float bvhTime = tracePrimary([&](uint32_t x, uint32_t y, const Ray& ray, float& t, int& index) { bvh.Intersect(ray, t, index); }, bvhHits);
+
+		TileCuller culler;
+		culler.Build(pool, spheres, camera.GetViewProjection(), width, height, tileSize);
+		float cullTime = culler.GetBuildTime();
+		float culledTime = tracePrimary([&](uint32_t x, uint32_t y, const Ray& ray, float& t, int& index)
+			{
+				culler.Intersect(culler.GetTileIndex(x, y), ray, t, index);
+			}, culledHits);
+
+		VisibilityBuffer visibilityBuffer;
+		visibilityBuffer.Build(pool, culler, rays, width, height);
+		float rasterTime = visibilityBuffer.GetBuildTime();
+
+		uint32_t culledMismatches = 0, bufferMismatches = 0;
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				float hitDistance;
+				int objectIndex;
+				visibilityBuffer.GetHit(x, y, hitDistance, objectIndex);
+				culledMismatches += culledHits[x + y * width] != bvhHits[x + y * width];
+				bufferMismatches += objectIndex != bvhHits[x + y * width];
+			}
+		}
+
+		Utils::Report(output, "  %6u spheres  BVH traced %8.2fms  culled traced %8.2fms + %.2fms binning  raster %8.2fms + %.2fms binning  (%u / %u hits differ)",
+			sphereCount, bvhTime, culledTime, cullTime, rasterTime, cullTime, culledMismatches, bufferMismatches);
+	}
+
+	return output;
+}
+
+std::string Benchmark::GridVsBVH(uint32_t rayCount, uint32_t frameCount)
+{
+	std::string output;
+
+	Utils::Report(output, "Dynamic scene: %u rays, %u frames, all spheres moving", rayCount, frameCount);
+
+	for (uint32_t primitiveCount : { 10000u, 100000u, 1000000u })
+	{
+		std::vector<Sphere> spheres = GenerateRandomSpheres(primitiveCount, 0.25f);
+		std::vector<Ray> rays = Utils::GenerateRandomRays(spheres, rayCount, 2);
+
+		std::mt19937 engine(3);
+		std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+		BVH bvh;
+		Grid grid;
+		float bvhBuildTime = 0.0f, bvhTraceTime = 0.0f;
+		float gridBuildTime = 0.0f, gridTraceTime = 0.0f;
+		uint32_t mismatches = 0;
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			for (Sphere& sphere : spheres)
+				sphere.Position += glm::vec3(distribution(engine), distribution(engine), distribution(engine)) * 0.05f;
+
+			bvh.Build(spheres, BVH::BuildQuality::Fast);
+			bvhBuildTime += bvh.GetBuildTime();
+			grid.Build(spheres);
+			gridBuildTime += grid.GetBuildTime();
+
+			std::vector<int> bvhHits, gridHits;
+			bvhTraceTime += Utils::TraceRays(rays, bvhHits, [&bvh](const Ray& ray, float& t, int& index) { bvh.Intersect(ray, t, index); });
+			gridTraceTime += Utils::TraceRays(rays, gridHits, [&grid](const Ray& ray, float& t, int& index) { grid.Intersect(ray, t, index); });
+
+			for (uint32_t i = 0; i < rayCount; i++)
+				mismatches += bvhHits[i] != gridHits[i];
+		}
+
+		glm::ivec3 resolution = grid.GetResolution();
+		Utils::Report(output, "  %u spheres, grid %dx%dx%d, %.2f refs/sphere", primitiveCount,
+			resolution.x, resolution.y, resolution.z, (float)grid.GetReferenceCount() / primitiveCount);
+		Utils::Report(output, "    BVH   build %9.2fms  trace %9.2fms  total %9.2fms/frame",
+			bvhBuildTime / frameCount, bvhTraceTime / frameCount, (bvhBuildTime + bvhTraceTime) / frameCount);
+		Utils::Report(output, "    Grid  build %9.2fms  trace %9.2fms  total %9.2fms/frame",
+			gridBuildTime / frameCount, gridTraceTime / frameCount, (gridBuildTime + gridTraceTime) / frameCount);
+		Utils::Report(output, "    %u of %u closest hits differ", mismatches, rayCount * frameCount);
+	}
+
+	return output;
+}
+
+std::string Benchmark::AdaptiveSampling(uint32_t width, uint32_t height, uint32_t referenceFrames)
+{
+	std::string output;
+
+	// 地面、两个漫反射球与一个发光球
+	Scene scene;
+	scene.Materials.resize(3);
+	scene.Materials[0].Albedo = { 1.0f, 0.0f, 1.0f, 1.0f };
+	scene.Materials[1].Albedo = { 0.2f, 0.3f, 1.0f, 1.0f };
+	scene.Materials[2].Albedo = { 0.8f, 0.5f, 0.2f, 1.0f };
+	scene.Materials[2].EmissionColor = scene.Materials[2].Albedo;
+	scene.Materials[2].EmissionPower = 2.0f;
+	scene.Sphere.push_back({ { 0.0f, 0.0f, 0.0f }, 1.0f, 0 });
+	scene.Sphere.push_back({ { 2.0f, 0.0f, 0.0f }, 1.0f, 2 });
+	scene.Sphere.push_back({ { -2.0f, -0.5f, -1.0f }, 0.5f, 1 });
+	scene.Sphere.push_back({ { 0.0f, -101.0f, 0.0f }, 100.0f, 1 });
+
+	Camera camera(45.0f, 0.1f, 100.0f);
+	camera.OnResize(width, height);
+
+	auto createRenderer = [&](bool adaptive)
+	{
+		auto renderer = std::make_unique<Renderer>();
+		Renderer::Settings& settings = renderer->GetSettings();
+		settings.AdaptiveSampling = adaptive;
+		settings.AOVs.SampleCount = true;
+		settings.DynamicResolution = false;
+		renderer->OnResize(width, height);
+		return renderer;
+	};
+
+	auto averageSamples = [&](const Renderer& renderer)
+	{
+		const uint32_t* sampleCounts = renderer.GetSampleCountAOV();
+		uint64_t totalSamples = 0;
+		for (uint32_t pixel = 0; pixel < width * height; pixel++)
+			totalSamples += sampleCounts[pixel];
+		return (float)totalSamples / (width * height);
+	};
+
+	// 参考图逐像素均匀采样，不跳过任何 tile
+	std::vector<uint32_t> reference(width * height);
+	{
+		auto renderer = createRenderer(false);
+		for (uint32_t frame = 0; frame < referenceFrames; frame++)
+			renderer->Render(scene, camera);
+		std::copy_n(renderer->GetImageData(), reference.size(), reference.begin());
+	}
+
+	Utils::Report(output, "Adaptive Sampling: %ux%u, threshold %.3f, reference %u spp with uniform sampling, %u threads", width, height,
+		Renderer::Settings().AdaptiveThreshold, referenceFrames, createRenderer(false)->GetThreadCount());
+
+	// 平均采样数至多取参考图的 1/4，避免与参考图共用过多采样；只计渲染本身的耗时
+	const uint32_t maxSamples = referenceFrames / 4;
+	auto imageError = [&](const Renderer& renderer) { return Utils::ImageRMSE(renderer.GetImageData(), reference); };
+
+	// 自适应采样渲染到全部 tile 收敛
+	auto adaptive = createRenderer(true);
+	float adaptiveTime = 0.0f;
+	glm::uvec2 tileCount;
+	do
+	{
+		Walnut::Timer timer;
+		adaptive->Render(scene, camera);
+		adaptiveTime += timer.ElapsedMillis();
+		tileCount = adaptive->GetTileCount();
+	} while (adaptive->GetConvergedTileCount() < tileCount.x * tileCount.y && averageSamples(*adaptive) <= maxSamples);
+
+	float error = imageError(*adaptive);
+	Utils::Report(output, "  adaptive  %8.2fms  %7.1f spp on average  RMSE %6.2f  (%u / %u tiles converged)", adaptiveTime, averageSamples(*adaptive),
+		error, adaptive->GetConvergedTileCount(), tileCount.x * tileCount.y);
+
+	// 均匀采样在相同耗时内的误差，以及达到自适应采样误差所需的耗时
+	auto uniform = createRenderer(false);
+	float uniformTime = 0.0f;
+	bool equalTimeReported = false;
+	do
+	{
+		Walnut::Timer timer;
+		uniform->Render(scene, camera);
+		uniformTime += timer.ElapsedMillis();
+
+		if (!equalTimeReported && uniformTime >= adaptiveTime)
+		{
+			equalTimeReported = true;
+			Utils::Report(output, "  uniform   %8.2fms  %7.1f spp on average  RMSE %6.2f  (equal time)", uniformTime, averageSamples(*uniform), imageError(*uniform));
+		}
+	} while (imageError(*uniform) > error && averageSamples(*uniform) < maxSamples);
+	if (imageError(*uniform) <= error)
+		Utils::Report(output, "  uniform   %8.2fms  %7.1f spp on average  RMSE %6.2f  (equal error)", uniformTime, averageSamples(*uniform), imageError(*uniform));
+	else
+		Utils::Report(output, "  uniform does not reach RMSE %.2f within %u spp", error, maxSamples);
+
+	return output;
+}
+
+std::string Benchmark::Reprojection(uint32_t width, uint32_t height, uint32_t historyFrames, uint32_t frameCount, uint32_t referenceFrames)
+{
+	std::string output;
+
+	// 地面、两个漫反射球与一个发光球
+	Scene scene;
+	scene.Materials.resize(3);
+	scene.Materials[0].Albedo = { 1.0f, 0.0f, 1.0f, 1.0f };
+	scene.Materials[1].Albedo = { 0.2f, 0.3f, 1.0f, 1.0f };
+	scene.Materials[2].Albedo = { 0.8f, 0.5f, 0.2f, 1.0f };
+	scene.Materials[2].EmissionColor = scene.Materials[2].Albedo;
+	scene.Materials[2].EmissionPower = 2.0f;
+	scene.Sphere.push_back({ { 0.0f, 0.0f, 0.0f }, 1.0f, 0 });
+	scene.Sphere.push_back({ { 2.0f, 0.0f, 0.0f }, 1.0f, 2 });
+	scene.Sphere.push_back({ { -2.0f, -0.5f, -1.0f }, 0.5f, 1 });
+	scene.Sphere.push_back({ { 0.0f, -101.0f, 0.0f }, 100.0f, 1 });
+
+	// 相机先静止累积 historyFrames 帧，之后每帧沿 x 平移
+	const glm::vec3 cameraPosition(0.0f, 0.0f, 6.0f), cameraDirection(0.0f, 0.0f, -1.0f), cameraStep(0.05f, 0.0f, 0.0f);
+	Camera camera(45.0f, 0.1f, 100.0f);
+	camera.OnResize(width, height);
+	camera.SetView(cameraPosition, cameraDirection);
+	Camera finalCamera = camera;
+	finalCamera.SetView(cameraPosition + (float)frameCount * cameraStep, cameraDirection);
+
+	auto createRenderer = [&](bool reprojection)
+	{
+		auto renderer = std::make_unique<Renderer>();
+		Renderer::Settings& settings = renderer->GetSettings();
+		settings.TemporalReprojection = reprojection;
+		settings.AOVs.SampleCount = true;
+		settings.DynamicResolution = false;
+		renderer->OnResize(width, height);
+		return renderer;
+	};
+
+	// 参考图在最终位置静止累积，不重投影
+	std::vector<uint32_t> reference(width * height);
+	{
+		auto renderer = createRenderer(false);
+		for (uint32_t frame = 0; frame < referenceFrames; frame++)
+			renderer->Render(scene, finalCamera);
+		std::copy_n(renderer->GetImageData(), reference.size(), reference.begin());
+	}
+
+	Utils::Report(output, "Reprojection: %ux%u, %u spp accumulated before the camera pans 0.05 per frame for %u frames, reference %u spp at the final position",
+		width, height, historyFrames, frameCount, referenceFrames);
+
+	// 耗时只计移动中的帧；重投影时平均采样数包含保留下来的历史采样
+	const char* names[] = { "reset", "reprojection" };
+	for (int reprojection = 0; reprojection < 2; reprojection++)
+	{
+		auto renderer = createRenderer(reprojection);
+		Camera view = camera;
+		for (uint32_t frame = 0; frame < historyFrames; frame++)
+			renderer->Render(scene, view);
+
+		float totalTime = 0.0f;
+		for (uint32_t frame = 1; frame <= frameCount; frame++)
+		{
+			view.SetView(cameraPosition + (float)frame * cameraStep, cameraDirection);
+			renderer->OnCameraMoved();
+			Walnut::Timer timer;
+			renderer->Render(scene, view);
+			totalTime += timer.ElapsedMillis();
+		}
+
+		const uint32_t* sampleCounts = renderer->GetSampleCountAOV();
+		uint64_t totalSamples = 0;
+		for (uint32_t pixel = 0; pixel < width * height; pixel++)
+			totalSamples += sampleCounts[pixel];
+		Utils::Report(output, "  %-12s  %8.2fms/frame  RMSE %6.2f  (%.1f spp on average)", names[reprojection], totalTime / frameCount,
+			Utils::ImageRMSE(renderer->GetImageData(), reference), (float)totalSamples / (width * height));
+	}
+
+	return output;
+}
+
+std::string Benchmark::Checkerboard(uint32_t width, uint32_t height, uint32_t frameCount, uint32_t referenceFrames)
+{
+	std::string output;
+
+	// 地面、两个漫反射球与一个发光球
+	Scene scene;
+	scene.Materials.resize(3);
+	scene.Materials[0].Albedo = { 1.0f, 0.0f, 1.0f, 1.0f };
+	scene.Materials[1].Albedo = { 0.2f, 0.3f, 1.0f, 1.0f };
+	scene.Materials[2].Albedo = { 0.8f, 0.5f, 0.2f, 1.0f };
+	scene.Materials[2].EmissionColor = scene.Materials[2].Albedo;
+	scene.Materials[2].EmissionPower = 2.0f;
+	scene.Sphere.push_back({ { 0.0f, 0.0f, 0.0f }, 1.0f, 0 });
+	scene.Sphere.push_back({ { 2.0f, 0.0f, 0.0f }, 1.0f, 2 });
+	scene.Sphere.push_back({ { -2.0f, -0.5f, -1.0f }, 0.5f, 1 });
+	scene.Sphere.push_back({ { 0.0f, -101.0f, 0.0f }, 100.0f, 1 });
+
+	// 相机移动时每帧沿 x 平移
+	const glm::vec3 cameraPosition(0.0f, 0.0f, 6.0f), cameraDirection(0.0f, 0.0f, -1.0f), cameraStep(0.05f, 0.0f, 0.0f);
+	Camera camera(45.0f, 0.1f, 100.0f);
+	camera.OnResize(width, height);
+	camera.SetView(cameraPosition, cameraDirection);
+	Camera finalCamera = camera;
+	finalCamera.SetView(cameraPosition + (float)(frameCount - 1) * cameraStep, cameraDirection);
+
+	auto createRenderer = [&](bool checkerboard)
+	{
+		auto renderer = std::make_unique<Renderer>();
+		Renderer::Settings& settings = renderer->GetSettings();
+		settings.Checkerboard = checkerboard;
+		settings.DynamicResolution = false;
+		renderer->OnResize(width, height);
+		return renderer;
+	};
+
+	auto renderReference = [&](const Camera& view)
+	{
+		std::vector<uint32_t> reference(width * height);
+		auto renderer = createRenderer(false);
+		for (uint32_t frame = 0; frame < referenceFrames; frame++)
+			renderer->Render(scene, view);
+		std::copy_n(renderer->GetImageData(), reference.size(), reference.begin());
+		return reference;
+	};
+	std::vector<uint32_t> reference = renderReference(camera);
+	std::vector<uint32_t> finalReference = renderReference(finalCamera);
+
+	Utils::Report(output, "Checkerboard: %ux%u, reference %u spp, %u threads", width, height, referenceFrames, createRenderer(false)->GetThreadCount());
+	Utils::Report(output, "  moving: the camera pans 0.05 per frame, frame %u is compared with a reference at its final position", frameCount);
+
+	// 相机移动：每帧平移后调用 OnCameraMoved，只有本帧的采样；棋盘格模式下另一半像素从上一帧重投影
+	const char* names[] = { "full rate", "checkerboard" };
+	for (int checkerboard = 0; checkerboard < 2; checkerboard++)
+	{
+		auto renderer = createRenderer(checkerboard);
+		Camera view = camera;
+		float totalTime = 0.0f;
+		for (uint32_t frame = 0; frame < frameCount; frame++)
+		{
+			if (frame > 0)
+			{
+				view.SetView(cameraPosition + (float)frame * cameraStep, cameraDirection);
+				renderer->OnCameraMoved();
+			}
+			Walnut::Timer timer;
+			renderer->Render(scene, view);
+			totalTime += timer.ElapsedMillis();
+		}
+		Utils::Report(output, "  moving  %-12s  %8.2fms/frame  RMSE %6.2f", names[checkerboard], totalTime / frameCount, Utils::ImageRMSE(renderer->GetImageData(), finalReference));
+	}
+
+	// 静止累积：棋盘格渲染与全分辨率渲染 frameCount 帧相同的时间
+	float budget = 0.0f;
+	for (int checkerboard = 0; checkerboard < 2; checkerboard++)
+	{
+		auto renderer = createRenderer(checkerboard);
+		uint32_t frames = 0;
+		Walnut::Timer timer;
+		while (checkerboard ? timer.ElapsedMillis() < budget : frames < frameCount)
+		{
+			renderer->Render(scene, camera);
+			frames++;
+		}
+		float elapsed = timer.ElapsedMillis();
+		if (!checkerboard)
+			budget = elapsed;
+
+		Utils::Report(output, "  still   %-12s  %8.2fms, %3u frames  RMSE %6.2f", names[checkerboard], elapsed, frames, Utils::ImageRMSE(renderer->GetImageData(), reference));
+	}
+
+	return output;
+}
+
+std::string Benchmark::Denoiser(uint32_t width, uint32_t height, uint32_t referenceFrames)
+{
+	std::string output;
+
+	// 地面、两个漫反射球与一个发光球
+	Scene scene;
+	scene.Materials.resize(3);
+	scene.Materials[0].Albedo = { 1.0f, 0.0f, 1.0f, 1.0f };
+	scene.Materials[1].Albedo = { 0.2f, 0.3f, 1.0f, 1.0f };
+	scene.Materials[2].Albedo = { 0.8f, 0.5f, 0.2f, 1.0f };
+	scene.Materials[2].EmissionColor = scene.Materials[2].Albedo;
+	scene.Materials[2].EmissionPower = 2.0f;
+	scene.Sphere.push_back({ { 0.0f, 0.0f, 0.0f }, 1.0f, 0 });
+	scene.Sphere.push_back({ { 2.0f, 0.0f, 0.0f }, 1.0f, 2 });
+	scene.Sphere.push_back({ { -2.0f, -0.5f, -1.0f }, 0.5f, 1 });
+	scene.Sphere.push_back({ { 0.0f, -101.0f, 0.0f }, 100.0f, 1 });
+
+	Camera camera(45.0f, 0.1f, 100.0f);
+	camera.OnResize(width, height);
+
+	// 降噪只作用于输出，累积结果相同；denoiseTime 为最后一帧降噪本身的耗时
+	auto render = [&](bool denoise, uint32_t samples, float* time = nullptr, float* denoiseTime = nullptr)
+	{
+		Renderer renderer;
+		renderer.GetSettings().Denoise = denoise;
+		renderer.GetSettings().DynamicResolution = false;
+		renderer.OnResize(width, height);
+
+		Walnut::Timer timer;
+		for (uint32_t frame = 0; frame < samples; frame++)
+			renderer.Render(scene, camera);
+		if (time)
+			*time = timer.ElapsedMillis();
+		if (denoiseTime)
+			*denoiseTime = renderer.GetDenoiser().GetTime();
+		return std::vector<uint32_t>(renderer.GetImageData(), renderer.GetImageData() + width * height);
+	};
+
+	std::vector<uint32_t> reference = render(false, referenceFrames);
+	Utils::Report(output, "Denoiser: %ux%u, reference %u spp without denoising", width, height, referenceFrames);
+
+	float targetError = 0.0f;
+	for (uint32_t samples : { 1u, 4u, 16u, 64u })
+	{
+		float noisyTime, denoisedTime, denoiseTime;
+		float noisyError = Utils::ImageRMSE(render(false, samples, &noisyTime).data(), reference);
+		float denoisedError = Utils::ImageRMSE(render(true, samples, &denoisedTime, &denoiseTime).data(), reference);
+		if (samples == 4)
+			targetError = denoisedError;
+		Utils::Report(output, "  %3u spp  noisy %8.2fms  RMSE %6.2f   denoised %8.2fms  RMSE %6.2f  (denoiser %.2fms/frame)",
+			samples, noisyTime, noisyError, denoisedTime, denoisedError, denoiseTime);
+	}
+
+	// 不降噪时逐次加倍采样数，直到误差不超过降噪后 4 spp 的误差
+	uint32_t samples = 4;
+	float error = FLT_MAX, time = 0.0f;
+	while (samples <= referenceFrames / 4 && (error = Utils::ImageRMSE(render(false, samples, &time).data(), reference)) > targetError)
+		samples *= 2;
+	if (error <= targetError)
+		Utils::Report(output, "  without denoising %u spp (%.2fms) are needed to match 4 spp denoised", samples, time);
+	else
+		Utils::Report(output, "  without denoising 4 spp denoised is not matched within %u spp", referenceFrames / 4);
+
+	return output;
+}
+
+std::string Benchmark::LightSampling(uint32_t width, uint32_t height, uint32_t referenceFrames)
+{
+	std::string output;
+
+	// 地面与两个漫反射球，由一个半径 0.08 的光源照亮
+	Scene scene;
+	scene.Materials.resize(3);
+	scene.Materials[0].Albedo = { 0.8f, 0.8f, 0.8f, 1.0f };
+	scene.Materials[1].Albedo = { 0.2f, 0.3f, 1.0f, 1.0f };
+	scene.Materials[2].EmissionColor = { 1.0f, 0.9f, 0.7f };
+	scene.Materials[2].EmissionPower = 100.0f;
+	scene.Sphere.push_back({ { 0.0f, 0.0f, 0.0f }, 1.0f, 0 });
+	scene.Sphere.push_back({ { -2.0f, -0.5f, 0.5f }, 0.5f, 0 });
+	scene.Sphere.push_back({ { 1.5f, 1.5f, 0.5f }, 0.08f, 2 });
+	scene.Sphere.push_back({ { 0.0f, -101.0f, 0.0f }, 100.0f, 1 });
+
+	Camera camera(45.0f, 0.1f, 100.0f);
+	camera.OnResize(width, height);
+
+	auto render = [&](bool lightSampling, uint32_t samples, float* time = nullptr)
+	{
+		Renderer renderer;
+		renderer.GetSettings().LightSampling = lightSampling;
+		renderer.GetSettings().DynamicResolution = false;
+		renderer.OnResize(width, height);
+
+		Walnut::Timer timer;
+		for (uint32_t frame = 0; frame < samples; frame++)
+			renderer.Render(scene, camera);
+		if (time)
+			*time = timer.ElapsedMillis();
+		return std::vector<uint32_t>(renderer.GetImageData(), renderer.GetImageData() + width * height);
+	};
+
+	// 参考图只做 BSDF 采样，不依赖被测的光源采样与多重重要性采样
+	std::vector<uint32_t> reference = render(false, referenceFrames);
+	Utils::Report(output, "Light Sampling: %ux%u, reference %u spp with BSDF sampling only", width, height, referenceFrames);
+
+	float targetError = 0.0f;
+	for (uint32_t samples : { 4u, 16u, 64u })
+	{
+		float bsdfTime, lightTime;
+		float bsdfError = Utils::ImageRMSE(render(false, samples, &bsdfTime).data(), reference);
+		float lightError = Utils::ImageRMSE(render(true, samples, &lightTime).data(), reference);
+		if (samples == 16)
+			targetError = lightError;
+		Utils::Report(output, "  %3u spp  BSDF only %8.2fms  RMSE %6.2f   light sampling + MIS %8.2fms  RMSE %6.2f",
+			samples, bsdfTime, bsdfError, lightTime, lightError);
+	}
+
+	// 只做 BSDF 采样时逐次加倍采样数，直到误差不超过光源采样 16 spp 的误差；采样数越接近参考图，与参考图共用的采样越多，至多取其 1/4
+	uint32_t samples = 16;
+	float error = FLT_MAX, time = 0.0f;
+	while (samples <= referenceFrames / 4 && (error = Utils::ImageRMSE(render(false, samples, &time).data(), reference)) > targetError)
+		samples *= 2;
+	if (error <= targetError)
+		Utils::Report(output, "  BSDF only needs %u spp (%.2fms) to match 16 spp with light sampling", samples, time);
+	else
+		Utils::Report(output, "  BSDF only does not match 16 spp with light sampling within %u spp", referenceFrames / 4);
+
+	return output;
+}
+
+std::string Benchmark::LightTree(uint32_t width, uint32_t height, float timeBudget, uint32_t referenceFrames)
+{
+	std::string output;
+	Utils::Report(output, "Light Tree: %ux%u, %.0fms per method, reference %u spp with uniform selection", width, height, timeBudget, referenceFrames);
+
+	Camera camera(45.0f, 0.1f, 100.0f);
+	camera.OnResize(width, height);
+	camera.SetView({ 0.0f, 3.0f, 10.0f }, { 0.0f, -0.35f, -1.0f });
+
+	for (uint32_t lightCount : { 10u, 100u, 1000u, 10000u, 100000u })
+	{
+		Scene scene = Utils::CreateManyLightScene(lightCount);
+
+		auto createRenderer = [&](LightSampler::Type type)
+		{
+			auto renderer = std::make_unique<Renderer>();
+			renderer->GetSettings().LightSelection = type;
+			renderer->GetSettings().DynamicResolution = false;
+			renderer->OnResize(width, height);
+			return renderer;
+		};
+
+		// 参考图用均匀选择渲染，不依赖被测的光源树
+		std::vector<uint32_t> reference(width * height);
+		{
+			auto renderer = createRenderer(LightSampler::Type::Uniform);
+			for (uint32_t frame = 0; frame < referenceFrames; frame++)
+				renderer->Render(scene, camera);
+			std::copy_n(renderer->GetImageData(), reference.size(), reference.begin());
+		}
+
+		// 第一帧包含加速结构与光源树的构建，不计入耗时
+		const char* names[] = { "uniform", "light tree" };
+		for (LightSampler::Type type : { LightSampler::Type::Uniform, LightSampler::Type::LightTree })
+		{
+			auto renderer = createRenderer(type);
+			renderer->Render(scene, camera);
+
+			uint32_t frames = 1;
+			Walnut::Timer timer;
+			while (timer.ElapsedMillis() < timeBudget)
+			{
+				renderer->Render(scene, camera);
+				frames++;
+			}
+
+			const LightSampler& lightSampler = renderer->GetLightSampler();
+			if (type == LightSampler::Type::LightTree)
+				Utils::Report(output, "  %6u lights  %-10s  %4u spp  RMSE %6.2f  (%u nodes, build %.2fms)", lightCount, names[(int)type], frames,
+					Utils::ImageRMSE(renderer->GetImageData(), reference), lightSampler.GetLightTree().GetNodeCount(), lightSampler.GetLightTree().GetBuildTime());
+			else
+				Utils::Report(output, "  %6u lights  %-10s  %4u spp  RMSE %6.2f", lightCount, names[(int)type], frames,
+					Utils::ImageRMSE(renderer->GetImageData(), reference));
+		}
+	}
+
+	return output;
+}
+
+std::string Benchmark::ReSTIR(uint32_t width, uint32_t height, uint32_t frameCount, uint32_t referenceFrames)
+{
+	std::string output;
+	Utils::Report(output, "ReSTIR: %ux%u, 1 spp per frame without accumulation, error of frame 1 and frame %u, reference %u spp with uniform selection", width, height, frameCount, referenceFrames);
+	Utils::Report(output, "  moving: the camera pans 0.05 per frame, frame %u is compared with a reference at its final position", frameCount);
+
+	// 相机移动时每帧沿 x 平移，时域复用的历史都来自重投影
+	const glm::vec3 cameraPosition(0.0f, 3.0f, 10.0f), cameraDirection(0.0f, -0.35f, -1.0f), cameraStep(0.05f, 0.0f, 0.0f);
+	Camera camera(45.0f, 0.1f, 100.0f);
+	camera.OnResize(width, height);
+	camera.SetView(cameraPosition, cameraDirection);
+	Camera finalCamera = camera;
+	finalCamera.SetView(cameraPosition + (float)(frameCount - 1) * cameraStep, cameraDirection);
+
+	for (uint32_t lightCount : { 1000u, 100000u })
+	{
+		Scene scene = Utils::CreateManyLightScene(lightCount);
+
+		auto createRenderer = [&]()
+		{
+			auto renderer = std::make_unique<Renderer>();
+			renderer->GetSettings().DynamicResolution = false;
+			renderer->OnResize(width, height);
+			return renderer;
+		};
+
+		// 参考图用均匀选择渲染，不依赖被测的光源树
+		auto renderReference = [&](const Camera& view)
+		{
+			std::vector<uint32_t> reference(width * height);
+			auto renderer = createRenderer();
+			renderer->GetSettings().LightSelection = LightSampler::Type::Uniform;
+			for (uint32_t frame = 0; frame < referenceFrames; frame++)
+				renderer->Render(scene, view);
+			std::copy_n(renderer->GetImageData(), reference.size(), reference.begin());
+			return reference;
+		};
+		std::vector<uint32_t> reference = renderReference(camera);
+		std::vector<uint32_t> finalReference = renderReference(finalCamera);
+
+		// 第一帧相当于相机移动后没有历史的情况，时域复用需要若干帧才能积累候选，另取第 frameCount 帧的误差；耗时为除第一帧（包含加速结构与光源树的构建）之外的平均
+		struct Method
+		{
+			const char* Name;
+			bool ReSTIR, TemporalReuse, SpatialReuse;
+		};
+		const Method methods[] = {
+			{ "light tree", false, false, false },
+			{ "RIS only", true, false, false },
+			{ "temporal", true, true, false },
+			{ "spatiotemporal", true, true, true },
+		};
+		for (bool moving : { false, true })
+		{
+			for (const Method& method : methods)
+			{
+				auto renderer = createRenderer();
+				Renderer::Settings& settings = renderer->GetSettings();
+				settings.Accumulate = false;
+				settings.ReSTIR = method.ReSTIR;
+				settings.Resampling.TemporalReuse = method.TemporalReuse;
+				settings.Resampling.SpatialReuse = method.SpatialReuse;
+
+				Camera view = camera;
+				renderer->Render(scene, view);
+				float firstError = Utils::ImageRMSE(renderer->GetImageData(), reference);
+				Walnut::Timer timer;
+				for (uint32_t frame = 1; frame < frameCount; frame++)
+				{
+					if (moving)
+					{
+						view.SetView(cameraPosition + (float)frame * cameraStep, cameraDirection);
+						renderer->OnCameraMoved();
+					}
+					renderer->Render(scene, view);
+				}
+				float frameTime = timer.ElapsedMillis() / glm::max(frameCount - 1, 1u);
+
+				Utils::Report(output, "  %6u lights  %-6s  %-14s  %7.2fms/frame  RMSE %6.2f -> %6.2f", lightCount, moving ? "moving" : "static", method.Name, frameTime,
+					firstError, Utils::ImageRMSE(renderer->GetImageData(), moving ? finalReference : reference));
+			}
+		}
+	}
+
+	return output;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Scene.h"
+
+// 性能基准：结果逐行以 "[BENCH]" 前缀输出到控制台，同时返回给界面显示
+namespace Benchmark
+{
+	// 在边长与数量的立方根成正比的立方体内随机生成球体，保持密度不变
+	std::vector<Sphere> GenerateRandomSpheres(uint32_t count, float radius, uint32_t seed = 1);
+
+	// 各构建质量下单线程与多线程的 BVH 构建耗时（毫秒 / 百万图元）
+	std::string BVHBuild(uint32_t primitiveCount = 1000000);
+
+	// 二叉与 8 叉量化 BVH 在同一场景下的节点内存与随机光线吞吐量
+	std::string BVHTraversal(uint32_t primitiveCount = 100000, uint32_t rayCount = 1000000);
+
+	// 拖动单个球体与全部球体随机运动时每帧 Refit 的耗时、触发的重建次数以及 SAH 代价变化
+	std::string BVHRefit(uint32_t primitiveCount = 100000, uint32_t frameCount = 60);
+
+	// 逐个按值拷贝球体的标量求交循环与 SoA 8 路 SIMD 批量求交的吞吐量（每秒球体测试数）
+	std::string SphereKernel(uint32_t rayCount = 1000000);
+
+	// 针孔相机主光线逐条追踪与 4x2 光线组追踪的吞吐量（暴力求交与 BVH）
+	std::string PacketTracing(uint32_t width = 1920, uint32_t height = 1080);
+
+	// 按 32x32 tile 工作窃取调度在不同线程数下的加速比，并与原先每像素一个任务的 std::for_each(par) 对比
+	std::string ThreadScaling(uint32_t width = 1920, uint32_t height = 1080);
+
+	// tile 分配顺序与 tile 内像素顺序分别为行优先、Morton、Hilbert 时的渲染耗时
+	std::string PixelOrder(uint32_t width = 1920, uint32_t height = 1080);
+
+	// 主光线首次命中：BVH 逐条追踪、逐 tile 剔除后追踪与光栅化可见性缓冲区的耗时（1000 与 10 万个球体）
+	std::string PrimaryVisibility(uint32_t width = 1920, uint32_t height = 1080);
+
+	// 自适应采样渲染到全部 tile 收敛的耗时、平均采样数与误差，以及逐像素均匀采样相同耗时的误差、达到相同误差所需的耗时；参考图均匀采样 referenceFrames 帧
+	std::string AdaptiveSampling(uint32_t width = 320, uint32_t height = 180, uint32_t referenceFrames = 4096);
+
+	// 静止累积 historyFrames 帧后相机逐帧平移 frameCount 帧，开启与关闭时域重投影时每帧的耗时与最后一帧相对最终位置参考图（referenceFrames 帧）的误差
+	std::string Reprojection(uint32_t width = 320, uint32_t height = 180, uint32_t historyFrames = 64, uint32_t frameCount = 4, uint32_t referenceFrames = 1024);
+
+	// 棋盘格与全分辨率渲染对比：相机逐帧平移时每帧的耗时与最后一帧的误差，以及静止累积相同耗时后的误差；误差为相对同一视角 referenceFrames 帧全分辨率累积结果的 RMSE（0-255）
+	std::string Checkerboard(uint32_t width = 960, uint32_t height = 540, uint32_t frameCount = 16, uint32_t referenceFrames = 256);
+
+	// 各采样数下降噪前后相对 referenceFrames 帧累积结果的误差与耗时，以及降噪本身每帧的耗时；再求不降噪达到降噪后 4 spp 误差所需的采样数
+	std::string Denoiser(uint32_t width = 320, uint32_t height = 180, uint32_t referenceFrames = 1024);
+
+	// 小而亮的光源下只做 BSDF 采样与加上光源采样（多重重要性采样）在各采样数下的耗时与误差，以及只做 BSDF 采样达到相同误差所需的采样数；参考图只做 BSDF 采样
+	std::string LightSampling(uint32_t width = 320, uint32_t height = 180, uint32_t referenceFrames = 4096);
+
+	// 光源数从 10 增加到 10 万时，均匀选择光源与光源树在相同耗时（timeBudget 毫秒）内的采样数与误差；总功率保持不变，参考图用均匀选择渲染
+	std::string LightTree(uint32_t width = 320, uint32_t height = 180, float timeBudget = 1000.0f, uint32_t referenceFrames = 1024);
+
+	// 光源采样（光源树）与 ReSTIR 只做候选重采样、加时域复用、再加空间复用时，每帧 1 spp 不累积的耗时与误差（1000 与 10 万个光源），相机静止与逐帧平移各一组；参考图用均匀选择光源
+	std::string ReSTIR(uint32_t width = 320, uint32_t height = 180, uint32_t frameCount = 16, uint32_t referenceFrames = 1024);
+
+	// 全部球体每帧运动时，均匀网格与 BVH 每帧重建加追踪的耗时（1 万、10 万、100 万个球体）
+	std::string GridVsBVH(uint32_t rayCount = 1000000, uint32_t frameCount = 4);
+}
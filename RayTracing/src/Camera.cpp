@@ -4,17 +4,23 @@
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+#ifndef RT_HEADLESS
 #include "Walnut/Input/Input.h"
 
 using namespace Walnut;
+#endif
 
 Camera::Camera(float verticalFOV, float nearClip, float farClip)
 	: m_VerticalFOV(verticalFOV), m_NearClip(nearClip), m_FarClip(farClip)
 {
 	m_ForwardDirection = glm::vec3(0, 0, -1);
 	m_Position = glm::vec3(0, 0, 6);
+
+	// 视图矩阵与初始位置保持一致，供屏幕空间投影使用
+	RecalculateView();
 }
 
+#ifndef RT_HEADLESS
 bool Camera::OnUpdate(float ts)
 {
 	glm::vec2 mousePos = Input::GetMousePosition();
@@ -89,6 +95,16 @@ bool Camera::OnUpdate(float ts)
 
 	return moved;
 }
+#endif
+
+void Camera::SetView(const glm::vec3& position, const glm::vec3& direction)
+{
+	m_Position = position;
+	m_ForwardDirection = glm::normalize(direction);
+
+	RecalculateView();
+	RecalculateRayDirections();
+}
 
 void Camera::OnResize(uint32_t width, uint32_t height)
 {
@@ -121,18 +137,17 @@ void Camera::RecalculateView()
 
 void Camera::RecalculateRayDirections()
 {
-	m_RayDirections.resize(m_ViewportWidth * m_ViewportHeight);
-
-	for (uint32_t y = 0; y < m_ViewportHeight; y++)
+	// 透视投影下 NDC 平面上一点反投影后的方向在 NDC 上是仿射的，只需求三个角点
+	auto direction = [this](float x, float y)
 	{
-		for (uint32_t x = 0; x < m_ViewportWidth; x++)
-		{
-			glm::vec2 coord = { (float)x / (float)m_ViewportWidth, (float)y / (float)m_ViewportHeight };
-			coord = coord * 2.0f - 1.0f; // -1 -> 1
-
-			glm::vec4 target = m_InverseProjection * glm::vec4(coord.x, coord.y, 1, 1);
-			glm::vec3 rayDirection = glm::vec3(m_InverseView * glm::vec4(glm::normalize(glm::vec3(target) / target.w), 0)); // World space
-			m_RayDirections[x + y * m_ViewportWidth] = rayDirection;
-		}
-	}
+		glm::vec4 target = m_InverseProjection * glm::vec4(x, y, 1, 1);
+		return glm::vec3(m_InverseView * glm::vec4(glm::vec3(target) / target.w, 0)); // World space
+	};
+
+	// 像素 x 对应 NDC x / width * 2 - 1
+	glm::vec3 base = direction(-1.0f, -1.0f);
+	m_PrimaryRays.Origin = m_Position;
+	m_PrimaryRays.Base = base;
+	m_PrimaryRays.StepX = (direction(1.0f, -1.0f) - base) / (float)m_ViewportWidth;
+	m_PrimaryRays.StepY = (direction(-1.0f, 1.0f) - base) / (float)m_ViewportHeight;
 }
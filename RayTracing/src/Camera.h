@@ -1,15 +1,20 @@
 #pragma once
 
 #include <glm/glm.hpp>
-#include <vector>
+
+#include "Ray.h"
 
 class Camera
 {
 public:
 	Camera(float verticalFOV, float nearClip, float farClip);
 
+#ifndef RT_HEADLESS
 	bool OnUpdate(float ts);
+#endif
 	void OnResize(uint32_t width, uint32_t height);
+	// 直接设置相机位置与朝向，供离线渲染从场景文件中读取视角
+	void SetView(const glm::vec3& position, const glm::vec3& direction);
 
 	const glm::mat4& GetProjection() const { return m_Projection; }
 	const glm::mat4& GetInverseProjection() const { return m_InverseProjection; }
@@ -19,7 +24,7 @@ public:
 	const glm::vec3& GetPosition() const { return m_Position; }
 	const glm::vec3& GetDirection() const { return m_ForwardDirection; }
 
-	const std::vector<glm::vec3>& GetRayDirections() const { return m_RayDirections; }
+	const PrimaryRayGenerator& GetPrimaryRays() const { return m_PrimaryRays; }
 
 	float GetRotationSpeed();
 private:
@@ -39,8 +44,8 @@ private:
 	glm::vec3 m_Position{0.0f, 0.0f, 0.0f};
 	glm::vec3 m_ForwardDirection{0.0f, 0.0f, 0.0f};
 
-	// Cached ray directions
-	std::vector<glm::vec3> m_RayDirections;
+	// 主光线在渲染时逐像素生成，这里只保存像素 (0, 0) 的方向与每像素的增量
+	PrimaryRayGenerator m_PrimaryRays;
 
 	glm::vec2 m_LastMousePosition{ 0.0f, 0.0f };
 
@@ -0,0 +1,298 @@
+#include "Denoiser.h"
+
+#include "Walnut/Timer.h"
+
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace Utils
+{
+	// B3 样条核 [1, 4, 6, 4, 1] / 16
+	static constexpr float AtrousKernel[5] = { 1.0f / 16.0f, 1.0f / 4.0f, 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+
+	static float Luminance(float r, float g, float b)
+	{
+		return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+	}
+
+#if defined(__AVX2__)
+	// 2^(x log2 e)：整数部分写入指数位，小数部分用 5 次多项式近似，相对误差约 1e-7；x 小于 -87 时按 -87 计算
+	static __m256 Exp(__m256 x)
+	{
+		x = _mm256_max_ps(x, _mm256_set1_ps(-87.0f));
+		__m256 t = _mm256_mul_ps(x, _mm256_set1_ps(1.44269504f));
+		__m256 integer = _mm256_floor_ps(t);
+		__m256 f = _mm256_sub_ps(t, integer);
+
+		__m256 p = _mm256_set1_ps(1.333355814e-3f);
+		p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(9.618129107e-3f));
+		p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(5.550410866e-2f));
+		p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(2.402265070e-1f));
+		p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(6.931471806e-1f));
+		p = _mm256_fmadd_ps(p, f, _mm256_set1_ps(1.0f));
+
+		__m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(integer), _mm256_set1_epi32(127)), 23);
+		return _mm256_mul_ps(p, _mm256_castsi256_ps(exponent));
+	}
+
+	static __m256 Abs(__m256 x)
+	{
+		return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x);
+	}
+
+	static __m256 Luminance(__m256 r, __m256 g, __m256 b)
+	{
+		__m256 l = _mm256_mul_ps(r, _mm256_set1_ps(0.2126f));
+		l = _mm256_fmadd_ps(g, _mm256_set1_ps(0.7152f), l);
+		return _mm256_fmadd_ps(b, _mm256_set1_ps(0.0722f), l);
+	}
+#endif
+}
+
+void Denoiser::Resize(uint32_t width, uint32_t height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+
+	m_Width = width;
+	m_Height = height;
+
+	uint32_t pixelCount = width * height;
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		m_ColorR[i].resize(pixelCount);
+		m_ColorG[i].resize(pixelCount);
+		m_ColorB[i].resize(pixelCount);
+		m_Variance[i].resize(pixelCount);
+	}
+	m_SampleCounts.resize(pixelCount);
+	m_AlbedoR.resize(pixelCount);
+	m_AlbedoG.resize(pixelCount);
+	m_AlbedoB.resize(pixelCount);
+	m_NormalX.resize(pixelCount);
+	m_NormalY.resize(pixelCount);
+	m_NormalZ.resize(pixelCount);
+	m_Depth.resize(pixelCount);
+}
+
+void Denoiser::Denoise(ThreadPool& pool, const Settings& settings)
+{
+	Walnut::Timer timer;
+
+	m_Current = 0;
+	pool.ParallelFor(m_Height, [this](uint32_t y, uint32_t threadIndex)
+		{
+			EstimateVariance(y);
+		});
+
+	for (uint32_t iteration = 0; iteration < settings.Iterations; iteration++)
+	{
+		uint32_t step = 1u << iteration;
+		pool.ParallelFor(m_Height, [this, step, &settings](uint32_t y, uint32_t threadIndex)
+			{
+				FilterRow(y, step, settings);
+			});
+		m_Current = 1 - m_Current;
+	}
+
+	m_Time = timer.ElapsedMillis();
+}
+
+// 采样太少时逐像素的方差不可靠，改用 3x3 邻域内有效像素的亮度方差
+void Denoiser::EstimateVariance(uint32_t y)
+{
+	for (uint32_t x = 0; x < m_Width; x++)
+	{
+		uint32_t pixel = x + y * m_Width;
+		if (m_SampleCounts[pixel] >= 4)
+			continue;
+
+		float sum = 0.0f, sumSquared = 0.0f, count = 0.0f;
+		for (uint32_t ny = (y > 0 ? y - 1 : y); ny <= glm::min(y + 1, m_Height - 1); ny++)
+		{
+			for (uint32_t nx = (x > 0 ? x - 1 : x); nx <= glm::min(x + 1, m_Width - 1); nx++)
+			{
+				uint32_t neighbour = nx + ny * m_Width;
+				if (m_SampleCounts[neighbour] == 0)
+					continue;
+
+				float luminance = Utils::Luminance(m_ColorR[0][neighbour], m_ColorG[0][neighbour], m_ColorB[0][neighbour]);
+				sum += luminance;
+				sumSquared += luminance * luminance;
+				count++;
+			}
+		}
+
+		if (count > 0.0f)
+			m_Variance[0][pixel] = glm::max(sumSquared / count - (sum / count) * (sum / count), 0.0f);
+	}
+}
+
+void Denoiser::FilterRow(uint32_t y, uint32_t step, const Settings& settings)
+{
+	uint32_t x = 0;
+
+#if defined(__AVX2__)
+	// 5x5 采样全部落在图像内的 8 个像素一组向量化，靠近左右边缘的像素逐个处理
+	uint32_t radius = 2 * step;
+	for (; x < radius && x < m_Width; x++)
+		FilterPixel(x, y, step, settings);
+
+	const float* colorR = m_ColorR[m_Current].data();
+	const float* colorG = m_ColorG[m_Current].data();
+	const float* colorB = m_ColorB[m_Current].data();
+	const float* variance = m_Variance[m_Current].data();
+	uint32_t next = 1 - m_Current;
+
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 epsilon = _mm256_set1_ps(1e-4f);
+	const __m256 colorSigma = _mm256_set1_ps(settings.ColorSigma);
+	const __m256 normalSigma = _mm256_set1_ps(settings.NormalSigma);
+	const __m256 depthSigma = _mm256_set1_ps(settings.DepthSigma);
+	const __m256 invAlbedo = _mm256_set1_ps(1.0f / glm::max(settings.AlbedoSigma * settings.AlbedoSigma, 1e-8f));
+
+	for (; x + 8 + radius <= m_Width; x += 8)
+	{
+		uint32_t pixel = x + y * m_Width;
+
+		__m256 normalX = _mm256_loadu_ps(&m_NormalX[pixel]);
+		__m256 normalY = _mm256_loadu_ps(&m_NormalY[pixel]);
+		__m256 normalZ = _mm256_loadu_ps(&m_NormalZ[pixel]);
+		__m256 depth = _mm256_loadu_ps(&m_Depth[pixel]);
+		__m256 albedoR = _mm256_loadu_ps(&m_AlbedoR[pixel]);
+		__m256 albedoG = _mm256_loadu_ps(&m_AlbedoG[pixel]);
+		__m256 albedoB = _mm256_loadu_ps(&m_AlbedoB[pixel]);
+		__m256 r = _mm256_loadu_ps(&colorR[pixel]);
+		__m256 g = _mm256_loadu_ps(&colorG[pixel]);
+		__m256 b = _mm256_loadu_ps(&colorB[pixel]);
+
+		__m256 luminance = Utils::Luminance(r, g, b);
+		__m256 invColor = _mm256_div_ps(one, _mm256_fmadd_ps(colorSigma, _mm256_sqrt_ps(_mm256_loadu_ps(&variance[pixel])), epsilon));
+		__m256 invDepth = _mm256_div_ps(one, _mm256_fmadd_ps(depthSigma, depth, epsilon));
+
+		__m256 sumR = zero, sumG = zero, sumB = zero, sumVariance = zero, sumWeight = zero;
+		for (int dy = -2; dy <= 2; dy++)
+		{
+			int qy = (int)y + dy * (int)step;
+			if (qy < 0 || qy >= (int)m_Height)
+				continue;
+
+			for (int dx = -2; dx <= 2; dx++)
+			{
+				uint32_t q = x + dx * (int)step + qy * m_Width;
+
+				__m256 nq = _mm256_mul_ps(normalX, _mm256_loadu_ps(&m_NormalX[q]));
+				nq = _mm256_fmadd_ps(normalY, _mm256_loadu_ps(&m_NormalY[q]), nq);
+				nq = _mm256_fmadd_ps(normalZ, _mm256_loadu_ps(&m_NormalZ[q]), nq);
+
+				__m256 ar = _mm256_sub_ps(albedoR, _mm256_loadu_ps(&m_AlbedoR[q]));
+				__m256 ag = _mm256_sub_ps(albedoG, _mm256_loadu_ps(&m_AlbedoG[q]));
+				__m256 ab = _mm256_sub_ps(albedoB, _mm256_loadu_ps(&m_AlbedoB[q]));
+				__m256 albedoDistance = _mm256_fmadd_ps(ar, ar, _mm256_fmadd_ps(ag, ag, _mm256_mul_ps(ab, ab)));
+
+				__m256 qr = _mm256_loadu_ps(&colorR[q]);
+				__m256 qg = _mm256_loadu_ps(&colorG[q]);
+				__m256 qb = _mm256_loadu_ps(&colorB[q]);
+
+				__m256 e = _mm256_mul_ps(normalSigma, _mm256_sub_ps(one, nq));
+				e = _mm256_fmadd_ps(Utils::Abs(_mm256_sub_ps(depth, _mm256_loadu_ps(&m_Depth[q]))), invDepth, e);
+				e = _mm256_fmadd_ps(albedoDistance, invAlbedo, e);
+				e = _mm256_fmadd_ps(Utils::Abs(_mm256_sub_ps(luminance, Utils::Luminance(qr, qg, qb))), invColor, e);
+
+				// 法线夹角不小于 90 度（包括零法线）的采样权重为 0
+				__m256 weight = _mm256_mul_ps(_mm256_set1_ps(Utils::AtrousKernel[dx + 2] * Utils::AtrousKernel[dy + 2]), Utils::Exp(_mm256_sub_ps(zero, e)));
+				weight = _mm256_and_ps(weight, _mm256_cmp_ps(nq, zero, _CMP_GT_OQ));
+
+				sumR = _mm256_fmadd_ps(weight, qr, sumR);
+				sumG = _mm256_fmadd_ps(weight, qg, sumG);
+				sumB = _mm256_fmadd_ps(weight, qb, sumB);
+				sumVariance = _mm256_fmadd_ps(_mm256_mul_ps(weight, weight), _mm256_loadu_ps(&variance[q]), sumVariance);
+				sumWeight = _mm256_add_ps(sumWeight, weight);
+			}
+		}
+
+		// 无效像素（权重和为 0）保持原值
+		__m256 valid = _mm256_cmp_ps(sumWeight, zero, _CMP_GT_OQ);
+		__m256 invWeight = _mm256_div_ps(one, _mm256_blendv_ps(one, sumWeight, valid));
+		_mm256_storeu_ps(&m_ColorR[next][pixel], _mm256_blendv_ps(r, _mm256_mul_ps(sumR, invWeight), valid));
+		_mm256_storeu_ps(&m_ColorG[next][pixel], _mm256_blendv_ps(g, _mm256_mul_ps(sumG, invWeight), valid));
+		_mm256_storeu_ps(&m_ColorB[next][pixel], _mm256_blendv_ps(b, _mm256_mul_ps(sumB, invWeight), valid));
+		_mm256_storeu_ps(&m_Variance[next][pixel], _mm256_blendv_ps(_mm256_loadu_ps(&variance[pixel]),
+			_mm256_mul_ps(sumVariance, _mm256_mul_ps(invWeight, invWeight)), valid));
+	}
+#endif
+
+	for (; x < m_Width; x++)
+		FilterPixel(x, y, step, settings);
+}
+
+void Denoiser::FilterPixel(uint32_t x, uint32_t y, uint32_t step, const Settings& settings)
+{
+	const float* colorR = m_ColorR[m_Current].data();
+	const float* colorG = m_ColorG[m_Current].data();
+	const float* colorB = m_ColorB[m_Current].data();
+	const float* variance = m_Variance[m_Current].data();
+	uint32_t next = 1 - m_Current;
+
+	uint32_t pixel = x + y * m_Width;
+	glm::vec3 normal{ m_NormalX[pixel], m_NormalY[pixel], m_NormalZ[pixel] };
+	glm::vec3 albedo{ m_AlbedoR[pixel], m_AlbedoG[pixel], m_AlbedoB[pixel] };
+	float depth = m_Depth[pixel];
+	float luminance = Utils::Luminance(colorR[pixel], colorG[pixel], colorB[pixel]);
+
+	float invColor = 1.0f / (settings.ColorSigma * std::sqrt(variance[pixel]) + 1e-4f);
+	float invDepth = 1.0f / (settings.DepthSigma * depth + 1e-4f);
+	float invAlbedo = 1.0f / glm::max(settings.AlbedoSigma * settings.AlbedoSigma, 1e-8f);
+
+	glm::vec3 sum{ 0.0f };
+	float sumVariance = 0.0f, sumWeight = 0.0f;
+	for (int dy = -2; dy <= 2; dy++)
+	{
+		int qy = (int)y + dy * (int)step;
+		if (qy < 0 || qy >= (int)m_Height)
+			continue;
+
+		for (int dx = -2; dx <= 2; dx++)
+		{
+			int qx = (int)x + dx * (int)step;
+			if (qx < 0 || qx >= (int)m_Width)
+				continue;
+
+			uint32_t q = qx + qy * m_Width;
+			float nq = glm::dot(normal, glm::vec3(m_NormalX[q], m_NormalY[q], m_NormalZ[q]));
+			if (nq <= 0.0f)
+				continue;
+
+			glm::vec3 albedoDifference = albedo - glm::vec3(m_AlbedoR[q], m_AlbedoG[q], m_AlbedoB[q]);
+			float e = settings.NormalSigma * (1.0f - nq)
+				+ std::abs(depth - m_Depth[q]) * invDepth
+				+ glm::dot(albedoDifference, albedoDifference) * invAlbedo
+				+ std::abs(luminance - Utils::Luminance(colorR[q], colorG[q], colorB[q])) * invColor;
+
+			float weight = Utils::AtrousKernel[dx + 2] * Utils::AtrousKernel[dy + 2] * std::exp(-glm::min(e, 87.0f));
+			sum += weight * glm::vec3(colorR[q], colorG[q], colorB[q]);
+			sumVariance += weight * weight * variance[q];
+			sumWeight += weight;
+		}
+	}
+
+	if (sumWeight > 0.0f)
+	{
+		sum /= sumWeight;
+		sumVariance /= sumWeight * sumWeight;
+	}
+	else
+	{
+		sum = { colorR[pixel], colorG[pixel], colorB[pixel] };
+		sumVariance = variance[pixel];
+	}
+
+	m_ColorR[next][pixel] = sum.r;
+	m_ColorG[next][pixel] = sum.g;
+	m_ColorB[next][pixel] = sum.b;
+	m_Variance[next][pixel] = sumVariance;
+}
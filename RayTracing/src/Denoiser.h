@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "ThreadPool.h"
+
+// SVGF 风格的边缘感知 à-trous 小波滤波：5x5 B3 样条核，第 i 次迭代的采样间隔为 2^i
+// 权重由首次命中的法线、距离、反照率与按标准差归一化的亮度差共同决定，亮度方差随每次迭代一同滤波
+class Denoiser
+{
+public:
+	struct Settings
+	{
+		uint32_t Iterations = 4;
+		float ColorSigma = 4.0f;    // 亮度差为该倍数的标准差时权重降为 1/e
+		float NormalSigma = 128.0f; // 法线权重 exp(-NormalSigma * (1 - dot(n, n')))，约等于 dot^NormalSigma
+		float DepthSigma = 0.05f;   // 相对距离差
+		float AlbedoSigma = 0.1f;
+	};
+
+	Denoiser() = default;
+
+	void Resize(uint32_t width, uint32_t height);
+
+	// color 为像素的平均颜色，variance 为平均亮度的方差，sampleCount 不足 4 时改用 3x3 邻域的亮度方差
+	// normal 为零向量的像素（未命中或没有采样）既不被滤波也不参与其他像素的滤波
+	void SetPixel(uint32_t pixel, const glm::vec3& color, float variance, uint32_t sampleCount, const glm::vec3& albedo, const glm::vec3& normal, float depth)
+	{
+		m_ColorR[0][pixel] = color.r;
+		m_ColorG[0][pixel] = color.g;
+		m_ColorB[0][pixel] = color.b;
+		m_Variance[0][pixel] = variance;
+		m_SampleCounts[pixel] = sampleCount;
+		m_AlbedoR[pixel] = albedo.r;
+		m_AlbedoG[pixel] = albedo.g;
+		m_AlbedoB[pixel] = albedo.b;
+		m_NormalX[pixel] = normal.x;
+		m_NormalY[pixel] = normal.y;
+		m_NormalZ[pixel] = normal.z;
+		m_Depth[pixel] = depth;
+	}
+
+	void Denoise(ThreadPool& pool, const Settings& settings);
+
+	glm::vec3 GetColor(uint32_t pixel) const { return { m_ColorR[m_Current][pixel], m_ColorG[m_Current][pixel], m_ColorB[m_Current][pixel] }; }
+	float GetTime() const { return m_Time; }
+private:
+	void EstimateVariance(uint32_t y);
+	// 从 m_Current 读取、写入另一组缓冲区的第 y 行
+	void FilterRow(uint32_t y, uint32_t step, const Settings& settings);
+	void FilterPixel(uint32_t x, uint32_t y, uint32_t step, const Settings& settings);
+private:
+	uint32_t m_Width = 0, m_Height = 0;
+
+	// SoA：每个通道一个平面，同一行的像素连续存放，8 路 SIMD 直接读取相邻的 8 个像素
+	std::vector<float> m_ColorR[2], m_ColorG[2], m_ColorB[2], m_Variance[2];
+	std::vector<uint32_t> m_SampleCounts;
+	std::vector<float> m_AlbedoR, m_AlbedoG, m_AlbedoB;
+	std::vector<float> m_NormalX, m_NormalY, m_NormalZ;
+	std::vector<float> m_Depth;
+	uint32_t m_Current = 0;
+
+	float m_Time = 0.0f;
+};
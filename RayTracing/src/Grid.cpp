@@ -0,0 +1,289 @@
+#include "Grid.h"
+
+#include "SphereArray.h"
+
+#include "Walnut/Timer.h"
+
+#include <algorithm>
+#include <execution>
+#include <numeric>
+
+namespace Utils
+{
+	// 每个球体平均分到的单元数
+	static constexpr float CellDensity = 2.0f;
+	// 直径超过该单元数的球体不放入网格
+	static constexpr float LargeSphereCells = 4.0f;
+
+	static constexpr int MaxResolution = 1024;
+	static constexpr uint64_t MaxCellCount = 1 << 24;
+
+	template<typename Iterator, typename Function>
+	static void ForEach(bool parallel, Iterator begin, Iterator end, Function function)
+	{
+		if (parallel)
+			std::for_each(std::execution::par, begin, end, function);
+		else
+			std::for_each(begin, end, function);
+	}
+
+	template<typename Iterator, typename T, typename Reduce, typename Transform>
+	static T TransformReduce(bool parallel, Iterator begin, Iterator end, T init, Reduce reduce, Transform transform)
+	{
+		if (parallel)
+			return std::transform_reduce(std::execution::par, begin, end, init, reduce, transform);
+		return std::transform_reduce(begin, end, init, reduce, transform);
+	}
+
+	static AABB Merge(AABB a, const AABB& b)
+	{
+		a.Grow(b);
+		return a;
+	}
+}
+
+void Grid::Build(const std::vector<Sphere>& spheres, bool multithreaded)
+{
+	Walnut::Timer timer;
+
+	uint32_t sphereCount = (uint32_t)spheres.size();
+	if (sphereCount == 0)
+	{
+		Clear();
+		return;
+	}
+
+	m_SphereCount = sphereCount;
+	if (m_SphereIterator.size() != sphereCount)
+	{
+		m_SphereIterator.resize(sphereCount);
+		std::iota(m_SphereIterator.begin(), m_SphereIterator.end(), 0);
+		m_IsLarge.resize(sphereCount);
+	}
+
+	// 由球心分布与平均半径估计场景体积，得到每个球体约 CellDensity 个单元的单元边长
+	AABB centerBounds = Utils::TransformReduce(multithreaded, m_SphereIterator.begin(), m_SphereIterator.end(), AABB(), Utils::Merge,
+		[&](uint32_t i)
+		{
+			AABB bounds;
+			bounds.Grow(spheres[i].Position);
+			return bounds;
+		});
+	float radiusSum = Utils::TransformReduce(multithreaded, m_SphereIterator.begin(), m_SphereIterator.end(), 0.0f, std::plus<float>(),
+		[&](uint32_t i) { return glm::abs(spheres[i].Radius); });
+
+	glm::vec3 sceneExtent = glm::max(centerBounds.GetExtent() + 2.0f * radiusSum / sphereCount, glm::vec3(1e-4f));
+	float cellSize = std::cbrt(sceneExtent.x * sceneExtent.y * sceneExtent.z / (Utils::CellDensity * sphereCount));
+
+	// 大球体会覆盖大量单元，改为与每条光线直接求交
+	Utils::ForEach(multithreaded, m_SphereIterator.begin(), m_SphereIterator.end(), [&](uint32_t i)
+		{
+			m_IsLarge[i] = 2.0f * glm::abs(spheres[i].Radius) > Utils::LargeSphereCells * cellSize;
+		});
+
+	m_LargeSphereIndices.clear();
+	m_LargeSphereData.clear();
+	for (uint32_t i = 0; i < sphereCount; i++)
+	{
+		if (!m_IsLarge[i])
+			continue;
+
+		m_LargeSphereIndices.push_back(i);
+		m_LargeSphereData.emplace_back(spheres[i].Position, spheres[i].Radius * spheres[i].Radius);
+	}
+
+	m_Bounds = Utils::TransformReduce(multithreaded, m_SphereIterator.begin(), m_SphereIterator.end(), AABB(), Utils::Merge,
+		[&](uint32_t i)
+		{
+			AABB bounds;
+			if (!m_IsLarge[i])
+			{
+				glm::vec3 radius{ glm::abs(spheres[i].Radius) };
+				bounds.Min = spheres[i].Position - radius;
+				bounds.Max = spheres[i].Position + radius;
+			}
+			return bounds;
+		});
+
+	if (!m_Bounds.IsValid())
+	{
+		m_Resolution = glm::ivec3(0);
+		m_CellStart.clear();
+		m_ReferenceIndices.clear();
+		m_ReferenceData.clear();
+		m_BuildTime = timer.ElapsedMillis();
+		return;
+	}
+
+	glm::vec3 extent = glm::max(m_Bounds.GetExtent(), glm::vec3(1e-4f));
+	m_Bounds.Max = m_Bounds.Min + extent;
+
+	m_Resolution = glm::clamp(glm::ivec3(glm::ceil(extent / cellSize)), glm::ivec3(1), glm::ivec3(Utils::MaxResolution));
+	while ((uint64_t)m_Resolution.x * m_Resolution.y * m_Resolution.z > Utils::MaxCellCount)
+		m_Resolution = glm::max(m_Resolution / 2, glm::ivec3(1));
+
+	m_CellSize = extent / glm::vec3(m_Resolution);
+	m_InverseCellSize = 1.0f / m_CellSize;
+
+	// 计数排序：统计每个单元的引用数，前缀和得到起始位置，再原子地领取位置写入
+	uint32_t cellCount = (uint32_t)(m_Resolution.x * m_Resolution.y * m_Resolution.z);
+	if (m_CellCounts.size() != cellCount)
+		m_CellCounts = std::vector<std::atomic<uint32_t>>(cellCount);
+	else
+		Utils::ForEach(multithreaded, m_CellCounts.begin(), m_CellCounts.end(), [](std::atomic<uint32_t>& count) { count.store(0, std::memory_order_relaxed); });
+
+	auto forEachCell = [&](uint32_t i, auto&& function)
+	{
+		glm::vec3 radius{ glm::abs(spheres[i].Radius) };
+		glm::ivec3 first = GetCell(spheres[i].Position - radius);
+		glm::ivec3 last = GetCell(spheres[i].Position + radius);
+
+		for (int z = first.z; z <= last.z; z++)
+			for (int y = first.y; y <= last.y; y++)
+				for (int x = first.x; x <= last.x; x++)
+					function((uint32_t)(x + m_Resolution.x * (y + m_Resolution.y * z)));
+	};
+
+	Utils::ForEach(multithreaded, m_SphereIterator.begin(), m_SphereIterator.end(), [&](uint32_t i)
+		{
+			if (m_IsLarge[i])
+				return;
+
+			forEachCell(i, [&](uint32_t cell) { m_CellCounts[cell].fetch_add(1, std::memory_order_relaxed); });
+		});
+
+	auto loadCount = [](const std::atomic<uint32_t>& count) { return count.load(std::memory_order_relaxed); };
+	m_CellStart.resize(cellCount + 1);
+	if (multithreaded)
+		std::transform_exclusive_scan(std::execution::par, m_CellCounts.begin(), m_CellCounts.end(), m_CellStart.begin(), 0u, std::plus<uint32_t>(), loadCount);
+	else
+		std::transform_exclusive_scan(m_CellCounts.begin(), m_CellCounts.end(), m_CellStart.begin(), 0u, std::plus<uint32_t>(), loadCount);
+	m_CellStart[cellCount] = m_CellStart[cellCount - 1] + loadCount(m_CellCounts[cellCount - 1]);
+
+	uint32_t referenceCount = m_CellStart[cellCount];
+	m_ReferenceIndices.resize(referenceCount);
+	m_ReferenceData.resize(referenceCount);
+
+	Utils::ForEach(multithreaded, m_CellCounts.begin(), m_CellCounts.end(), [](std::atomic<uint32_t>& count) { count.store(0, std::memory_order_relaxed); });
+	Utils::ForEach(multithreaded, m_SphereIterator.begin(), m_SphereIterator.end(), [&](uint32_t i)
+		{
+			if (m_IsLarge[i])
+				return;
+
+			glm::vec4 data{ spheres[i].Position, spheres[i].Radius * spheres[i].Radius };
+			forEachCell(i, [&](uint32_t cell)
+				{
+					uint32_t index = m_CellStart[cell] + m_CellCounts[cell].fetch_add(1, std::memory_order_relaxed);
+					m_ReferenceIndices[index] = i;
+					m_ReferenceData[index] = data;
+				});
+		});
+
+	m_BuildTime = timer.ElapsedMillis();
+}
+
+void Grid::Clear()
+{
+	m_Bounds = AABB();
+	m_Resolution = glm::ivec3(0);
+	m_SphereCount = 0;
+	m_CellStart.clear();
+	m_CellCounts.clear();
+	m_ReferenceIndices.clear();
+	m_ReferenceData.clear();
+	m_LargeSphereIndices.clear();
+	m_LargeSphereData.clear();
+	m_SphereIterator.clear();
+	m_IsLarge.clear();
+	m_BuildTime = 0.0f;
+}
+
+size_t Grid::GetMemory() const
+{
+	return m_CellStart.size() * sizeof(uint32_t) + m_CellCounts.size() * sizeof(std::atomic<uint32_t>)
+		+ m_ReferenceIndices.size() * (sizeof(uint32_t) + sizeof(glm::vec4))
+		+ m_LargeSphereIndices.size() * (sizeof(uint32_t) + sizeof(glm::vec4));
+}
+
+glm::ivec3 Grid::GetCell(const glm::vec3& position) const
+{
+	glm::ivec3 cell = glm::ivec3(glm::floor((position - m_Bounds.Min) * m_InverseCellSize));
+	return glm::clamp(cell, glm::ivec3(0), m_Resolution - 1);
+}
+
+bool Grid::Intersect(const Ray& ray, float& hitDistance, int& objectIndex) const
+{
+	float a = glm::dot(ray.Direction, ray.Direction);
+
+	bool hit = false;
+	for (size_t i = 0; i < m_LargeSphereData.size(); i++)
+	{
+		if (SphereArray::IntersectSphere(ray, a, m_LargeSphereData[i], hitDistance))
+		{
+			objectIndex = (int)m_LargeSphereIndices[i];
+			hit = true;
+		}
+	}
+
+	if (m_CellStart.empty())
+		return hit;
+
+	glm::vec3 inverseDirection = SafeInverse(ray.Direction);
+	float tEnter = m_Bounds.Intersect(ray, inverseDirection, hitDistance);
+	if (tEnter == FLT_MAX)
+		return hit;
+
+	// 3D-DDA：tMax 为穿出当前单元各轴边界的距离，tDelta 为沿各轴穿过一个单元的距离
+	glm::ivec3 cell = GetCell(ray.Origin + ray.Direction * tEnter);
+	glm::ivec3 step, exit;
+	glm::vec3 tMax, tDelta;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (ray.Direction[axis] > 0.0f)
+		{
+			step[axis] = 1;
+			exit[axis] = m_Resolution[axis];
+			tMax[axis] = (m_Bounds.Min[axis] + (cell[axis] + 1) * m_CellSize[axis] - ray.Origin[axis]) * inverseDirection[axis];
+			tDelta[axis] = m_CellSize[axis] * inverseDirection[axis];
+		}
+		else if (ray.Direction[axis] < 0.0f)
+		{
+			step[axis] = -1;
+			exit[axis] = -1;
+			tMax[axis] = (m_Bounds.Min[axis] + cell[axis] * m_CellSize[axis] - ray.Origin[axis]) * inverseDirection[axis];
+			tDelta[axis] = -m_CellSize[axis] * inverseDirection[axis];
+		}
+		else
+		{
+			step[axis] = 0;
+			exit[axis] = -1;
+			tMax[axis] = FLT_MAX;
+			tDelta[axis] = FLT_MAX;
+		}
+	}
+
+	while (true)
+	{
+		uint32_t cellIndex = (uint32_t)(cell.x + m_Resolution.x * (cell.y + m_Resolution.y * cell.z));
+		for (uint32_t i = m_CellStart[cellIndex]; i < m_CellStart[cellIndex + 1]; i++)
+		{
+			if (SphereArray::IntersectSphere(ray, a, m_ReferenceData[i], hitDistance))
+			{
+				objectIndex = (int)m_ReferenceIndices[i];
+				hit = true;
+			}
+		}
+
+		// 球体可能跨越多个单元，交点落在当前单元之外时还要继续遍历，直到交点不远于当前单元出口
+		int axis = tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+		if (hitDistance <= tMax[axis])
+			break;
+
+		cell[axis] += step[axis];
+		if (cell[axis] == exit[axis])
+			break;
+		tMax[axis] += tDelta[axis];
+	}
+
+	return hit;
+}
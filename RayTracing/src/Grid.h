@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <vector>
+
+#include "AABB.h"
+#include "Ray.h"
+#include "Scene.h"
+
+// 均匀网格：每帧 O(n) 并行重建，适合所有球体每帧都在运动的场景，遍历使用 3D-DDA
+class Grid
+{
+public:
+	Grid() = default;
+
+	// 单元大小按球体数量与场景体积自动选取；跨越过多单元的大球体单独存放，每条光线都与之求交
+	void Build(const std::vector<Sphere>& spheres, bool multithreaded = true);
+	void Clear();
+
+	// 与 Renderer::TraceRay 的暴力求交结果一致：返回最近的 t > 0 交点
+	bool Intersect(const Ray& ray, float& hitDistance, int& objectIndex) const;
+
+	bool IsEmpty() const { return m_SphereCount == 0; }
+	uint32_t GetSphereCount() const { return m_SphereCount; }
+	glm::ivec3 GetResolution() const { return m_Resolution; }
+	glm::vec3 GetCellSize() const { return m_CellSize; }
+	uint32_t GetReferenceCount() const { return (uint32_t)m_ReferenceIndices.size(); }
+	uint32_t GetLargeSphereCount() const { return (uint32_t)m_LargeSphereIndices.size(); }
+	size_t GetMemory() const;
+	float GetBuildTime() const { return m_BuildTime; }
+private:
+	glm::ivec3 GetCell(const glm::vec3& position) const;
+private:
+	AABB m_Bounds;
+	glm::ivec3 m_Resolution{ 0 };
+	glm::vec3 m_CellSize{ 0.0f };
+	glm::vec3 m_InverseCellSize{ 0.0f };
+	uint32_t m_SphereCount = 0;
+
+	// 第 i 个单元的引用位于 [m_CellStart[i], m_CellStart[i + 1])
+	std::vector<uint32_t> m_CellStart;
+	std::vector<std::atomic<uint32_t>> m_CellCounts;
+
+	// 按单元顺序排列的球体索引与球体数据（xyz = 球心，w = 半径平方）
+	std::vector<uint32_t> m_ReferenceIndices;
+	std::vector<glm::vec4> m_ReferenceData;
+
+	std::vector<uint32_t> m_LargeSphereIndices;
+	std::vector<glm::vec4> m_LargeSphereData;
+
+	std::vector<uint32_t> m_SphereIterator;
+	std::vector<uint8_t> m_IsLarge;
+
+	float m_BuildTime = 0.0f;
+};
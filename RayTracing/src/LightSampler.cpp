@@ -0,0 +1,133 @@
+#include "LightSampler.h"
+
+#include <glm/gtc/constants.hpp>
+
+namespace Utils
+{
+	// 球体从 position 看去所张圆锥的 1 - cos(半角)，position 在球内时返回 0。
+	// 远处的小光源 cos 接近 1，直接相减会损失精度，改用 sin^2 / (1 + cos)
+	static float ConeSolidAngleFactor(const glm::vec3& position, const glm::vec4& sphere, glm::vec3& toCenter, float& distance)
+	{
+		toCenter = glm::vec3(sphere) - position;
+		float distanceSquared = glm::dot(toCenter, toCenter);
+		float sinSquared = sphere.w * sphere.w / distanceSquared;
+		if (sinSquared >= 1.0f)
+			return 0.0f;
+
+		distance = glm::sqrt(distanceSquared);
+		toCenter /= distance;
+		return sinSquared / (1.0f + glm::sqrt(1.0f - sinSquared));
+	}
+}
+
+void LightSampler::Build(const Scene& scene, Type type)
+{
+	m_Scene = &scene;
+	m_Type = type;
+
+	// 球体发出的总功率正比于亮度 × 表面积
+	std::vector<glm::vec4> lights;
+	std::vector<float> powers;
+	std::vector<uint32_t> objects;
+	for (uint32_t i = 0; i < (uint32_t)scene.Sphere.size(); i++)
+	{
+		const Sphere& sphere = scene.Sphere[i];
+		glm::vec3 emission = scene.Materials[sphere.MaterialIndex].GetEmission();
+		if (emission == glm::vec3(0.0f))
+			continue;
+
+		lights.emplace_back(sphere.Position, sphere.Radius);
+		powers.push_back(glm::dot(emission, glm::vec3(0.2126f, 0.7152f, 0.0722f)) * sphere.Radius * sphere.Radius);
+		objects.push_back(i);
+	}
+
+	// 光源的位置、大小与功率都不变时沿用上次的光源树
+	if (lights != m_Lights || powers != m_LightPowers || objects != m_LightObjects || m_ObjectLights.size() != scene.Sphere.size())
+	{
+		m_Lights.swap(lights);
+		m_LightPowers.swap(powers);
+		m_LightObjects.swap(objects);
+
+		m_ObjectLights.assign(scene.Sphere.size(), -1);
+		for (uint32_t i = 0; i < (uint32_t)m_LightObjects.size(); i++)
+			m_ObjectLights[m_LightObjects[i]] = (int)i;
+
+		m_LightTreeDirty = true;
+	}
+
+	if (m_Type == Type::LightTree && m_LightTreeDirty)
+	{
+		m_LightTree.Build(m_Lights, m_LightPowers);
+		m_LightTreeDirty = false;
+	}
+}
+
+float LightSampler::SelectionPdf(const glm::vec3& position, const glm::vec3& normal, uint32_t light) const
+{
+	if (m_Type == Type::LightTree)
+		return m_LightTree.Pdf(position, normal, light);
+	return 1.0f / m_Lights.size();
+}
+
+bool LightSampler::SampleLight(const glm::vec3& position, const glm::vec3& normal, const glm::vec3& random, Sample& sample) const
+{
+	if (m_Lights.empty())
+		return false;
+
+	uint32_t light;
+	float selectionPdf;
+	if (m_Type == Type::LightTree)
+	{
+		if (!m_LightTree.Sample(position, normal, random.x, light, selectionPdf))
+			return false;
+	}
+	else
+	{
+		uint32_t lightCount = (uint32_t)m_Lights.size();
+		light = glm::min((uint32_t)(random.x * lightCount), lightCount - 1);
+		selectionPdf = 1.0f / lightCount;
+	}
+	sample.ObjectIndex = (int)m_LightObjects[light];
+
+	const glm::vec4& sphere = m_Lights[light];
+	glm::vec3 axis;
+	float oneMinusCosMax = Utils::ConeSolidAngleFactor(position, sphere, axis, sample.Distance);
+	if (oneMinusCosMax <= 0.0f)
+		return false;
+
+	// cos 在 [cosMax, 1] 上均匀分布即为圆锥内立体角均匀分布。远处的小光源 cos 接近 1，直接由 cos 求 sin、再与球面求交都会损失精度，
+	// 采样点集中到球面上的几圈：sin^2 改由 1 - cos 求出，球面上的点由它在球心处与轴的夹角 alpha 直接给出（PBRT v4 的做法）
+	float sinSquaredMax = sphere.w * sphere.w / (sample.Distance * sample.Distance);
+	float oneMinusCos = random.y * oneMinusCosMax;
+	float sinSquared = oneMinusCos * (2.0f - oneMinusCos);
+	float cosAlpha = sinSquared / glm::sqrt(sinSquaredMax) + (1.0f - oneMinusCos) * glm::sqrt(glm::max(1.0f - sinSquared / sinSquaredMax, 0.0f));
+	float sinAlpha = glm::sqrt(glm::max(1.0f - cosAlpha * cosAlpha, 0.0f));
+	float phi = glm::two_pi<float>() * random.z;
+
+	// 以轴为 z 的正交基（Duff et al. 2017）
+	float sign = axis.z >= 0.0f ? 1.0f : -1.0f;
+	float a = -1.0f / (sign + axis.z);
+	float b = axis.x * axis.y * a;
+	glm::vec3 tangent(1.0f + sign * axis.x * axis.x * a, sign * b, -sign * axis.x);
+	glm::vec3 bitangent(b, sign + axis.y * axis.y * a, -axis.y);
+
+	sample.Normal = -(tangent * (sinAlpha * glm::cos(phi)) + bitangent * (sinAlpha * glm::sin(phi)) + axis * cosAlpha);
+	sample.Direction = glm::normalize(glm::vec3(sphere) + sample.Normal * sphere.w - position);
+	sample.Pdf = selectionPdf / (glm::two_pi<float>() * oneMinusCosMax);
+	return true;
+}
+
+float LightSampler::Pdf(const glm::vec3& position, const glm::vec3& normal, int objectIndex) const
+{
+	int light = objectIndex < (int)m_ObjectLights.size() ? m_ObjectLights[objectIndex] : -1;
+	if (light < 0)
+		return 0.0f;
+
+	glm::vec3 axis;
+	float distance;
+	float oneMinusCosMax = Utils::ConeSolidAngleFactor(position, m_Lights[light], axis, distance);
+	if (oneMinusCosMax <= 0.0f)
+		return 0.0f;
+
+	return SelectionPdf(position, normal, (uint32_t)light) / (glm::two_pi<float>() * oneMinusCosMax);
+}
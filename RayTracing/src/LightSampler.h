@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Scene.h"
+#include "LightTree.h"
+
+// 自发光球体的直接光照采样：先选出一个光源，再在它从着色点看去所张的圆锥内均匀采样方向（立体角采样）
+class LightSampler
+{
+public:
+	// 选择光源的方式
+	enum class Type
+	{
+		Uniform = 0, // 均匀选择，光源很多时大部分采样落在对着色点几乎没有贡献的光源上
+		LightTree    // 按光源树节点对着色点的重要性选择
+	};
+
+	struct Sample
+	{
+		glm::vec3 Direction;
+		float Distance; // 着色点到球心的距离，阴影光线只需检查这之前的遮挡
+		glm::vec3 Normal; // 采样点处的球面法线，即采样点相对球心的方向
+		float Pdf;      // 立体角上的概率密度，已乘上选中该光源的概率
+		int ObjectIndex;
+	};
+
+	LightSampler() = default;
+
+	// 收集 GetEmission() 不为零的球体；光源（或选择方式）改变时才重建光源树
+	void Build(const Scene& scene, Type type = Type::LightTree);
+
+	// random 为 [0, 1) 的三个随机数；没有可选的光源或着色点在所选光源内部时返回 false
+	bool SampleLight(const glm::vec3& position, const glm::vec3& normal, const glm::vec3& random, Sample& sample) const;
+	// SampleLight 从同一着色点采样到指向 objectIndex 的某一方向的概率密度，用于多重重要性采样
+	float Pdf(const glm::vec3& position, const glm::vec3& normal, int objectIndex) const;
+
+	Type GetType() const { return m_Type; }
+	uint32_t GetLightCount() const { return (uint32_t)m_Lights.size(); }
+	// 上次 Build 时场景中的球体数
+	uint32_t GetObjectCount() const { return (uint32_t)m_ObjectLights.size(); }
+	const LightTree& GetLightTree() const { return m_LightTree; }
+private:
+	float SelectionPdf(const glm::vec3& position, const glm::vec3& normal, uint32_t light) const;
+private:
+	const Scene* m_Scene = nullptr;
+	Type m_Type = Type::LightTree;
+
+	// 光源的球心与半径、功率（亮度 × 表面积）以及对应的球体索引
+	std::vector<glm::vec4> m_Lights;
+	std::vector<float> m_LightPowers;
+	std::vector<uint32_t> m_LightObjects;
+	// 球体索引到光源索引，不发光的球体为 -1
+	std::vector<int> m_ObjectLights;
+
+	LightTree m_LightTree;
+	bool m_LightTreeDirty = true;
+};
@@ -0,0 +1,178 @@
+#include "LightTree.h"
+
+#include "AABB.h"
+
+#include "Walnut/Timer.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace Utils
+{
+	// 节点对着色点的重要性：功率 × 包围球所张圆锥内与法线夹角最小方向的余弦 / 距离平方。
+	// 只是上界的近似，但必须保守：可能照亮着色点的节点重要性不能为 0
+	static float Importance(const glm::vec3& position, const glm::vec3& normal, const LightTree::Node& node)
+	{
+		glm::vec3 toCenter = node.Center - position;
+		float distanceSquared = glm::dot(toCenter, toCenter);
+		float radiusSquared = node.Radius * node.Radius;
+
+		// 着色点在包围球内，任何方向都可能有光源
+		if (distanceSquared <= radiusSquared)
+			return node.Power / glm::max(radiusSquared, 1e-8f);
+
+		float distance = glm::sqrt(distanceSquared);
+		float cosAngle = glm::dot(normal, toCenter) / distance;
+		float sinConeSquared = radiusSquared / distanceSquared;
+		float cosCone = glm::sqrt(1.0f - sinConeSquared);
+
+		// 法线不在圆锥内时取圆锥边缘离法线最近的方向，cos(夹角 - 圆锥半角)
+		float cosBound = 1.0f;
+		if (cosAngle < cosCone)
+		{
+			float sinAngle = glm::sqrt(glm::max(1.0f - cosAngle * cosAngle, 0.0f));
+			cosBound = cosAngle * cosCone + sinAngle * glm::sqrt(sinConeSquared);
+			if (cosBound <= 0.0f)
+				return 0.0f;
+		}
+
+		return node.Power * cosBound / distanceSquared;
+	}
+}
+
+void LightTree::Build(const std::vector<glm::vec4>& spheres, const std::vector<float>& powers)
+{
+	Walnut::Timer timer;
+
+	uint32_t lightCount = (uint32_t)spheres.size();
+	m_Nodes.clear();
+	m_LightIndices.resize(lightCount);
+	std::iota(m_LightIndices.begin(), m_LightIndices.end(), 0u);
+	m_LightNodes.assign(lightCount, InvalidIndex);
+
+	if (lightCount > 0)
+	{
+		m_Nodes.reserve(lightCount * 2 - 1);
+		m_Nodes.emplace_back().Parent = InvalidIndex;
+		BuildNode(0, 0, lightCount, spheres, powers);
+	}
+
+	m_BuildTime = timer.ElapsedMillis();
+}
+
+void LightTree::Clear()
+{
+	m_Nodes.clear();
+	m_LightIndices.clear();
+	m_LightNodes.clear();
+}
+
+// 沿质心范围最大的轴在中位数处划分，树的深度为 log2(光源数)
+void LightTree::BuildNode(uint32_t nodeIndex, uint32_t first, uint32_t last, const std::vector<glm::vec4>& spheres, const std::vector<float>& powers)
+{
+	Node& node = m_Nodes[nodeIndex];
+	if (last - first == 1)
+	{
+		uint32_t light = m_LightIndices[first];
+		node.Center = glm::vec3(spheres[light]);
+		node.Radius = spheres[light].w;
+		node.Power = powers[light];
+		node.LightIndex = light;
+		m_LightNodes[light] = nodeIndex;
+		return;
+	}
+
+	AABB bounds, centroidBounds;
+	float power = 0.0f;
+	for (uint32_t i = first; i < last; i++)
+	{
+		const glm::vec4& sphere = spheres[m_LightIndices[i]];
+		glm::vec3 center(sphere);
+		bounds.Grow(center - sphere.w);
+		bounds.Grow(center + sphere.w);
+		centroidBounds.Grow(center);
+		power += powers[m_LightIndices[i]];
+	}
+	node.Center = bounds.GetCenter();
+	node.Radius = glm::length(bounds.GetExtent()) * 0.5f;
+	node.Power = power;
+
+	glm::vec3 extent = centroidBounds.GetExtent();
+	int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+	uint32_t middle = (first + last) / 2;
+	std::nth_element(m_LightIndices.begin() + first, m_LightIndices.begin() + middle, m_LightIndices.begin() + last,
+		[&](uint32_t a, uint32_t b) { return spheres[a][axis] < spheres[b][axis]; });
+
+	// 已预留全部节点，新增节点不会使 node 失效
+	uint32_t leftChild = (uint32_t)m_Nodes.size();
+	node.LeftChild = leftChild;
+	m_Nodes.emplace_back().Parent = nodeIndex;
+	m_Nodes.emplace_back().Parent = nodeIndex;
+
+	BuildNode(leftChild, first, middle, spheres, powers);
+	BuildNode(leftChild + 1, middle, last, spheres, powers);
+}
+
+float LightTree::LeftProbability(const glm::vec3& position, const glm::vec3& normal, const Node& node) const
+{
+	float left = Utils::Importance(position, normal, m_Nodes[node.LeftChild]);
+	float right = Utils::Importance(position, normal, m_Nodes[node.LeftChild + 1]);
+	if (left + right <= 0.0f)
+		return -1.0f;
+	return left / (left + right);
+}
+
+bool LightTree::Sample(const glm::vec3& position, const glm::vec3& normal, float random, uint32_t& light, float& pdf) const
+{
+	if (m_Nodes.empty())
+		return false;
+
+	// 每层用同一个随机数选择子节点，再把它重新映射到 [0, 1)
+	uint32_t nodeIndex = 0;
+	pdf = 1.0f;
+	while (!m_Nodes[nodeIndex].IsLeaf())
+	{
+		const Node& node = m_Nodes[nodeIndex];
+		float probability = LeftProbability(position, normal, node);
+		if (probability < 0.0f)
+			return false;
+
+		if (random < probability)
+		{
+			nodeIndex = node.LeftChild;
+			random /= probability;
+			pdf *= probability;
+		}
+		else
+		{
+			nodeIndex = node.LeftChild + 1;
+			random = (random - probability) / (1.0f - probability);
+			pdf *= 1.0f - probability;
+		}
+		random = glm::min(random, 0.99999994f);
+	}
+
+	light = m_Nodes[nodeIndex].LightIndex;
+	return true;
+}
+
+// 从叶子向上，累乘每层选中该分支的概率
+float LightTree::Pdf(const glm::vec3& position, const glm::vec3& normal, uint32_t light) const
+{
+	if (light >= m_LightNodes.size())
+		return 0.0f;
+
+	float pdf = 1.0f;
+	uint32_t nodeIndex = m_LightNodes[light];
+	while (nodeIndex != 0)
+	{
+		const Node& parent = m_Nodes[m_Nodes[nodeIndex].Parent];
+		float probability = LeftProbability(position, normal, parent);
+		if (probability < 0.0f)
+			return 0.0f;
+
+		pdf *= nodeIndex == parent.LeftChild ? probability : 1.0f - probability;
+		nodeIndex = m_Nodes[nodeIndex].Parent;
+	}
+	return pdf;
+}
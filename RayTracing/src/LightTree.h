@@ -0,0 +1,50 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+// 光源树：建在自发光球体上的二叉层次结构，每个节点保存子树的包围球与总功率。
+// 选择光源时从根开始，按两个子节点对着色点的重要性（功率 × 朝向上界 / 距离平方）随机下降到叶子，
+// 光源多时绝大部分采样落在对着色点贡献大的光源上；球体各向同性发光，朝向上界只考虑着色点的法线一侧
+class LightTree
+{
+public:
+	struct Node
+	{
+		glm::vec3 Center; // 子树所有球体的包围球
+		float Radius = 0.0f;
+		float Power = 0.0f;
+		uint32_t Parent = 0;
+		uint32_t LeftChild = 0; // 右子节点紧随其后
+		uint32_t LightIndex = InvalidIndex; // 叶节点的光源索引，内部节点为 InvalidIndex
+
+		bool IsLeaf() const { return LightIndex != InvalidIndex; }
+	};
+
+	static constexpr uint32_t InvalidIndex = 0xffffffff;
+
+	LightTree() = default;
+
+	// spheres 为每个光源的球心（xyz）与半径（w），powers 为对应的功率；每个叶节点一个光源
+	void Build(const std::vector<glm::vec4>& spheres, const std::vector<float>& powers);
+	void Clear();
+
+	// random 为 [0, 1) 的随机数；着色点法线一侧没有任何光源时返回 false
+	bool Sample(const glm::vec3& position, const glm::vec3& normal, float random, uint32_t& light, float& pdf) const;
+	// Sample 在同一着色点选中 light 的概率
+	float Pdf(const glm::vec3& position, const glm::vec3& normal, uint32_t light) const;
+
+	bool IsEmpty() const { return m_Nodes.empty(); }
+	uint32_t GetNodeCount() const { return (uint32_t)m_Nodes.size(); }
+	float GetBuildTime() const { return m_BuildTime; }
+private:
+	void BuildNode(uint32_t nodeIndex, uint32_t first, uint32_t last, const std::vector<glm::vec4>& spheres, const std::vector<float>& powers);
+	// 选中 node 两个子节点中左子节点的概率，两者重要性都为 0 时返回负数
+	float LeftProbability(const glm::vec3& position, const glm::vec3& normal, const Node& node) const;
+private:
+	std::vector<Node> m_Nodes;
+	std::vector<uint32_t> m_LightIndices; // 构建时按划分重排的光源索引
+	std::vector<uint32_t> m_LightNodes;   // 每个光源所在的叶节点
+
+	float m_BuildTime = 0.0f;
+};
@@ -0,0 +1,102 @@
+#include "PathQueue.h"
+
+void PathQueue::Resize(uint32_t capacity)
+{
+	for (std::vector<float>* component : { &OriginX, &OriginY, &OriginZ, &DirectionX, &DirectionY, &DirectionZ,
+		&ThroughputR, &ThroughputG, &ThroughputB, &NormalX, &NormalY, &NormalZ, &BSDFPdf, &HitDistance })
+		component->resize(capacity);
+
+	PixelIndex.resize(capacity);
+	Seed.resize(capacity);
+	ObjectIndex.resize(capacity);
+
+	Count = 0;
+}
+
+void PathQueue::SetRay(uint32_t index, const Ray& ray)
+{
+	OriginX[index] = ray.Origin.x;
+	OriginY[index] = ray.Origin.y;
+	OriginZ[index] = ray.Origin.z;
+	DirectionX[index] = ray.Direction.x;
+	DirectionY[index] = ray.Direction.y;
+	DirectionZ[index] = ray.Direction.z;
+}
+
+void PathQueue::SetThroughput(uint32_t index, const glm::vec3& throughput)
+{
+	ThroughputR[index] = throughput.r;
+	ThroughputG[index] = throughput.g;
+	ThroughputB[index] = throughput.b;
+}
+
+void PathQueue::SetNormal(uint32_t index, const glm::vec3& normal)
+{
+	NormalX[index] = normal.x;
+	NormalY[index] = normal.y;
+	NormalZ[index] = normal.z;
+}
+
+void PathQueue::CopyPath(uint32_t to, const PathQueue& source, uint32_t from)
+{
+	OriginX[to] = source.OriginX[from];
+	OriginY[to] = source.OriginY[from];
+	OriginZ[to] = source.OriginZ[from];
+	DirectionX[to] = source.DirectionX[from];
+	DirectionY[to] = source.DirectionY[from];
+	DirectionZ[to] = source.DirectionZ[from];
+	ThroughputR[to] = source.ThroughputR[from];
+	ThroughputG[to] = source.ThroughputG[from];
+	ThroughputB[to] = source.ThroughputB[from];
+	PixelIndex[to] = source.PixelIndex[from];
+	Seed[to] = source.Seed[from];
+	NormalX[to] = source.NormalX[from];
+	NormalY[to] = source.NormalY[from];
+	NormalZ[to] = source.NormalZ[from];
+	BSDFPdf[to] = source.BSDFPdf[from];
+}
+
+void ShadowQueue::Resize(uint32_t capacity)
+{
+	for (std::vector<float>* component : { &OriginX, &OriginY, &OriginZ, &DirectionX, &DirectionY, &DirectionZ,
+		&ContributionR, &ContributionG, &ContributionB, &Distance })
+		component->resize(capacity);
+
+	PixelIndex.resize(capacity);
+	LightIndex.resize(capacity);
+
+	Count = 0;
+}
+
+void ShadowQueue::SetRay(uint32_t index, const Ray& ray)
+{
+	OriginX[index] = ray.Origin.x;
+	OriginY[index] = ray.Origin.y;
+	OriginZ[index] = ray.Origin.z;
+	DirectionX[index] = ray.Direction.x;
+	DirectionY[index] = ray.Direction.y;
+	DirectionZ[index] = ray.Direction.z;
+}
+
+void ShadowQueue::SetContribution(uint32_t index, const glm::vec3& contribution)
+{
+	ContributionR[index] = contribution.r;
+	ContributionG[index] = contribution.g;
+	ContributionB[index] = contribution.b;
+}
+
+void ShadowQueue::CopyShadowRay(uint32_t to, const ShadowQueue& source, uint32_t from)
+{
+	OriginX[to] = source.OriginX[from];
+	OriginY[to] = source.OriginY[from];
+	OriginZ[to] = source.OriginZ[from];
+	DirectionX[to] = source.DirectionX[from];
+	DirectionY[to] = source.DirectionY[from];
+	DirectionZ[to] = source.DirectionZ[from];
+	ContributionR[to] = source.ContributionR[from];
+	ContributionG[to] = source.ContributionG[from];
+	ContributionB[to] = source.ContributionB[from];
+	PixelIndex[to] = source.PixelIndex[from];
+	Distance[to] = source.Distance[from];
+	LightIndex[to] = source.LightIndex[from];
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Ray.h"
+
+// 波前路径追踪的路径队列：每条路径的状态按分量分开连续存放，各阶段顺序扫描整个队列
+struct PathQueue
+{
+	std::vector<float> OriginX, OriginY, OriginZ;
+	std::vector<float> DirectionX, DirectionY, DirectionZ;
+	std::vector<float> ThroughputR, ThroughputG, ThroughputB;
+	std::vector<uint32_t> PixelIndex;
+	std::vector<uint32_t> Seed;
+	// 上一次弹射点的法线与弹射方向的 BSDF 概率密度（主光线为 0），命中光源时用于多重重要性采样
+	std::vector<float> NormalX, NormalY, NormalZ;
+	std::vector<float> BSDFPdf;
+
+	// Extend 阶段写入；Shade 阶段把终止的路径的 ObjectIndex 置为 -1，压缩时剔除
+	std::vector<float> HitDistance;
+	std::vector<int> ObjectIndex;
+
+	uint32_t Count = 0;
+
+	void Resize(uint32_t capacity);
+
+	Ray GetRay(uint32_t index) const
+	{
+		return { { OriginX[index], OriginY[index], OriginZ[index] }, { DirectionX[index], DirectionY[index], DirectionZ[index] } };
+	}
+	void SetRay(uint32_t index, const Ray& ray);
+
+	glm::vec3 GetThroughput(uint32_t index) const { return { ThroughputR[index], ThroughputG[index], ThroughputB[index] }; }
+	void SetThroughput(uint32_t index, const glm::vec3& throughput);
+
+	glm::vec3 GetNormal(uint32_t index) const { return { NormalX[index], NormalY[index], NormalZ[index] }; }
+	void SetNormal(uint32_t index, const glm::vec3& normal);
+
+	// 把 source 的第 from 条路径复制到第 to 条，不含 Extend 结果
+	void CopyPath(uint32_t to, const PathQueue& source, uint32_t from);
+};
+
+// 波前路径追踪的阴影光线队列：Shade 阶段按路径序号写入，压缩掉没有光源样本的项后由遮挡阶段追踪，
+// 最后把未被遮挡的贡献累加到像素
+struct ShadowQueue
+{
+	std::vector<float> OriginX, OriginY, OriginZ;
+	std::vector<float> DirectionX, DirectionY, DirectionZ;
+	// 未被遮挡时的直接光照，已乘路径吞吐量
+	std::vector<float> ContributionR, ContributionG, ContributionB;
+	std::vector<uint32_t> PixelIndex;
+	// 到光源球心的距离，以及目标光源的球体索引；没有光源样本或被遮挡时 LightIndex 为 -1
+	std::vector<float> Distance;
+	std::vector<int> LightIndex;
+
+	uint32_t Count = 0;
+
+	void Resize(uint32_t capacity);
+
+	Ray GetRay(uint32_t index) const
+	{
+		return { { OriginX[index], OriginY[index], OriginZ[index] }, { DirectionX[index], DirectionY[index], DirectionZ[index] } };
+	}
+	void SetRay(uint32_t index, const Ray& ray);
+
+	glm::vec3 GetContribution(uint32_t index) const { return { ContributionR[index], ContributionG[index], ContributionB[index] }; }
+	void SetContribution(uint32_t index, const glm::vec3& contribution);
+
+	void CopyShadowRay(uint32_t to, const ShadowQueue& source, uint32_t from);
+};
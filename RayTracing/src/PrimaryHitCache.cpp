@@ -0,0 +1,28 @@
+#include "PrimaryHitCache.h"
+
+void PrimaryHitCache::Resize(uint32_t width, uint32_t height)
+{
+	if (width == m_Width && height == m_Height)
+		return;
+
+	m_Width = width;
+	m_Height = height;
+	m_Valid = false;
+
+	m_Position.resize(width * height);
+	m_Normal.resize(width * height);
+	m_ObjectIndex.resize(width * height);
+}
+
+void PrimaryHitCache::Clear()
+{
+	m_Width = m_Height = 0;
+	m_Valid = false;
+
+	m_Position.clear();
+	m_Position.shrink_to_fit();
+	m_Normal.clear();
+	m_Normal.shrink_to_fit();
+	m_ObjectIndex.clear();
+	m_ObjectIndex.shrink_to_fit();
+}
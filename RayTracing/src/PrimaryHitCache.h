@@ -0,0 +1,62 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+// 主光线首次命中的缓存（G-buffer）：相机与场景不变时每帧的主光线完全相同，首次命中只需追踪一次
+// 每像素保存命中位置、八面体编码的法线（2 x 16 位）与球体索引，共 20 字节
+class PrimaryHitCache
+{
+public:
+	PrimaryHitCache() = default;
+
+	// 分辨率变化时重新分配并失效
+	void Resize(uint32_t width, uint32_t height);
+	void Clear();
+
+	// 所有像素都已写入，之后的帧可以直接读取
+	bool IsValid() const { return m_Valid; }
+	void SetValid(bool valid) { m_Valid = valid && !m_ObjectIndex.empty(); }
+
+	// objectIndex 为 -1 表示未命中
+	void Store(uint32_t pixel, const glm::vec3& position, const glm::vec3& normal, int objectIndex)
+	{
+		m_Position[pixel] = position;
+		m_Normal[pixel] = EncodeNormal(normal);
+		m_ObjectIndex[pixel] = objectIndex;
+	}
+
+	int GetObjectIndex(uint32_t pixel) const { return m_ObjectIndex[pixel]; }
+	const glm::vec3& GetPosition(uint32_t pixel) const { return m_Position[pixel]; }
+	glm::vec3 GetNormal(uint32_t pixel) const { return DecodeNormal(m_Normal[pixel]); }
+
+	size_t GetMemory() const { return m_ObjectIndex.size() * (sizeof(glm::vec3) + sizeof(uint32_t) + sizeof(int)); }
+
+	// 单位向量投影到八面体再展开到 [-1, 1]^2，两个分量各量化为 16 位
+	static uint32_t EncodeNormal(const glm::vec3& normal)
+	{
+		glm::vec2 p = glm::vec2(normal) / (glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z));
+		if (normal.z < 0.0f)
+			p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * glm::vec2(p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f);
+
+		glm::uvec2 q = glm::uvec2(glm::round(glm::clamp(p * 0.5f + 0.5f, 0.0f, 1.0f) * 65535.0f));
+		return q.x | (q.y << 16);
+	}
+
+	static glm::vec3 DecodeNormal(uint32_t encoded)
+	{
+		glm::vec2 p = glm::vec2(encoded & 0xffff, encoded >> 16) / 65535.0f * 2.0f - 1.0f;
+		glm::vec3 normal{ p.x, p.y, 1.0f - glm::abs(p.x) - glm::abs(p.y) };
+		float t = glm::max(-normal.z, 0.0f);
+		normal.x += normal.x >= 0.0f ? -t : t;
+		normal.y += normal.y >= 0.0f ? -t : t;
+		return glm::normalize(normal);
+	}
+private:
+	uint32_t m_Width = 0, m_Height = 0;
+	bool m_Valid = false;
+
+	std::vector<glm::vec3> m_Position;
+	std::vector<uint32_t> m_Normal;
+	std::vector<int> m_ObjectIndex;
+};
@@ -0,0 +1,87 @@
+#include "RadixSort.h"
+
+#include <algorithm>
+
+namespace Utils
+{
+	static constexpr uint32_t RadixBits = 8;
+	static constexpr uint32_t RadixSize = 1 << RadixBits;
+	static constexpr uint32_t ChunkSize = 16384;
+}
+
+void RadixSort::SortPairs(ThreadPool& pool, std::vector<uint32_t>& keys, std::vector<uint32_t>& values,
+	std::vector<uint32_t>& tempKeys, std::vector<uint32_t>& tempValues, uint32_t count, uint32_t keyBits)
+{
+	using namespace Utils;
+
+	tempKeys.resize(std::max<size_t>(tempKeys.size(), count));
+	tempValues.resize(std::max<size_t>(tempValues.size(), count));
+
+	uint32_t chunkCount = (count + ChunkSize - 1) / ChunkSize;
+	// 每块每个桶的计数，前缀和后变为写入位置；按桶优先排列，整体前缀和即得到稳定的全局位置
+	std::vector<uint32_t> histogram(RadixSize * chunkCount);
+
+	uint32_t* sourceKeys = keys.data();
+	uint32_t* sourceValues = values.data();
+	uint32_t* targetKeys = tempKeys.data();
+	uint32_t* targetValues = tempValues.data();
+
+	for (uint32_t shift = 0; shift < keyBits; shift += RadixBits)
+	{
+		pool.ParallelFor(chunkCount, [&](uint32_t chunk, uint32_t threadIndex)
+			{
+				uint32_t counts[RadixSize] = {};
+				uint32_t last = std::min(chunk * ChunkSize + ChunkSize, count);
+				for (uint32_t i = chunk * ChunkSize; i < last; i++)
+					counts[(sourceKeys[i] >> shift) & (RadixSize - 1)]++;
+
+				for (uint32_t digit = 0; digit < RadixSize; digit++)
+					histogram[digit * chunkCount + chunk] = counts[digit];
+			});
+
+		// 所有键在这一位上相同时跳过这一趟
+		bool uniform = false;
+		for (uint32_t digit = 0; digit < RadixSize && !uniform; digit++)
+		{
+			uint32_t total = 0;
+			for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+				total += histogram[digit * chunkCount + chunk];
+			uniform = total == count;
+		}
+		if (uniform)
+			continue;
+
+		uint32_t offset = 0;
+		for (uint32_t& bucket : histogram)
+		{
+			uint32_t bucketCount = bucket;
+			bucket = offset;
+			offset += bucketCount;
+		}
+
+		pool.ParallelFor(chunkCount, [&](uint32_t chunk, uint32_t threadIndex)
+			{
+				uint32_t offsets[RadixSize];
+				for (uint32_t digit = 0; digit < RadixSize; digit++)
+					offsets[digit] = histogram[digit * chunkCount + chunk];
+
+				uint32_t last = std::min(chunk * ChunkSize + ChunkSize, count);
+				for (uint32_t i = chunk * ChunkSize; i < last; i++)
+				{
+					uint32_t position = offsets[(sourceKeys[i] >> shift) & (RadixSize - 1)]++;
+					targetKeys[position] = sourceKeys[i];
+					targetValues[position] = sourceValues[i];
+				}
+			});
+
+		std::swap(sourceKeys, targetKeys);
+		std::swap(sourceValues, targetValues);
+	}
+
+	// 奇数趟后结果在临时缓冲区中
+	if (sourceKeys != keys.data())
+	{
+		std::copy(sourceKeys, sourceKeys + count, keys.data());
+		std::copy(sourceValues, sourceValues + count, values.data());
+	}
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "ThreadPool.h"
+
+// 并行 LSD 基数排序，每趟 8 位，稳定
+namespace RadixSort
+{
+	// 按 keys 对 (keys, values) 排序，只比较低 keyBits 位；temp 为同样大小的临时缓冲区，结果写回 keys 与 values
+	void SortPairs(ThreadPool& pool, std::vector<uint32_t>& keys, std::vector<uint32_t>& values,
+		std::vector<uint32_t>& tempKeys, std::vector<uint32_t>& tempValues, uint32_t count, uint32_t keyBits = 32);
+}
@@ -1,7 +1,56 @@
+#pragma once
+
 #include <glm/glm.hpp>
 
+#include <cmath>
+
 struct Ray
 {
 	glm::vec3 Origin;
 	glm::vec3 Direction;
-};
\ No newline at end of file
+};
+
+// 方向的倒数，供平板法求交；分量为 0 时避免 0 * inf 产生 NaN
+inline glm::vec3 SafeInverse(const glm::vec3& direction)
+{
+	glm::vec3 inverse;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float d = direction[axis];
+		inverse[axis] = 1.0f / (glm::abs(d) > 1e-20f ? d : std::copysign(1e-20f, d));
+	}
+	return inverse;
+}
+
+// 针孔相机的主光线：方向在像素坐标上是仿射的，像素 (x, y) 的方向为 normalize(Base + x * StepX + y * StepY)，无需逐像素缓存
+// x、y 可以带小数，用于亚像素抖动
+struct PrimaryRayGenerator
+{
+	glm::vec3 Origin{ 0.0f };
+	glm::vec3 Base{ 0.0f, 0.0f, -1.0f };
+	glm::vec3 StepX{ 0.0f };
+	glm::vec3 StepY{ 0.0f };
+
+	glm::vec3 GetDirection(float x, float y) const { return glm::normalize(Base + x * StepX + y * StepY); }
+	Ray GetRay(float x, float y) const { return { Origin, GetDirection(x, y) }; }
+};
+
+// 共享起点的一组光线（主光线的 4x2 像素块），方向按分量分开存放以便 SIMD 处理
+struct RayPacket
+{
+	static constexpr uint32_t Width = 8;
+
+	glm::vec3 Origin;
+	alignas(32) float DirectionX[Width];
+	alignas(32) float DirectionY[Width];
+	alignas(32) float DirectionZ[Width];
+
+	Ray GetRay(uint32_t lane) const { return { Origin, { DirectionX[lane], DirectionY[lane], DirectionZ[lane] } }; }
+};
+
+// 每条光线的最近交点，未命中时 ObjectIndex 为 -1
+struct RayPacketHit
+{
+	alignas(32) float HitDistance[RayPacket::Width];
+	alignas(32) int ObjectIndex[RayPacket::Width];
+};
@@ -1,8 +1,11 @@
 #include "Renderer.h"
 
 #include "Walnut/Random.h"
+#include "Walnut/Timer.h"
 
-#include <execution>
+#include <cstring>
+
+#include <glm/gtc/constants.hpp>
 
 namespace Utils
 {
@@ -31,31 +34,60 @@ namespace Utils
 		return (float)seed / (float)std::numeric_limits<uint32_t>::max();
 	}
 
+	static float Luminance(const glm::vec3& color)
+	{
+		return glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+	}
+
+	// 0 到 1 映射为蓝、绿、红
+	static glm::vec4 HeatMap(float t)
+	{
+		t = glm::clamp(t, 0.0f, 1.0f);
+		glm::vec3 color = t < 0.5f
+			? glm::mix(glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), t * 2.0f)
+			: glm::mix(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), t * 2.0f - 1.0f);
+		return glm::vec4(color, 1.0f);
+	}
+
+	// 单位球面上的均匀分布，法线加上它再归一化即为余弦分布的漫反射方向（概率密度 cos / π）
 	static glm::vec3 InUnitSphere(uint32_t& seed)
 	{
-		return glm::normalize(glm::vec3
-		(
-			RandomFloat(seed) * 2.0f - 1.0f,
-			RandomFloat(seed) * 2.0f - 1.0f,
-			RandomFloat(seed) * 2.0f - 1.0f)
-		);
+		float z = RandomFloat(seed) * 2.0f - 1.0f;
+		float phi = RandomFloat(seed) * glm::two_pi<float>();
+		float r = glm::sqrt(glm::max(1.0f - z * z, 0.0f));
+		return glm::vec3(r * glm::cos(phi), r * glm::sin(phi), z);
+	}
+
+	// 两种采样策略各取一个样本时的幂启发式权重
+	static float PowerHeuristic(float pdf, float otherPdf)
+	{
+		float a = pdf * pdf;
+		float b = otherPdf * otherPdf;
+		return a / (a + b);
+	}
+
+	// 两个首次命中能否视为同一表面：法线接近，且 b 位于 a 的切平面附近（距离相对于到相机的距离），用于蓄水池复用时排除几何边缘
+	static bool IsSimilarSurface(const glm::vec3& positionA, const glm::vec3& normalA, float depthA, const glm::vec3& positionB, const glm::vec3& normalB)
+	{
+		return glm::dot(normalA, normalB) > 0.9f && glm::abs(glm::dot(normalA, positionB - positionA)) < 0.05f * depthA;
 	}
 }
 
 void Renderer::OnResize(uint32_t width, uint32_t height)
 {
-	// ͼӿڿ߷ı䣬򴴽´ͼͼɫ
-	if (m_FinalImage)
-	{
-		if (width == m_FinalImage->GetWidth() && height == m_FinalImage->GetHeight())
-			return;
+	// 如果不存在图像或者视口宽高发生改变，则创建（重新创建）图像、图像颜色缓冲区。
+	if (m_ImageData && width == m_ViewportWidth && height == m_ViewportHeight)
+		return;
+
+	m_ViewportWidth = width;
+	m_ViewportHeight = height;
 
+#ifndef RT_HEADLESS
+	if (m_FinalImage)
 		m_FinalImage->Resize(width, height);
-	}
 	else
-	{
 		m_FinalImage = std::make_shared<Walnut::Image>(width, height, Walnut::ImageFormat::RGBA);
-	}
+#endif
 	
 	delete[] m_ImageData;
 	m_ImageData = new uint32_t[width * height];
@@ -63,166 +95,1793 @@ void Renderer::OnResize(uint32_t width, uint32_t height)
 	delete[] m_AccumulationData;
 	m_AccumulationData = new glm::vec4[width * height];
 
-	m_ImageHorizontalIterator.resize(width);
-	m_ImageVerticalIterator.resize(height);
+	m_SampleCounts.resize(width * height);
+	m_LuminanceSquared.resize(width * height);
+	m_PrimaryDepth.resize(width * height);
+	m_PrimaryObjectIndex.resize(width * height);
+	m_PrimaryNormal.resize(width * height);
+	// AOV 缓冲区在对应项开启时才分配
+	m_DepthAOV.clear();
+	m_NormalAOV.clear();
+	m_AlbedoAOV.clear();
+	m_ObjectIDAOV.clear();
+	m_StoredAOVs = m_WrittenAOVs = Settings::AOVSettings();
 
-	for (uint32_t i = 0; i < width; i++)
-		m_ImageHorizontalIterator[i] = i;
-	for (uint32_t i = 0; i < height; i++)
-		m_ImageVerticalIterator[i] = i;
+	// 下一帧按新的视口重新选择渲染分辨率
+	m_Width = m_Height = 0;
 }
 
 void Renderer::Render(const Scene& scene, const Camera& camera)
 {
+	Walnut::Timer frameTimer;
+
+	UpdateAccelerationStructure(scene);
+
+	// 光源只在场景或材质改变、选择方式切换后重新收集
+	if (m_Settings.LightSampling && (m_LightsDirty || m_LightSampler.GetType() != m_Settings.LightSelection
+		|| m_LightSampler.GetObjectCount() != scene.Sphere.size()))
+	{
+		m_LightSampler.Build(scene, m_Settings.LightSelection);
+		m_LightsDirty = false;
+	}
+
 	m_ActiveScene = &scene;
 	m_ActiveCamera = &camera;
 
+	// 分辨率或相机改变后重新累积；开启时域重投影时先保存上一帧的结果，渲染后把可复用的部分并入
+	glm::mat4 previousViewProjection = m_LastViewProjection;
+	glm::vec3 previousOrigin = m_PrimaryRays.Origin;
+	uint32_t previousWidth = m_Width, previousHeight = m_Height;
+	bool resolutionChanged = UpdateRenderResolution();
+
+	bool reprojectHistory = (m_ReprojectHistory || resolutionChanged) && m_Settings.TemporalReprojection && m_Settings.Accumulate
+		&& m_FrameIndex > 1 && previousWidth != 0 && m_StorePrimarySurface;
+	m_ReprojectHistory = false;
+	if (resolutionChanged || reprojectHistory)
+		m_FrameIndex = 1;
+
+	// 棋盘格模式下重新累积（不累积时每帧都是）时，本帧没有追踪的像素从上一帧重投影
+	bool reprojectCheckerboard = UseCheckerboard() && m_FrameIndex == 1 && previousWidth != 0 && m_StorePrimarySurface;
+	if (reprojectHistory || reprojectCheckerboard)
+		SaveHistory(previousViewProjection, previousOrigin, previousWidth, previousHeight);
+
 	if (m_FrameIndex == 1)
 	{
-		memset(m_AccumulationData, 0, m_FinalImage->GetWidth() * m_FinalImage->GetHeight() * sizeof(glm::vec4));
+		memset(m_AccumulationData, 0, m_Width * m_Height * sizeof(glm::vec4));
+		std::fill(m_SampleCounts.begin(), m_SampleCounts.end(), 0);
+		std::fill(m_LuminanceSquared.begin(), m_LuminanceSquared.end(), 0.0f);
+		m_TileConverged.clear();
 	}
 
-	// ߳Ż
+	// 多线程优化
 #define MT 1
 #if MT
 
-	std::for_each(std::execution::par, m_ImageVerticalIterator.begin(), m_ImageVerticalIterator.end(),
-		[this](uint32_t y) 
-		{
-			std::for_each(std::execution::par, m_ImageHorizontalIterator.begin(), m_ImageHorizontalIterator.end(), 
-				[this, y](uint32_t x)
-				{
-					glm::vec4 color = PerPixel(x, y);
-					m_AccumulationData[x + y * m_FinalImage->GetWidth()] += color;
+	m_ThreadPool.Resize(m_Settings.ThreadCount);
 
-					glm::vec4 accumulatedColor = m_AccumulationData[x + y * m_FinalImage->GetWidth()];
-					accumulatedColor /= (float)m_FrameIndex;
+	InvalidatePrimaryCaches();
 
-					accumulatedColor = glm::clamp(accumulatedColor, glm::vec4(0.0f), glm::vec4(1.0f)); // rgba̶ֵ0-1
-					m_ImageData[x + y * m_FinalImage->GetWidth()] = Utils::ConvertVec4ToInt(accumulatedColor); // vec4תΪuint32ɫ
-				});
-		});
+	if (m_Settings.CachePrimaryHits && !m_Settings.Jitter)
+		m_PrimaryHitCache.Resize(m_Width, m_Height);
+	else
+	{
+		m_PrimaryHitCache.Clear();
+		m_CachedCheckerboardPhases = 0;
+	}
 
-#else
+	// 表面信息或 AOV 新开启时，之前的内容已过期，已收敛的 tile 本帧也重新渲染一次以写入
+	const Settings::AOVSettings& aovs = m_Settings.AOVs;
+	Settings::AOVSettings previousAOVs = m_StoredAOVs;
+	bool storeSurface = NeedPrimarySurface();
+	bool newAOV = (aovs.Depth && !previousAOVs.Depth) || (aovs.Normal && !previousAOVs.Normal)
+		|| (aovs.Albedo && !previousAOVs.Albedo) || (aovs.ObjectID && !previousAOVs.ObjectID);
+	if ((storeSurface && !m_StorePrimarySurface) || newAOV)
+		m_TileConverged.clear();
+	m_StorePrimarySurface = storeSurface;
+	m_StoredAOVs = aovs;
+	m_StoreAOVs = aovs.Depth || aovs.Normal || aovs.Albedo || aovs.ObjectID;
+	uint32_t viewportPixels = m_ViewportWidth * m_ViewportHeight;
+	if (aovs.Depth)
+		m_DepthAOV.resize(viewportPixels);
+	if (aovs.Normal)
+		m_NormalAOV.resize(viewportPixels);
+	if (aovs.Albedo)
+		m_AlbedoAOV.resize(viewportPixels);
+	if (aovs.ObjectID)
+		m_ObjectIDAOV.resize(viewportPixels);
+	bool frameReset = m_FrameIndex == 1;
 
-	// ɫ
-	for (uint32_t y = 0; y < m_FinalImage->GetHeight(); y++)
+	if (UsePrimaryVisibility())
+		UpdatePrimaryVisibility(GetTileSize());
+	else
 	{
-		for (uint32_t x = 0; x < m_FinalImage->GetWidth(); x++)
-		{	
-			glm::vec4 color = PerPixel(x, y);
-			m_AccumulationData[x + y * m_FinalImage->GetWidth()] += color;
+		m_TileCuller.Clear();
+		m_VisibilityBuffer.Clear();
+	}
+
+	if (UseReSTIR())
+		ResampleDirectLight();
+	else
+	{
+		m_Reservoirs.clear();
+		m_TemporalReservoirs.clear();
+		m_PreviousReservoirs.clear();
+	}
+
+	if (m_Settings.Integrator == IntegratorType::Wavefront)
+		RenderWavefront();
+	else
+		RenderTiles();
+
+	if (reprojectHistory)
+		ReprojectHistory();
+
+	// 已收敛的 tile 本帧没有写入，采样数视图开关、降噪关闭或并入历史后整幅图重新输出
+	if (UseDenoiser())
+		DenoiseImage();
+	else if (m_Settings.ShowSampleCount || m_ShowingSampleCount || m_Denoised || reprojectHistory)
+		ResolveImage();
+	m_Denoised = UseDenoiser();
+
+	if (UseCheckerboard() && !m_Settings.ShowSampleCount)
+		ReconstructCheckerboard(reprojectHistory || reprojectCheckerboard);
+	if (UseCheckerboard() && frameReset && m_StoreAOVs)
+		ReconstructCheckerboardAOVs();
 
-			glm::vec4 accumulatedColor = m_AccumulationData[x + y * m_FinalImage->GetWidth()];
-			accumulatedColor /= (float)m_FrameIndex;
+#else
 
-			accumulatedColor = glm::clamp(accumulatedColor, glm::vec4(0.0f), glm::vec4(1.0f)); // rgba̶ֵ0-1
-			m_ImageData[x + y * m_FinalImage->GetWidth()] = Utils::ConvertVec4ToInt(accumulatedColor); // vec4תΪuint32ɫ
+	// 设置像素颜色
+	for (uint32_t y = 0; y < m_Height; y++)
+	{
+		for (uint32_t x = 0; x < m_Width; x++)
+		{	
+			AccumulatePixel(x, y, PerPixel(x, y));
 		}
 	}
 
 #endif
-	// ͼɫݸͼ
-	m_FinalImage->SetData(m_ImageData);
+	// 本帧已写入全部像素的首次命中；棋盘格模式下两种棋盘格各渲染一帧后才完整
+	if (StorePrimaryHits())
+	{
+		m_CachedCheckerboardPhases |= UseCheckerboard() ? 1u << m_CheckerboardPhase : 3u;
+		if (m_CachedCheckerboardPhases == 3u)
+			m_PrimaryHitCache.SetValid(true);
+	}
+
+	// 将图像颜色缓冲区传递给图像，降低分辨率渲染时先放大到视口大小
+	if (m_Width != m_ViewportWidth || m_Height != m_ViewportHeight)
+		UpscaleImage();
+#ifndef RT_HEADLESS
+	m_FinalImage->SetData(GetFinalImageData());
+#endif
+
+	// 棋盘格模式下每帧只写入一半像素：重新累积的帧由 ReconstructCheckerboardAOVs 补齐，
+	// 其余帧另一半保留上一帧的结果，本帧新开启的项因此还不完整
+	m_WrittenAOVs = m_StoredAOVs;
+	if (UseCheckerboard() && !frameReset)
+	{
+		m_WrittenAOVs.Depth &= previousAOVs.Depth;
+		m_WrittenAOVs.Normal &= previousAOVs.Normal;
+		m_WrittenAOVs.Albedo &= previousAOVs.Albedo;
+		m_WrittenAOVs.ObjectID &= previousAOVs.ObjectID;
+	}
+
+	m_LastFrameTime = frameTimer.ElapsedMillis();
 
 	if (m_Settings.Accumulate)
 		m_FrameIndex++;
 	else m_FrameIndex = 1;
+
+	m_CheckerboardPhase ^= 1;
 }
 
-// ׷
-Renderer::HitMessage Renderer::TraceRay(const Ray& ray)
+// 相机移动时按上一帧的耗时调整渲染分辨率，使帧时间接近目标；相机静止后恢复原始分辨率。返回分辨率是否改变
+bool Renderer::UpdateRenderResolution()
 {
-	// (bx^2 + by^2)t^2 + (2(axbx + ayby))t + (ax^2 + ay^2 - r^2) = 0
-	// a = ߵ
-	// b = ߵķ
-	// r = Բİ뾶
-	// t = 
+	uint32_t width = m_ViewportWidth;
+	uint32_t height = m_ViewportHeight;
 
-	int closestSphere = -1;
-	float hitDistance = FLT_MAX;
-	for (size_t i = 0; i < m_ActiveScene->Sphere.size(); i++)
+	glm::mat4 viewProjection = m_ActiveCamera->GetProjection() * m_ActiveCamera->GetView();
+	bool moving = m_Width != 0 && viewProjection != m_LastViewProjection;
+	m_LastViewProjection = viewProjection;
+
+	float scale = 1.0f;
+	if (m_Settings.DynamicResolution && moving)
 	{
-		Sphere sphere = m_ActiveScene->Sphere[i];
+		// 渲染耗时与像素数成正比，边长按耗时比例的平方根缩放；只有上一帧也在移动时它的耗时才有参考意义
+		if (m_CameraMoving && m_LastFrameTime > 0.0f)
+		{
+			float targetScale = m_ResolutionScale * glm::sqrt(m_Settings.TargetFrameTime / m_LastFrameTime);
+			m_ResolutionScale = glm::clamp(targetScale, glm::clamp(m_Settings.MinResolutionScale, 0.05f, 1.0f), 1.0f);
+		}
+		scale = m_ResolutionScale;
+	}
+	m_CameraMoving = moving;
+
+	uint32_t scaledWidth = glm::clamp((uint32_t)(width * scale + 0.5f), 1u, width);
+	uint32_t scaledHeight = glm::clamp((uint32_t)(height * scale + 0.5f), 1u, height);
+
+	// 像素坐标按比例换算到视口，降低分辨率时画面范围不变
+	m_PrimaryRays = m_ActiveCamera->GetPrimaryRays();
+	m_PrimaryRays.StepX *= (float)width / scaledWidth;
+	m_PrimaryRays.StepY *= (float)height / scaledHeight;
+
+	if (scaledWidth == m_Width && scaledHeight == m_Height)
+		return false;
+
+	m_Width = scaledWidth;
+	m_Height = scaledHeight;
+	return true;
+}
+
+// 双线性插值放大到视口大小；视口像素 x 对应渲染像素 x * m_Width / width，与主光线的换算一致
+void Renderer::UpscaleImage()
+{
+	uint32_t width = m_ViewportWidth;
+	uint32_t height = m_ViewportHeight;
+	m_UpscaledImageData.resize(width * height);
+
+	auto unpack = [](uint32_t color)
+	{
+		return glm::vec4(color & 0xff, (color >> 8) & 0xff, (color >> 16) & 0xff, color >> 24) / 255.0f;
+	};
+
+	glm::vec2 scale = { (float)m_Width / width, (float)m_Height / height };
+	m_ThreadPool.ParallelFor(height, [&](uint32_t y, uint32_t threadIndex)
+		{
+			float sourceY = y * scale.y;
+			uint32_t y0 = glm::min((uint32_t)sourceY, m_Height - 1);
+			uint32_t y1 = glm::min(y0 + 1, m_Height - 1);
+			float ty = sourceY - y0;
+
+			for (uint32_t x = 0; x < width; x++)
+			{
+				float sourceX = x * scale.x;
+				uint32_t x0 = glm::min((uint32_t)sourceX, m_Width - 1);
+				uint32_t x1 = glm::min(x0 + 1, m_Width - 1);
+				float tx = sourceX - x0;
+
+				glm::vec4 top = glm::mix(unpack(m_ImageData[x0 + y0 * m_Width]), unpack(m_ImageData[x1 + y0 * m_Width]), tx);
+				glm::vec4 bottom = glm::mix(unpack(m_ImageData[x0 + y1 * m_Width]), unpack(m_ImageData[x1 + y1 * m_Width]), tx);
+				glm::vec4 color = glm::mix(top, bottom, ty);
+				m_UpscaledImageData[x + y * width] = Utils::ConvertVec4ToInt(color);
+			}
+		});
+}
+
+// 每个像素的平均颜色与平均亮度的方差连同首次命中的反照率、法线、距离交给降噪器，结果写入 m_ImageData
+void Renderer::DenoiseImage()
+{
+	uint32_t width = m_Width;
+	uint32_t height = m_Height;
+	m_Denoiser.Resize(width, height);
+
+	m_ThreadPool.ParallelFor(height, [&](uint32_t y, uint32_t threadIndex)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				uint32_t pixel = x + y * width;
+				uint32_t n = m_SampleCounts[pixel];
+				int objectIndex = m_PrimaryObjectIndex[pixel];
+				glm::vec3 color = n > 0 ? glm::vec3(m_AccumulationData[pixel]) / (float)n : glm::vec3(0.0f);
+				if (n == 0 || objectIndex < 0)
+				{
+					m_Denoiser.SetPixel(pixel, color, 0.0f, n, glm::vec3(0.0f), glm::vec3(0.0f), FLT_MAX);
+					continue;
+				}
+
+				float mean = Utils::Luminance(color);
+				float variance = n > 1 ? glm::max(m_LuminanceSquared[pixel] / n - mean * mean, 0.0f) / (n - 1) : 0.0f;
+
+				const Material& material = m_ActiveScene->Materials[m_ActiveScene->Sphere[objectIndex].MaterialIndex];
+				m_Denoiser.SetPixel(pixel, color, variance, n, glm::vec3(material.Albedo), m_PrimaryNormal[pixel], m_PrimaryDepth[pixel]);
+			}
+		});
+
+	m_Denoiser.Denoise(m_ThreadPool, m_Settings.Denoising);
+
+	m_ThreadPool.ParallelFor(height, [&](uint32_t y, uint32_t threadIndex)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				uint32_t pixel = x + y * width;
+				glm::vec4 color = glm::clamp(glm::vec4(m_Denoiser.GetColor(pixel), 1.0f), glm::vec4(0.0f), glm::vec4(1.0f));
+				m_ImageData[pixel] = Utils::ConvertVec4ToInt(color);
+			}
+		});
+}
+
+// 本帧没有追踪、也没有累积过采样的像素（相机移动后或不累积时）先取上一帧重投影处的颜色，失败时由上下左右四个本帧追踪的像素重建：
+// 左右（或上下）两个像素命中同一物体且法线接近时认为该方向没有跨越边缘，只在这样的方向上插值，两个方向都跨越边缘时取四个像素的平均
+void Renderer::ReconstructCheckerboard(bool useHistory)
+{
+	uint32_t width = m_Width;
+	uint32_t height = m_Height;
+
+	auto sameSurface = [this](uint32_t a, uint32_t b)
+	{
+		return (m_PrimaryObjectIndex[a] == m_PrimaryObjectIndex[b] && glm::dot(m_PrimaryNormal[a], m_PrimaryNormal[b]) > 0.9f)
+			|| (m_PrimaryObjectIndex[a] < 0 && m_PrimaryObjectIndex[b] < 0);
+	};
+
+	m_ThreadPool.ParallelFor(height, [&](uint32_t y, uint32_t threadIndex)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				uint32_t pixel = x + y * width;
+				if (IsPixelTraced(x, y) || m_SampleCounts[pixel] > 0)
+					continue;
+
+				uint32_t historyPixel;
+				if (useHistory && FindHistoryPixel(x, y, historyPixel))
+				{
+					glm::vec4 color = glm::clamp(m_History.Color[historyPixel] / (float)m_History.SampleCounts[historyPixel], glm::vec4(0.0f), glm::vec4(1.0f));
+					m_ImageData[pixel] = Utils::ConvertVec4ToInt(color);
+					continue;
+				}
+
+				// 图像边缘缺少的邻居用对侧代替
+				uint32_t left = (x > 0 ? x - 1 : x + 1) + y * width;
+				uint32_t right = (x + 1 < width ? x + 1 : x - 1) + y * width;
+				uint32_t down = x + (y > 0 ? y - 1 : y + 1) * width;
+				uint32_t up = x + (y + 1 < height ? y + 1 : y - 1) * width;
+
+				bool horizontal = width > 1 && sameSurface(left, right);
+				bool vertical = height > 1 && sameSurface(down, up);
+				if (!horizontal && !vertical)
+					horizontal = vertical = true;
+
+				glm::vec4 color{ 0.0f };
+				float weight = 0.0f;
+				auto gather = [&](uint32_t neighbour)
+				{
+					if (m_SampleCounts[neighbour] == 0)
+						return;
+					color += m_AccumulationData[neighbour] / (float)m_SampleCounts[neighbour];
+					weight++;
+				};
+				if (horizontal && width > 1)
+				{
+					gather(left);
+					gather(right);
+				}
+				if (vertical && height > 1)
+				{
+					gather(down);
+					gather(up);
+				}
+
+				if (weight == 0.0f)
+					continue;
+
+				color = glm::clamp(color / weight, glm::vec4(0.0f), glm::vec4(1.0f));
+				m_ImageData[pixel] = Utils::ConvertVec4ToInt(color);
+			}
+		});
+}
+
+// 重新累积的帧中没有追踪的像素按 ReconstructCheckerboard 的方式选择没有跨越边缘的方向，复制该方向上相邻像素的 AOV
+void Renderer::ReconstructCheckerboardAOVs()
+{
+	uint32_t width = m_Width;
+	uint32_t height = m_Height;
+	const Settings::AOVSettings& aovs = m_StoredAOVs;
+
+	auto sameSurface = [this](uint32_t a, uint32_t b)
+	{
+		return (m_PrimaryObjectIndex[a] == m_PrimaryObjectIndex[b] && glm::dot(m_PrimaryNormal[a], m_PrimaryNormal[b]) > 0.9f)
+			|| (m_PrimaryObjectIndex[a] < 0 && m_PrimaryObjectIndex[b] < 0);
+	};
+
+	m_ThreadPool.ParallelFor(height, [&](uint32_t y, uint32_t threadIndex)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				if (IsPixelTraced(x, y))
+					continue;
+
+				uint32_t pixel = x + y * width;
+				uint32_t left = (x > 0 ? x - 1 : x + 1) + y * width;
+				uint32_t right = (x + 1 < width ? x + 1 : x - 1) + y * width;
+				uint32_t down = x + (y > 0 ? y - 1 : y + 1) * width;
+				uint32_t up = x + (y + 1 < height ? y + 1 : y - 1) * width;
+
+				uint32_t source = width > 1 ? left : down;
+				if (height > 1 && !(width > 1 && sameSurface(left, right)) && sameSurface(down, up))
+					source = down;
+				if (source == pixel)
+					continue;
+
+				if (aovs.Depth)
+					m_DepthAOV[pixel] = m_DepthAOV[source];
+				if (aovs.Normal)
+					m_NormalAOV[pixel] = m_NormalAOV[source];
+				if (aovs.Albedo)
+					m_AlbedoAOV[pixel] = m_AlbedoAOV[source];
+				if (aovs.ObjectID)
+					m_ObjectIDAOV[pixel] = m_ObjectIDAOV[source];
+			}
+		});
+}
+
+// 保存上一帧（分辨率 width x height）的累积结果与首次命中距离，以及当时的相机
+void Renderer::SaveHistory(const glm::mat4& viewProjection, const glm::vec3& origin, uint32_t width, uint32_t height)
+{
+	uint32_t pixelCount = width * height;
+	auto& history = m_History;
+	history.Color.assign(m_AccumulationData, m_AccumulationData + pixelCount);
+	history.SampleCounts.assign(m_SampleCounts.begin(), m_SampleCounts.begin() + pixelCount);
+	history.LuminanceSquared.assign(m_LuminanceSquared.begin(), m_LuminanceSquared.begin() + pixelCount);
+	history.Depth.assign(m_PrimaryDepth.begin(), m_PrimaryDepth.begin() + pixelCount);
+	history.ViewProjection = viewProjection;
+	history.Origin = origin;
+	history.Width = width;
+	history.Height = height;
+}
+
+bool Renderer::FindHistoryPixel(uint32_t x, uint32_t y, uint32_t& historyPixel) const
+{
+	const auto& history = m_History;
+	uint32_t width = m_Width;
+	uint32_t height = m_Height;
 
-		glm::vec3 origin = ray.Origin - sphere.Position;
+	// 已累积过采样的像素有本帧的首次命中距离；没有的用相邻像素的距离依次尝试，能在上一帧找到同一表面的即为该像素所在的表面
+	uint32_t candidates[4];
+	uint32_t candidateCount = 0;
+	uint32_t pixel = x + y * width;
+	if (m_SampleCounts[pixel] > 0)
+		candidates[candidateCount++] = pixel;
+	else
+	{
+		if (x > 0) candidates[candidateCount++] = pixel - 1;
+		if (x + 1 < width) candidates[candidateCount++] = pixel + 1;
+		if (y > 0) candidates[candidateCount++] = pixel - width;
+		if (y + 1 < height) candidates[candidateCount++] = pixel + width;
+	}
 
-		float a = glm::dot(ray.Direction, ray.Direction);
-		float b = 2.0f * glm::dot(origin, ray.Direction);
-		float c = glm::dot(origin, origin) - sphere.Radius * sphere.Radius;
+	for (uint32_t i = 0; i < candidateCount; i++)
+	{
+		if (m_SampleCounts[candidates[i]] == 0)
+			continue;
 
-		// бʽ b^2 - 4ac
-		float discriminant = b * b - 4.0f * a * c;
+		float depth = m_PrimaryDepth[candidates[i]];
+		bool sky = depth == FLT_MAX;
 
-		if (discriminant < 0.0f)
+		// 天空按远处的一点投影，只要求上一帧同样看到天空
+		glm::vec3 position = m_PrimaryRays.Origin + m_PrimaryRays.GetDirection((float)x, (float)y) * (sky ? 1e4f : depth);
+		glm::vec4 clip = history.ViewProjection * glm::vec4(position, 1.0f);
+		if (clip.w <= 0.0f)
 			continue;
-		// t
-		// (-b +- бʽ) / 2a
-		float tclose = (-b - glm::sqrt(discriminant)) / (2.0f * a); // ¼Ļt
 
-		// Ļ¼
-		if (tclose < hitDistance && tclose > 0.0f)
+		// 像素 x 对应 NDC x / width * 2 - 1
+		glm::vec2 ndc = glm::vec2(clip) / clip.w;
+		int historyX = (int)glm::round((ndc.x * 0.5f + 0.5f) * history.Width);
+		int historyY = (int)glm::round((ndc.y * 0.5f + 0.5f) * history.Height);
+
+		// 上一帧也是棋盘格时最近的像素可能没有追踪，再试它上下左右的像素
+		const glm::ivec2 offsets[] = { { 0, 0 }, { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+		for (const glm::ivec2& offset : offsets)
 		{
-			hitDistance = tclose;
-			closestSphere = (int)i;
+			int hx = historyX + offset.x;
+			int hy = historyY + offset.y;
+			if (hx < 0 || hy < 0 || hx >= (int)history.Width || hy >= (int)history.Height)
+				continue;
+
+			uint32_t candidate = hx + hy * history.Width;
+			if (history.SampleCounts[candidate] == 0)
+				continue;
+
+			float historyDepth = history.Depth[candidate];
+			if (sky != (historyDepth == FLT_MAX))
+				break;
+			if (!sky)
+			{
+				float expectedDepth = glm::distance(history.Origin, position);
+				if (glm::abs(historyDepth - expectedDepth) > 0.02f * expectedDepth)
+					break;
+			}
+
+			historyPixel = candidate;
+			return true;
 		}
 	}
 
-	if (closestSphere < 0)
-		return MissHit(ray);
+	return false;
+}
 
-	return ClosestHit(ray, hitDistance, closestSphere);
+// 本帧的采样已写入累积缓冲区。每个像素在上一帧画面中找到未被遮挡的对应像素（FindHistoryPixel），
+// 把那里的平均颜色限制在本帧 3x3 邻域的均值 ± k 倍标准差内，按最多 MaxHistorySamples 个采样的权重并入；
+// 棋盘格模式下本帧没有追踪的像素同样并入，失败的之后由邻域重建
+void Renderer::ReprojectHistory()
+{
+	const auto& history = m_History;
+	uint32_t width = m_Width;
+	uint32_t height = m_Height;
+	m_ReprojectedColor.assign(width * height, glm::vec4(0.0f));
+	m_ReprojectedLuminanceSquared.resize(width * height);
+
+	// 先只读本帧的累积结果，再统一写回，避免读到其他线程已并入历史的邻域
+	m_ThreadPool.ParallelFor(height, [&](uint32_t y, uint32_t threadIndex)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				uint32_t pixel = x + y * width;
+				uint32_t historyPixel;
+				if (!FindHistoryPixel(x, y, historyPixel))
+					continue;
+				uint32_t historyCount = history.SampleCounts[historyPixel];
+
+				glm::vec3 mean{ 0.0f }, meanSquared{ 0.0f };
+				float neighbourCount = 0.0f;
+				for (uint32_t ny = (y > 0 ? y - 1 : y); ny <= glm::min(y + 1, height - 1); ny++)
+				{
+					for (uint32_t nx = (x > 0 ? x - 1 : x); nx <= glm::min(x + 1, width - 1); nx++)
+					{
+						uint32_t neighbour = nx + ny * width;
+						if (m_SampleCounts[neighbour] == 0)
+							continue;
+
+						glm::vec3 color = glm::vec3(m_AccumulationData[neighbour]) / (float)m_SampleCounts[neighbour];
+						mean += color;
+						meanSquared += color * color;
+						neighbourCount++;
+					}
+				}
+				mean /= neighbourCount;
+				glm::vec3 deviation = glm::sqrt(glm::max(meanSquared / neighbourCount - mean * mean, glm::vec3(0.0f)));
+				glm::vec3 clampRange = deviation * m_Settings.HistoryClampScale;
+
+				glm::vec3 historyColor = glm::vec3(history.Color[historyPixel]) / (float)historyCount;
+				historyColor = glm::clamp(historyColor, mean - clampRange, mean + clampRange);
+
+				float weight = (float)glm::min(historyCount, glm::max(m_Settings.MaxHistorySamples, 1u));
+				m_ReprojectedColor[pixel] = glm::vec4(historyColor * weight, weight);
+				// 亮度平方和按权重占历史采样数的比例折算，保留历史的方差供自适应采样使用
+				m_ReprojectedLuminanceSquared[pixel] = history.LuminanceSquared[historyPixel] * weight / historyCount;
+			}
+		});
+
+	m_ThreadPool.ParallelFor(height, [&](uint32_t y, uint32_t threadIndex)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				uint32_t pixel = x + y * width;
+				const glm::vec4& reprojected = m_ReprojectedColor[pixel];
+				if (reprojected.w == 0.0f)
+					continue;
+
+				// 每个采样的 alpha 为 1，权重同时计入 alpha
+				m_AccumulationData[pixel] += reprojected;
+				m_SampleCounts[pixel] += (uint32_t)reprojected.w;
+				m_LuminanceSquared[pixel] += m_ReprojectedLuminanceSquared[pixel];
+			}
+		});
 }
 
-// ɫ
-glm::vec4 Renderer::PerPixel(int x, int y)
+void Renderer::UpdateAccelerationStructure(const Scene& scene)
 {
-	Ray ray;
-	ray.Origin = m_ActiveCamera->GetPosition(); // ߣߣ㣬Ǵ
-	ray.Direction = m_ActiveCamera->GetRayDirections()[x + y * m_FinalImage->GetWidth()]; // ߣߣķ
+	if (m_ActiveScene != &scene)
+		m_SceneDirty = true;
 
-	// glm::vec3 color{ 0.0f };
-	// float multiplier = 1.0f;
-	glm::vec3 light{ 0.0f };
-	glm::vec3 contribution{ 1.0f };
+	if (m_SceneDirty || m_GeometryDirty)
+	{
+		m_PrimaryDirty = true;
+		m_LightsDirty = true;
+	}
 
-	uint32_t seed = x + y * m_FinalImage->GetWidth();
-	seed *= m_FrameIndex;
+	// 球体索引可能已改变，蓄水池中的光源不再有效
+	if (m_SceneDirty)
+	{
+		m_TemporalReservoirs.clear();
+		m_PreviousReservoirs.clear();
+	}
 
-	int bounces = 5; // ߵ
-	for (size_t i = 0; i < bounces; i++)
+	if (m_Settings.Acceleration == AccelerationType::None)
 	{
-		seed += i;
+		if (m_SceneDirty || m_GeometryDirty || m_SphereArray.GetCount() != scene.Sphere.size())
+			m_SphereArray.Update(scene.Sphere);
 
-		HitMessage hitMessage = TraceRay(ray);
-		if (hitMessage.HitDistance < 0.0f)
+		m_SceneDirty = false;
+		m_GeometryDirty = false;
+		return;
+	}
+
+	if (m_Settings.Acceleration == AccelerationType::Grid)
+	{
+		// 网格重建是 O(n) 的，不区分拓扑变化与移动
+		if (m_SceneDirty || m_GeometryDirty || m_Grid.GetSphereCount() != scene.Sphere.size())
 		{
-			glm::vec3 skyColor = glm::vec3( 0.6f, 0.7f, 0.9f );
-			light += skyColor * contribution;
-			break;
+			m_BVH.Clear();
+			m_WideBVH.Clear();
+			m_Grid.Build(scene.Sphere);
 		}
 
-		// glm::vec3 lightDir = glm::normalize(glm::vec3(-1.0f)); // ߷
-		// float d = glm::max(glm::dot(hitMessage.WorldNormal, -lightDir), 0.0f); // 淨̶߳
+		m_SceneDirty = false;
+		m_GeometryDirty = false;
+		return;
+	}
 
-		const Sphere& closestSphere = m_ActiveScene->Sphere[hitMessage.ObjectIndex];
-		const Material& material = m_ActiveScene->Materials[closestSphere.MaterialIndex];
-		glm::vec3 sphereColor = material.Albedo;
-		// sphereColor *= d;
-		// color += sphereColor * multiplier;
-		light += material.GetEmission();
+	if (m_BVH.GetPrimitiveCount() != scene.Sphere.size())
+		m_SceneDirty = true;
 
-		//  
-		contribution *= sphereColor;
+	if (!(m_SceneDirty || m_GeometryDirty))
+		return;
 
-		ray.Origin = hitMessage.WorldPosition + hitMessage.WorldNormal * 0.0001f; // Ĺʼĳɽ
-		// ray.Direction = glm::reflect(ray.Direction, 
-		// 	 hitMessage.WorldNormal + material.Roughness * Walnut::Random::Vec3(-0.5f, 0.5f)); // ߷Ϊ淴䷽
-		// ray.Direction = glm::normalize(hitMessage.WorldNormal + Walnut::Random::InUnitSphere()); // ߷Ϊ䷽ ԭ
-		ray.Direction = glm::normalize(hitMessage.WorldNormal + Utils::InUnitSphere(seed)); // ߷Ϊ䷽
+	m_Grid.Clear();
+
+	if (m_SceneDirty)
+		m_BVH.Build(scene.Sphere, m_Settings.BVHQuality);
+	else
+		m_BVH.Refit(scene.Sphere, m_Settings.RefitThreshold);
+
+	// 8 叉 BVH 的量化包围盒无法原地更新，总是从二叉 BVH 重新折叠
+	if (m_Settings.Acceleration == AccelerationType::WideBVH)
+		m_WideBVH.Build(m_BVH);
+	else
+		m_WideBVH.Clear();
+
+	m_SceneDirty = false;
+	m_GeometryDirty = false;
+}
+
+void Renderer::InvalidatePrimaryCaches()
+{
+	uint32_t width = m_Width;
+	uint32_t height = m_Height;
+	glm::mat4 viewProjection = m_ActiveCamera->GetProjection() * m_ActiveCamera->GetView();
+
+	auto& key = m_PrimaryViewKey;
+	if (!m_PrimaryDirty && key.ViewProjection == viewProjection && key.Width == width && key.Height == height)
+		return;
+
+	key = { viewProjection, width, height };
+	m_PrimaryDirty = false;
+
+	m_TileCuller.Clear();
+	m_VisibilityBuffer.Clear();
+	m_PrimaryHitCache.SetValid(false);
+	m_CachedCheckerboardPhases = 0;
+}
+
+void Renderer::UpdatePrimaryVisibility(uint32_t tileSize)
+{
+	uint32_t width = m_Width;
+	uint32_t height = m_Height;
+
+	if (m_TileCuller.GetTileCount() == 0 || m_TileCuller.GetTileSize() != tileSize)
+	{
+		m_TileCuller.Build(m_ThreadPool, m_ActiveScene->Sphere, m_PrimaryViewKey.ViewProjection, width, height, tileSize);
+		m_VisibilityBuffer.Clear();
 	}
 
-	return glm::vec4(light, 1.0f);
+	// 相机不动时可见性缓冲区跨帧复用
+	if (RasterizePrimaryHits() && m_VisibilityBuffer.IsEmpty())
+		m_VisibilityBuffer.Build(m_ThreadPool, m_TileCuller, m_PrimaryRays, width, height);
+}
+
+void Renderer::AccumulatePixel(uint32_t x, uint32_t y, const glm::vec4& color)
+{
+	uint32_t pixel = x + y * m_Width;
+	m_AccumulationData[pixel] += color;
+	m_SampleCounts[pixel]++;
+
+	float luminance = Utils::Luminance(glm::vec3(color));
+	m_LuminanceSquared[pixel] += luminance * luminance;
+
+	if (!m_Settings.ShowSampleCount && !UseDenoiser())
+		ResolvePixel(pixel);
+}
+
+void Renderer::ResolvePixel(uint32_t pixel)
+{
+	glm::vec4 accumulatedColor = m_AccumulationData[pixel];
+	accumulatedColor /= (float)glm::max(m_SampleCounts[pixel], 1u);
+
+	accumulatedColor = glm::clamp(accumulatedColor, glm::vec4(0.0f), glm::vec4(1.0f)); // 将rgba的值固定到0-1区间
+	m_ImageData[pixel] = Utils::ConvertVec4ToInt(accumulatedColor); // 将vec4转化为uint32输出给颜色缓冲区
+}
+
+// 整幅图重新输出颜色，或按采样数输出热力图
+void Renderer::ResolveImage()
+{
+	uint32_t width = m_Width;
+	uint32_t height = m_Height;
+	uint32_t maxSamples = *std::max_element(m_SampleCounts.begin(), m_SampleCounts.end());
+
+	m_ThreadPool.ParallelFor(height, [&](uint32_t y, uint32_t threadIndex)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				uint32_t pixel = x + y * width;
+				if (!m_Settings.ShowSampleCount)
+				{
+					ResolvePixel(pixel);
+					continue;
+				}
+
+				glm::vec4 color = Utils::HeatMap((float)m_SampleCounts[pixel] / (float)glm::max(maxSamples, 1u));
+				m_ImageData[pixel] = Utils::ConvertVec4ToInt(color);
+			}
+		});
+
+	m_ShowingSampleCount = m_Settings.ShowSampleCount;
+}
+
+// 以 tile 为单位分配任务，各线程写入的像素互不相邻，避免伪共享
+void Renderer::RenderTiles()
+{
+	uint32_t tileSize = GetTileSize();
+	m_TileCountX = (m_Width + tileSize - 1) / tileSize;
+	m_TileCountY = (m_Height + tileSize - 1) / tileSize;
+	m_TileTimes.assign(m_TileCountX * m_TileCountY, 0.0f);
+	UpdateTraversalOrder(tileSize);
+
+	// tile 划分改变后之前的收敛结果作废
+	if (!UseAdaptiveSampling() || m_TileConverged.size() != m_TileOrder.size())
+		m_TileConverged.assign(m_TileOrder.size(), 0);
+
+	m_ActiveTiles.clear();
+	for (uint32_t tileIndex : m_TileOrder)
+	{
+		if (!m_TileConverged[tileIndex])
+			m_ActiveTiles.push_back(tileIndex);
+	}
+	m_ConvergedTileCount = (uint32_t)(m_TileOrder.size() - m_ActiveTiles.size());
+
+	// 每帧的总采样数大致不变：收敛的 tile 越多，剩下的 tile 每帧采样越多
+	m_AdaptiveSampleCount = 1;
+	if (UseAdaptiveSampling() && !m_ActiveTiles.empty())
+	{
+		uint32_t sampleCount = (uint32_t)(m_TileOrder.size() / m_ActiveTiles.size());
+		m_AdaptiveSampleCount = glm::clamp(sampleCount, 1u, glm::max(m_Settings.AdaptiveMaxSamplesPerFrame, 1u));
+	}
+
+	// 每个线程分到沿曲线连续的一段 tile，即画面上相邻的一块区域
+	m_ThreadPool.ParallelFor((uint32_t)m_ActiveTiles.size(), [this, tileSize](uint32_t taskIndex, uint32_t threadIndex)
+		{
+			RenderTile(m_ActiveTiles[taskIndex], tileSize, m_AdaptiveSampleCount);
+		});
+}
+
+void Renderer::UpdateTraversalOrder(uint32_t tileSize)
+{
+	auto& key = m_TraversalOrderKey;
+	uint32_t packetSpanX = UsePacketTracing() ? GetPacketSpanX() : 0;
+	if (key.TileSize == tileSize && key.TileCountX == m_TileCountX && key.TileCountY == m_TileCountY
+		&& key.TileOrder == m_Settings.TileOrder && key.PixelOrder == m_Settings.PixelOrder && key.PacketSpanX == packetSpanX)
+		return;
+
+	key = { tileSize, m_TileCountX, m_TileCountY, m_Settings.TileOrder, m_Settings.PixelOrder, packetSpanX };
+
+	m_TileOrder.clear();
+	for (const glm::uvec2& tile : SpaceFillingCurve::GenerateOrder(m_TileCountX, m_TileCountY, m_Settings.TileOrder))
+		m_TileOrder.push_back(tile.x + tile.y * m_TileCountX);
+
+	if (packetSpanX > 0)
+		m_TilePixelOrder = SpaceFillingCurve::GenerateOrder(tileSize / packetSpanX, tileSize / PacketHeight, m_Settings.PixelOrder);
+	else
+		m_TilePixelOrder = SpaceFillingCurve::GenerateOrder(tileSize, tileSize, m_Settings.PixelOrder);
+}
+
+void Renderer::RenderTile(uint32_t tileIndex, uint32_t tileSize, uint32_t sampleCount)
+{
+	Walnut::Timer timer;
+
+	uint32_t minX = tileIndex % m_TileCountX * tileSize;
+	uint32_t minY = tileIndex / m_TileCountX * tileSize;
+	uint32_t maxX = glm::min(minX + tileSize, m_Width);
+	uint32_t maxY = glm::min(minY + tileSize, m_Height);
+
+	// 图像边缘的 tile 跳过越界的部分
+	for (uint32_t sample = 0; sample < sampleCount; sample++)
+	{
+		if (UsePacketTracing())
+		{
+			for (const glm::uvec2& packet : m_TilePixelOrder)
+			{
+				uint32_t x = minX + packet.x * GetPacketSpanX();
+				uint32_t y = minY + packet.y * PacketHeight;
+				if (x < maxX && y < maxY)
+					RenderPacket(tileIndex, x, y);
+			}
+			continue;
+		}
+
+		for (const glm::uvec2& pixel : m_TilePixelOrder)
+		{
+			uint32_t x = minX + pixel.x;
+			uint32_t y = minY + pixel.y;
+			if (x >= maxX || y >= maxY || !IsPixelTraced(x, y))
+				continue;
+
+			HitMessage primaryHit;
+			if (UseReSTIR())
+				primaryHit = m_ReservoirHits[x + y * m_Width];
+			else if (m_PrimaryHitCache.IsValid())
+				primaryHit = LoadPrimaryHit(x + y * m_Width);
+			else if (UsePrimaryVisibility())
+				primaryHit = TracePrimaryRay(x, y);
+			else
+			{
+				AccumulatePixel(x, y, PerPixel(x, y));
+				continue;
+			}
+			AccumulatePixel(x, y, PerPixel(x, y, &primaryHit));
+		}
+	}
+
+	if (UseAdaptiveSampling())
+	{
+		uint32_t minSamples;
+		float error = EstimateTileError(minX, minY, maxX, maxY, minSamples);
+		m_TileConverged[tileIndex] = minSamples >= m_Settings.AdaptiveMinSamples && error < m_Settings.AdaptiveThreshold;
+	}
+
+	m_TileTimes[tileIndex] = timer.ElapsedMillis();
+}
+
+// 每个像素亮度均值的相对标准误差 sqrt(var / n) / (mean + 0.1)，暗部加 0.1 避免分母过小；返回 tile 内的平均值
+float Renderer::EstimateTileError(uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY, uint32_t& minSamples) const
+{
+	uint32_t width = m_Width;
+	float totalError = 0.0f;
+	minSamples = UINT32_MAX;
+
+	for (uint32_t y = minY; y < maxY; y++)
+	{
+		for (uint32_t x = minX; x < maxX; x++)
+		{
+			uint32_t pixel = x + y * width;
+			uint32_t n = m_SampleCounts[pixel];
+			minSamples = glm::min(minSamples, n);
+			if (n < 2)
+				return FLT_MAX;
+
+			float mean = Utils::Luminance(glm::vec3(m_AccumulationData[pixel])) / n;
+			float variance = glm::max(m_LuminanceSquared[pixel] / n - mean * mean, 0.0f) * n / (n - 1);
+			totalError += glm::sqrt(variance / n) / (mean + 0.1f);
+		}
+	}
+
+	return totalError / ((maxX - minX) * (maxY - minY));
+}
+
+// 4x2 像素（棋盘格模式下为 8x2 像素中本帧追踪的 8 个）的主光线一起求交，再逐像素完成后续弹射
+void Renderer::RenderPacket(uint32_t tileIndex, uint32_t packetX, uint32_t packetY)
+{
+	uint32_t width = m_Width;
+	uint32_t height = m_Height;
+
+	// packetX 为偶数，每行追踪的像素是奇偶性与 y + m_CheckerboardPhase 相同的 4 个
+	bool checkerboard = UseCheckerboard();
+	auto lanePixel = [&](uint32_t lane)
+	{
+		uint32_t y = packetY + lane / PacketWidth;
+		uint32_t x = checkerboard
+			? packetX + lane % PacketWidth * 2 + ((y + m_CheckerboardPhase) & 1)
+			: packetX + lane % PacketWidth;
+		return glm::uvec2(x, y);
+	};
+
+	// 图像边缘超出的通道照常生成光线，结果丢弃
+	RayPacket packet;
+	packet.Origin = m_ActiveCamera->GetPosition();
+	for (uint32_t lane = 0; lane < RayPacket::Width; lane++)
+	{
+		glm::uvec2 pixel = lanePixel(lane);
+		glm::vec3 direction = GetPrimaryRay(pixel.x, pixel.y).Direction;
+		packet.DirectionX[lane] = direction.x;
+		packet.DirectionY[lane] = direction.y;
+		packet.DirectionZ[lane] = direction.z;
+	}
+
+	RayPacketHit packetHit;
+	TracePacket(tileIndex, packet, packetHit);
+
+	for (uint32_t lane = 0; lane < RayPacket::Width; lane++)
+	{
+		glm::uvec2 pixel = lanePixel(lane);
+		uint32_t x = pixel.x, y = pixel.y;
+		if (x >= width || y >= height)
+			continue;
+
+		Ray ray = packet.GetRay(lane);
+		HitMessage primaryHit = packetHit.ObjectIndex[lane] < 0
+			? MissHit(ray)
+			: ClosestHit(ray, packetHit.HitDistance[lane], packetHit.ObjectIndex[lane]);
+		AccumulatePixel(x, y, PerPixel(x, y, &primaryHit));
+	}
+}
+
+void Renderer::TracePacket(uint32_t tileIndex, const RayPacket& packet, RayPacketHit& hit)
+{
+	for (uint32_t lane = 0; lane < RayPacket::Width; lane++)
+	{
+		hit.HitDistance[lane] = FLT_MAX;
+		hit.ObjectIndex[lane] = -1;
+	}
+
+	if (m_Settings.TileCulling)
+	{
+		m_TileCuller.IntersectPacket(tileIndex, packet, hit);
+		return;
+	}
+
+	switch (m_Settings.Acceleration)
+	{
+		case AccelerationType::None: m_SphereArray.IntersectPacket(packet, hit); break;
+		case AccelerationType::BVH:  m_BVH.IntersectPacket(packet, hit); break;
+		default:
+		{
+			// 8 叉 BVH 与网格没有光线组遍历，逐条追踪
+			for (uint32_t lane = 0; lane < RayPacket::Width; lane++)
+			{
+				Ray ray = packet.GetRay(lane);
+				if (m_Settings.Acceleration == AccelerationType::WideBVH)
+					m_WideBVH.Intersect(ray, hit.HitDistance[lane], hit.ObjectIndex[lane]);
+				else
+					m_Grid.Intersect(ray, hit.HitDistance[lane], hit.ObjectIndex[lane]);
+			}
+			break;
+		}
+	}
+}
+
+void Renderer::RenderWavefront()
+{
+	uint32_t width = m_Width;
+	uint32_t height = m_Height;
+	uint32_t pixelCount = width * height;
+
+	uint32_t capacity = glm::min(pixelCount, WavefrontBatchSize);
+	if (m_PathQueue.PixelIndex.size() != capacity)
+	{
+		m_PathQueue.Resize(capacity);
+		m_CompactedPathQueue.Resize(capacity);
+		m_ShadowQueue.Resize(capacity);
+		m_CompactedShadowQueue.Resize(capacity);
+	}
+	m_PathRadiance.resize(pixelCount);
+	m_WavefrontStats.assign(Bounces, {});
+
+	// 分批处理整帧像素，路径队列的大小不随分辨率增长
+	for (uint32_t firstPixel = 0; firstPixel < pixelCount; firstPixel += capacity)
+	{
+		GeneratePaths(firstPixel, glm::min(capacity, pixelCount - firstPixel));
+
+		for (uint32_t bounce = 0; bounce < Bounces && m_PathQueue.Count > 0; bounce++)
+		{
+			WavefrontBounceStats& stats = m_WavefrontStats[bounce];
+			stats.PathCount += m_PathQueue.Count;
+
+			// 主光线本身已经连贯，不需要排序
+			Walnut::Timer timer;
+			if (m_Settings.SortRays && bounce > 0)
+			{
+				SortPaths();
+				stats.SortTime += timer.ElapsedMillis();
+				timer.Reset();
+			}
+
+			ExtendPaths(bounce);
+			stats.ExtendTime += timer.ElapsedMillis();
+			ShadePaths(bounce);
+
+			if (m_Settings.LightSampling)
+			{
+				timer.Reset();
+				CompactShadowRays();
+				stats.ShadowRayCount += m_CompactedShadowQueue.Count;
+				TraceShadowRays();
+				AccumulateShadowRays();
+				stats.ShadowTime += timer.ElapsedMillis();
+			}
+
+			if (bounce + 1 < Bounces)
+				CompactPaths();
+		}
+	}
+
+	m_ThreadPool.ParallelFor(height, [this, width](uint32_t y, uint32_t threadIndex)
+		{
+			for (uint32_t x = 0; x < width; x++)
+				AccumulatePixel(x, y, glm::vec4(m_PathRadiance[x + y * width], 1.0f));
+		});
+}
+
+void Renderer::ForEachChunk(uint32_t count, const std::function<void(uint32_t first, uint32_t last, uint32_t chunkIndex)>& kernel)
+{
+	uint32_t chunkCount = (count + WavefrontChunkSize - 1) / WavefrontChunkSize;
+	m_ThreadPool.ParallelFor(chunkCount, [count, &kernel](uint32_t chunkIndex, uint32_t threadIndex)
+		{
+			uint32_t first = chunkIndex * WavefrontChunkSize;
+			kernel(first, glm::min(first + WavefrontChunkSize, count), chunkIndex);
+		});
+}
+
+// 每个像素一条从相机出发的路径，随机数种子与 PerPixel 相同
+void Renderer::GeneratePaths(uint32_t firstPixel, uint32_t pathCount)
+{
+	PathQueue& paths = m_PathQueue;
+	paths.Count = pathCount;
+
+	uint32_t width = m_Width;
+
+	ForEachPathChunk([&](uint32_t first, uint32_t last, uint32_t chunkIndex)
+		{
+			for (uint32_t i = first; i < last; i++)
+			{
+				uint32_t pixel = firstPixel + i;
+				paths.SetRay(i, GetPrimaryRay(pixel % width, pixel / width));
+				paths.SetThroughput(i, glm::vec3(1.0f));
+				paths.BSDFPdf[i] = 0.0f;
+				paths.PixelIndex[i] = pixel;
+				paths.Seed[i] = pixel * GetSampleIndex(pixel);
+				m_PathRadiance[pixel] = glm::vec3(0.0f);
+			}
+		});
+}
+
+// 排序键：高 3 位为方向卦限，低 27 位为起点在所有起点的包围盒内量化到 512^3 网格后的 Morton 码
+void Renderer::SortPaths()
+{
+	PathQueue& paths = m_PathQueue;
+
+	uint32_t chunkCount = (paths.Count + WavefrontChunkSize - 1) / WavefrontChunkSize;
+	m_ChunkBounds.assign(chunkCount, AABB());
+	ForEachPathChunk([&](uint32_t first, uint32_t last, uint32_t chunkIndex)
+		{
+			AABB bounds;
+			for (uint32_t i = first; i < last; i++)
+				bounds.Grow({ paths.OriginX[i], paths.OriginY[i], paths.OriginZ[i] });
+			m_ChunkBounds[chunkIndex] = bounds;
+		});
+
+	AABB bounds;
+	for (const AABB& chunkBounds : m_ChunkBounds)
+		bounds.Grow(chunkBounds);
+	glm::vec3 scale = 512.0f / glm::max(bounds.GetExtent(), glm::vec3(1e-6f));
+
+	m_SortKeys.resize(paths.Count);
+	m_SortIndices.resize(paths.Count);
+	ForEachPathChunk([&](uint32_t first, uint32_t last, uint32_t chunkIndex)
+		{
+			for (uint32_t i = first; i < last; i++)
+			{
+				glm::vec3 origin = { paths.OriginX[i], paths.OriginY[i], paths.OriginZ[i] };
+				glm::uvec3 cell = glm::min(glm::uvec3((origin - bounds.Min) * scale), glm::uvec3(511));
+
+				uint32_t octant = (paths.DirectionX[i] < 0.0f) | (paths.DirectionY[i] < 0.0f) << 1 | (paths.DirectionZ[i] < 0.0f) << 2;
+				m_SortKeys[i] = octant << 27 | SpaceFillingCurve::MortonEncode3D(cell.x, cell.y, cell.z);
+				m_SortIndices[i] = i;
+			}
+		});
+
+	RadixSort::SortPairs(m_ThreadPool, m_SortKeys, m_SortIndices, m_SortTempKeys, m_SortTempIndices, paths.Count, 30);
+
+	PathQueue& sorted = m_CompactedPathQueue;
+	ForEachPathChunk([&](uint32_t first, uint32_t last, uint32_t chunkIndex)
+		{
+			for (uint32_t i = first; i < last; i++)
+				sorted.CopyPath(i, paths, m_SortIndices[i]);
+		});
+
+	sorted.Count = paths.Count;
+	std::swap(m_PathQueue, m_CompactedPathQueue);
+}
+
+void Renderer::ExtendPaths(uint32_t bounce)
+{
+	PathQueue& paths = m_PathQueue;
+	bool primaryVisibility = bounce == 0 && UsePrimaryVisibility();
+	bool cachedHits = bounce == 0 && m_PrimaryHitCache.IsValid();
+	uint32_t width = m_Width;
+
+	ForEachPathChunk([&](uint32_t first, uint32_t last, uint32_t chunkIndex)
+		{
+			for (uint32_t i = first; i < last; i++)
+			{
+				uint32_t pixel = paths.PixelIndex[i];
+				// 位置与法线在 Shade 阶段从缓存读取，不需要距离
+				if (cachedHits)
+				{
+					paths.HitDistance[i] = 0.0f;
+					paths.ObjectIndex[i] = m_PrimaryHitCache.GetObjectIndex(pixel);
+					continue;
+				}
+
+				float hitDistance = FLT_MAX;
+				int objectIndex = -1;
+				bool hit = primaryVisibility
+					? IntersectPrimary(pixel % width, pixel / width, paths.GetRay(i), hitDistance, objectIndex)
+					: Intersect(paths.GetRay(i), hitDistance, objectIndex);
+				paths.HitDistance[i] = hitDistance;
+				paths.ObjectIndex[i] = hit ? objectIndex : -1;
+			}
+		});
+}
+
+// 与 PerPixel 的一次弹射相同：未命中时累加天空颜色并终止，命中时累加自发光并生成漫反射方向；
+// 光源采样的阴影光线写入 m_ShadowQueue 的同一位置，由之后的阶段追踪
+void Renderer::ShadePaths(uint32_t bounce)
+{
+	PathQueue& paths = m_PathQueue;
+	ShadowQueue& shadows = m_ShadowQueue;
+	shadows.Count = paths.Count;
+	const glm::vec3 skyColor = glm::vec3(0.6f, 0.7f, 0.9f);
+	bool cachedHits = bounce == 0 && m_PrimaryHitCache.IsValid();
+	bool storeHits = bounce == 0 && StorePrimaryHits();
+	bool storeSurface = bounce == 0 && m_StorePrimarySurface;
+	bool storeAOVs = bounce == 0 && m_StoreAOVs;
+
+	ForEachPathChunk([&](uint32_t first, uint32_t last, uint32_t chunkIndex)
+		{
+			for (uint32_t i = first; i < last; i++)
+			{
+				uint32_t seed = paths.Seed[i] + bounce;
+				glm::vec3 throughput = paths.GetThroughput(i);
+				glm::vec3& light = m_PathRadiance[paths.PixelIndex[i]];
+
+				int objectIndex = paths.ObjectIndex[i];
+				Ray ray = paths.GetRay(i);
+				HitMessage hitMessage = objectIndex < 0 ? MissHit(ray)
+					: cachedHits ? LoadPrimaryHit(paths.PixelIndex[i])
+					: ClosestHit(ray, paths.HitDistance[i], objectIndex);
+
+				if (storeSurface)
+					StorePrimarySurface(paths.PixelIndex[i], hitMessage);
+				if (storeAOVs)
+					StoreAOVs(paths.PixelIndex[i], hitMessage);
+				if (storeHits)
+					StorePrimaryHit(paths.PixelIndex[i], hitMessage);
+
+				shadows.LightIndex[i] = -1;
+				if (objectIndex < 0)
+				{
+					light += skyColor * throughput;
+					continue;
+				}
+
+				const Material& material = m_ActiveScene->Materials[m_ActiveScene->Sphere[objectIndex].MaterialIndex];
+				glm::vec3 albedo = material.Albedo;
+				glm::vec3 emission = material.GetEmission();
+				if (emission != glm::vec3(0.0f))
+					light += emission * throughput * EmissionWeight(ray.Origin, paths.GetNormal(i), paths.BSDFPdf[i], objectIndex);
+				Ray shadowRay;
+				float distance;
+				int lightIndex;
+				glm::vec3 contribution;
+				if (m_Settings.LightSampling && GenerateShadowRay(hitMessage, albedo, seed, bounce + 1 < Bounces, shadowRay, distance, lightIndex, contribution))
+				{
+					shadows.SetRay(i, shadowRay);
+					shadows.SetContribution(i, throughput * contribution);
+					shadows.PixelIndex[i] = paths.PixelIndex[i];
+					shadows.Distance[i] = distance;
+					shadows.LightIndex[i] = lightIndex;
+				}
+				throughput *= albedo;
+
+				ray.Origin = hitMessage.WorldPosition + hitMessage.WorldNormal * 0.0001f;
+				ray.Direction = glm::normalize(hitMessage.WorldNormal + Utils::InUnitSphere(seed));
+				paths.BSDFPdf[i] = glm::dot(hitMessage.WorldNormal, ray.Direction) * glm::one_over_pi<float>();
+				paths.SetNormal(i, hitMessage.WorldNormal);
+
+				paths.SetRay(i, ray);
+				paths.SetThroughput(i, throughput);
+				paths.Seed[i] = seed;
+			}
+		});
+}
+
+// 与 CompactPaths 相同的保序压缩，只保留有光源样本的阴影光线，结果在 m_CompactedShadowQueue 中
+void Renderer::CompactShadowRays()
+{
+	ShadowQueue& shadows = m_ShadowQueue;
+	ShadowQueue& compacted = m_CompactedShadowQueue;
+
+	uint32_t chunkCount = (shadows.Count + WavefrontChunkSize - 1) / WavefrontChunkSize;
+	m_ChunkOffsets.assign(chunkCount + 1, 0);
+
+	ForEachChunk(shadows.Count, [&](uint32_t first, uint32_t last, uint32_t chunkIndex)
+		{
+			uint32_t count = 0;
+			for (uint32_t i = first; i < last; i++)
+				count += shadows.LightIndex[i] >= 0;
+			m_ChunkOffsets[chunkIndex + 1] = count;
+		});
+
+	for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+		m_ChunkOffsets[chunk + 1] += m_ChunkOffsets[chunk];
+
+	ForEachChunk(shadows.Count, [&](uint32_t first, uint32_t last, uint32_t chunkIndex)
+		{
+			uint32_t offset = m_ChunkOffsets[chunkIndex];
+			for (uint32_t i = first; i < last; i++)
+			{
+				if (shadows.LightIndex[i] >= 0)
+					compacted.CopyShadowRay(offset++, shadows, i);
+			}
+		});
+
+	compacted.Count = m_ChunkOffsets[chunkCount];
+}
+
+// 被遮挡的阴影光线把 LightIndex 置为 -1
+void Renderer::TraceShadowRays()
+{
+	ShadowQueue& shadows = m_CompactedShadowQueue;
+	ForEachChunk(shadows.Count, [&](uint32_t first, uint32_t last, uint32_t chunkIndex)
+		{
+			for (uint32_t i = first; i < last; i++)
+			{
+				if (!IsShadowRayUnoccluded(shadows.GetRay(i), shadows.Distance[i], shadows.LightIndex[i]))
+					shadows.LightIndex[i] = -1;
+			}
+		});
+}
+
+// 每个像素在一批中只有一条路径，各阴影光线写入不同的像素
+void Renderer::AccumulateShadowRays()
+{
+	ShadowQueue& shadows = m_CompactedShadowQueue;
+	ForEachChunk(shadows.Count, [&](uint32_t first, uint32_t last, uint32_t chunkIndex)
+		{
+			for (uint32_t i = first; i < last; i++)
+			{
+				if (shadows.LightIndex[i] >= 0)
+					m_PathRadiance[shadows.PixelIndex[i]] += shadows.GetContribution(i);
+			}
+		});
+}
+
+// 保序压缩：先统计每块存活的路径数，前缀和得到写入位置，再把存活的路径搬到另一个队列
+void Renderer::CompactPaths()
+{
+	PathQueue& paths = m_PathQueue;
+	PathQueue& compacted = m_CompactedPathQueue;
+
+	uint32_t chunkCount = (paths.Count + WavefrontChunkSize - 1) / WavefrontChunkSize;
+	m_ChunkOffsets.assign(chunkCount + 1, 0);
+
+	ForEachPathChunk([&](uint32_t first, uint32_t last, uint32_t chunkIndex)
+		{
+			uint32_t count = 0;
+			for (uint32_t i = first; i < last; i++)
+				count += paths.ObjectIndex[i] >= 0;
+			m_ChunkOffsets[chunkIndex + 1] = count;
+		});
+
+	for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+		m_ChunkOffsets[chunk + 1] += m_ChunkOffsets[chunk];
+
+	ForEachPathChunk([&](uint32_t first, uint32_t last, uint32_t chunkIndex)
+		{
+			uint32_t offset = m_ChunkOffsets[chunkIndex];
+			for (uint32_t i = first; i < last; i++)
+			{
+				if (paths.ObjectIndex[i] >= 0)
+					compacted.CopyPath(offset++, paths, i);
+			}
+		});
+
+	compacted.Count = m_ChunkOffsets[chunkCount];
+	std::swap(m_PathQueue, m_CompactedPathQueue);
+}
+
+bool Renderer::Intersect(const Ray& ray, float& hitDistance, int& objectIndex)
+{
+	switch (m_Settings.Acceleration)
+	{
+		case AccelerationType::BVH:     return m_BVH.Intersect(ray, hitDistance, objectIndex);
+		case AccelerationType::WideBVH: return m_WideBVH.Intersect(ray, hitDistance, objectIndex);
+		case AccelerationType::Grid:    return m_Grid.Intersect(ray, hitDistance, objectIndex);
+		default:                        return m_SphereArray.Intersect(ray, hitDistance, objectIndex);
+	}
+}
+
+bool Renderer::IntersectPrimary(uint32_t x, uint32_t y, const Ray& ray, float& hitDistance, int& objectIndex)
+{
+	if (RasterizePrimaryHits())
+		return m_VisibilityBuffer.GetHit(x, y, hitDistance, objectIndex);
+
+	return m_TileCuller.Intersect(m_TileCuller.GetTileIndex(x, y), ray, hitDistance, objectIndex);
+}
+
+Renderer::HitMessage Renderer::LoadPrimaryHit(uint32_t pixel)
+{
+	HitMessage hitMessage;
+	hitMessage.ObjectIndex = m_PrimaryHitCache.GetObjectIndex(pixel);
+	if (hitMessage.ObjectIndex < 0)
+	{
+		hitMessage.HitDistance = -1;
+		return hitMessage;
+	}
+
+	hitMessage.WorldPosition = m_PrimaryHitCache.GetPosition(pixel);
+	hitMessage.WorldNormal = m_PrimaryHitCache.GetNormal(pixel);
+	hitMessage.HitDistance = glm::distance(hitMessage.WorldPosition, m_ActiveCamera->GetPosition());
+	return hitMessage;
+}
+
+void Renderer::StorePrimaryHit(uint32_t pixel, const HitMessage& hitMessage)
+{
+	if (hitMessage.HitDistance < 0.0f)
+		m_PrimaryHitCache.Store(pixel, glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), -1);
+	else
+		m_PrimaryHitCache.Store(pixel, hitMessage.WorldPosition, hitMessage.WorldNormal, hitMessage.ObjectIndex);
+}
+
+void Renderer::StorePrimarySurface(uint32_t pixel, const HitMessage& hitMessage)
+{
+	bool hit = hitMessage.HitDistance >= 0.0f;
+	m_PrimaryDepth[pixel] = hit ? hitMessage.HitDistance : FLT_MAX;
+	m_PrimaryObjectIndex[pixel] = hit ? hitMessage.ObjectIndex : -1;
+	m_PrimaryNormal[pixel] = hit ? hitMessage.WorldNormal : glm::vec3(0.0f);
+}
+
+void Renderer::StoreAOVs(uint32_t pixel, const HitMessage& hitMessage)
+{
+	const Settings::AOVSettings& aovs = m_StoredAOVs;
+	bool hit = hitMessage.HitDistance >= 0.0f;
+	if (aovs.Depth)
+		m_DepthAOV[pixel] = hit ? hitMessage.HitDistance : FLT_MAX;
+	if (aovs.Normal)
+		m_NormalAOV[pixel] = hit ? hitMessage.WorldNormal : glm::vec3(0.0f);
+	if (aovs.Albedo)
+	{
+		glm::vec3 albedo{ 0.0f };
+		if (hit)
+			albedo = glm::vec3(m_ActiveScene->Materials[m_ActiveScene->Sphere[hitMessage.ObjectIndex].MaterialIndex].Albedo);
+		m_AlbedoAOV[pixel] = albedo;
+	}
+	if (aovs.ObjectID)
+		m_ObjectIDAOV[pixel] = hit ? hitMessage.ObjectIndex : -1;
+}
+
+// 由相机的仿射参数直接生成，开启抖动时每帧在像素内随机偏移
+Ray Renderer::GetPrimaryRay(uint32_t x, uint32_t y) const
+{
+	if (!m_Settings.Jitter)
+		return m_PrimaryRays.GetRay((float)x, (float)y);
+
+	// 与 PerPixel 的随机数序列分开，不影响弹射方向
+	uint32_t pixel = x + y * m_Width;
+	uint32_t seed = Utils::PCG_Hash(pixel) ^ Utils::PCG_Hash(GetSampleIndex(pixel) * 0x9e3779b9u);
+	float offsetX = Utils::RandomFloat(seed);
+	float offsetY = Utils::RandomFloat(seed);
+	return m_PrimaryRays.GetRay(x + offsetX, y + offsetY);
+}
+
+Renderer::HitMessage Renderer::TracePrimaryRay(uint32_t x, uint32_t y)
+{
+	Ray ray = GetPrimaryRay(x, y);
+
+	int closestSphere = -1;
+	float hitDistance = FLT_MAX;
+	if (!IntersectPrimary(x, y, ray, hitDistance, closestSphere))
+		return MissHit(ray);
+
+	return ClosestHit(ray, hitDistance, closestSphere);
+}
+
+// 光线追踪
+Renderer::HitMessage Renderer::TraceRay(const Ray& ray)
+{
+	int closestSphere = -1;
+	float hitDistance = FLT_MAX;
+
+	if (!Intersect(ray, hitDistance, closestSphere))
+		return MissHit(ray);
+
+	return ClosestHit(ray, hitDistance, closestSphere);
+}
+
+// 像素着色器
+glm::vec4 Renderer::PerPixel(int x, int y, const HitMessage* primaryHit)
+{
+	Ray ray = GetPrimaryRay(x, y); // 光线（视线）从摄像机出发
+
+	// glm::vec3 color{ 0.0f };
+	// float multiplier = 1.0f;
+	glm::vec3 light{ 0.0f };
+	glm::vec3 contribution{ 1.0f };
+	// 上一次弹射点的法线与弹射方向的 BSDF 概率密度，主光线为 0
+	glm::vec3 previousNormal{ 0.0f };
+	float bsdfPdf = 0.0f;
+
+	uint32_t seed = x + y * m_Width;
+	seed *= GetSampleIndex(x + y * m_Width);
+
+	for (size_t i = 0; i < Bounces; i++)
+	{
+		seed += i;
+
+		HitMessage hitMessage = i == 0 && primaryHit ? *primaryHit : TraceRay(ray);
+		if (i == 0)
+		{
+			if (m_StorePrimarySurface)
+				StorePrimarySurface(x + y * m_Width, hitMessage);
+			if (m_StoreAOVs)
+				StoreAOVs(x + y * m_Width, hitMessage);
+			if (StorePrimaryHits())
+				StorePrimaryHit(x + y * m_Width, hitMessage);
+		}
+		if (hitMessage.HitDistance < 0.0f)
+		{
+			glm::vec3 skyColor = glm::vec3( 0.6f, 0.7f, 0.9f );
+			light += skyColor * contribution;
+			break;
+		}
+
+		// glm::vec3 lightDir = glm::normalize(glm::vec3(-1.0f)); // 光线方向
+		// float d = glm::max(glm::dot(hitMessage.WorldNormal, -lightDir), 0.0f); // 光线与物体表面法线程度
+
+		const Sphere& closestSphere = m_ActiveScene->Sphere[hitMessage.ObjectIndex];
+		const Material& material = m_ActiveScene->Materials[closestSphere.MaterialIndex];
+		glm::vec3 sphereColor = material.Albedo;
+		// sphereColor *= d;
+		// color += sphereColor * multiplier;
+		// ReSTIR 模式下首次命中处的直接光照全部来自蓄水池，第二次命中的自发光不再计入
+		glm::vec3 emission = material.GetEmission();
+		if (emission != glm::vec3(0.0f) && !(i == 1 && UseReSTIR()))
+			light += emission * contribution * EmissionWeight(ray.Origin, previousNormal, bsdfPdf, hitMessage.ObjectIndex);
+		if (i == 0 && UseReSTIR())
+			light += ShadeReservoir(x + y * m_Width, hitMessage, sphereColor);
+		else if (m_Settings.LightSampling)
+			light += contribution * SampleDirectLight(hitMessage, sphereColor, seed, i + 1 < Bounces);
+
+		// 光线 弹射后
+		contribution *= sphereColor;
+
+		ray.Origin = hitMessage.WorldPosition + hitMessage.WorldNormal * 0.0001f; // 将反射后的光线起始点更改成交点
+		// ray.Direction = glm::reflect(ray.Direction, 
+		// 	 hitMessage.WorldNormal + material.Roughness * Walnut::Random::Vec3(-0.5f, 0.5f)); // 将反射后光线方向改为镜面反射方向
+		// ray.Direction = glm::normalize(hitMessage.WorldNormal + Walnut::Random::InUnitSphere()); // 将反射后光线方向改为漫反射方向 原方案随机数
+		ray.Direction = glm::normalize(hitMessage.WorldNormal + Utils::InUnitSphere(seed)); // 将反射后光线方向改为漫反射方向
+		bsdfPdf = glm::dot(hitMessage.WorldNormal, ray.Direction) * glm::one_over_pi<float>();
+		previousNormal = hitMessage.WorldNormal;
+	}
+
+	return glm::vec4(light, 1.0f);
+}
+
+// 对光源采样一次并追踪阴影光线，返回漫反射表面接收的直接光照（未乘路径吞吐量）；
+// 最后一次弹射之后不再做 BSDF 采样，此时 misWeight 为 false，光源采样的结果不加权
+glm::vec3 Renderer::SampleDirectLight(const HitMessage& hitMessage, const glm::vec3& albedo, uint32_t& seed, bool misWeight)
+{
+	Ray shadowRay;
+	float distance;
+	int lightIndex;
+	glm::vec3 contribution;
+	if (!GenerateShadowRay(hitMessage, albedo, seed, misWeight, shadowRay, distance, lightIndex, contribution)
+		|| !IsShadowRayUnoccluded(shadowRay, distance, lightIndex))
+		return glm::vec3(0.0f);
+	return contribution;
+}
+
+bool Renderer::GenerateShadowRay(const HitMessage& hitMessage, const glm::vec3& albedo, uint32_t& seed, bool misWeight, Ray& shadowRay, float& distance, int& lightIndex, glm::vec3& contribution)
+{
+	glm::vec3 random;
+	random.x = Utils::RandomFloat(seed);
+	random.y = Utils::RandomFloat(seed);
+	random.z = Utils::RandomFloat(seed);
+
+	LightSampler::Sample sample;
+	if (!m_LightSampler.SampleLight(hitMessage.WorldPosition, hitMessage.WorldNormal, random, sample) || sample.ObjectIndex == hitMessage.ObjectIndex)
+		return false;
+
+	float cosine = glm::dot(hitMessage.WorldNormal, sample.Direction);
+	if (cosine <= 0.0f)
+		return false;
+
+	shadowRay = { hitMessage.WorldPosition + hitMessage.WorldNormal * 0.0001f, sample.Direction };
+	distance = sample.Distance;
+	lightIndex = sample.ObjectIndex;
+
+	// 漫反射 BRDF 为 albedo / π，BSDF 采样同一方向的概率密度为 cos / π
+	float bsdfPdf = cosine * glm::one_over_pi<float>();
+	float weight = misWeight ? Utils::PowerHeuristic(sample.Pdf, bsdfPdf) : 1.0f;
+	const Material& light = m_ActiveScene->Materials[m_ActiveScene->Sphere[sample.ObjectIndex].MaterialIndex];
+	contribution = light.GetEmission() * albedo * (bsdfPdf / sample.Pdf * weight);
+	return true;
+}
+
+// 朝向光源球心，球心之前第一个命中的是该光源才未被遮挡（光源表面上的点用 IsLightVisible）
+bool Renderer::IsShadowRayUnoccluded(const Ray& shadowRay, float distance, int lightIndex)
+{
+	int objectIndex = -1;
+	return Intersect(shadowRay, distance, objectIndex) && objectIndex == lightIndex;
+}
+
+// BSDF 采样的光线从 origin（法线为 normal）出发命中自发光球体时，自发光的多重重要性采样权重
+float Renderer::EmissionWeight(const glm::vec3& origin, const glm::vec3& normal, float bsdfPdf, int objectIndex) const
+{
+	if (!m_Settings.LightSampling || bsdfPdf <= 0.0f)
+		return 1.0f;
+
+	return Utils::PowerHeuristic(bsdfPdf, m_LightSampler.Pdf(origin, normal, objectIndex));
+}
+
+// ReSTIR 的三遍都按 tile 并行：先逐像素生成候选并并入上一帧的蓄水池，全部写完后再做空间复用，
+// 避免读到其他线程本帧已复用过的邻域；着色在 RenderTiles 中随 PerPixel 进行
+void Renderer::ResampleDirectLight()
+{
+	uint32_t pixelCount = m_Width * m_Height;
+	std::swap(m_ReservoirHits, m_PreviousReservoirHits);
+	std::swap(m_TemporalReservoirs, m_PreviousReservoirs);
+	m_ReservoirHits.resize(pixelCount);
+	m_TemporalReservoirs.resize(pixelCount);
+
+	ForEachTile([this](uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY)
+		{
+			for (uint32_t y = minY; y < maxY; y++)
+			{
+				for (uint32_t x = minX; x < maxX; x++)
+					GenerateReservoir(x, y);
+			}
+		});
+
+	if (m_Settings.Resampling.SpatialReuse)
+	{
+		m_Reservoirs.resize(pixelCount);
+		ForEachTile([this](uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY)
+			{
+				for (uint32_t y = minY; y < maxY; y++)
+				{
+					for (uint32_t x = minX; x < maxX; x++)
+						SpatialReuse(x, y);
+				}
+			});
+	}
+	else
+		m_Reservoirs.clear();
+
+	m_ReservoirView = { m_ActiveCamera->GetProjection() * m_ActiveCamera->GetView(), m_Width, m_Height };
+	m_ReservoirFrame++;
+}
+
+void Renderer::ForEachTile(const std::function<void(uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY)>& kernel)
+{
+	uint32_t tileSize = GetTileSize();
+	uint32_t tileCountX = (m_Width + tileSize - 1) / tileSize;
+	uint32_t tileCountY = (m_Height + tileSize - 1) / tileSize;
+
+	m_ThreadPool.ParallelFor(tileCountX * tileCountY, [&](uint32_t tileIndex, uint32_t threadIndex)
+		{
+			uint32_t minX = tileIndex % tileCountX * tileSize;
+			uint32_t minY = tileIndex / tileCountX * tileSize;
+			uint32_t maxX = glm::min(minX + tileSize, m_Width);
+			uint32_t maxY = glm::min(minY + tileSize, m_Height);
+			kernel(minX, minY, maxX, maxY);
+		});
+}
+
+// 追踪首次命中，从光源采样器取 CandidateCount 个候选按 目标函数 / 面积上的概率密度 加权抽样（RIS），
+// 选中的候选被遮挡时清空权重（保留候选数），再并入上一帧同一表面处的蓄水池
+void Renderer::GenerateReservoir(uint32_t x, uint32_t y)
+{
+	uint32_t pixel = x + y * m_Width;
+	HitMessage& hitMessage = m_ReservoirHits[pixel];
+	Reservoir& reservoir = m_TemporalReservoirs[pixel];
+	reservoir = Reservoir();
+
+	if (!IsPixelTraced(x, y))
+	{
+		hitMessage.HitDistance = -1.0f;
+		return;
+	}
+
+	if (m_PrimaryHitCache.IsValid())
+		hitMessage = LoadPrimaryHit(pixel);
+	else if (UsePrimaryVisibility())
+		hitMessage = TracePrimaryRay(x, y);
+	else
+		hitMessage = TraceRay(GetPrimaryRay(x, y));
+	if (hitMessage.HitDistance < 0.0f)
+		return;
+
+	const Settings::ReSTIRSettings& settings = m_Settings.Resampling;
+	glm::vec3 albedo = m_ActiveScene->Materials[m_ActiveScene->Sphere[hitMessage.ObjectIndex].MaterialIndex].Albedo;
+	// 与 PerPixel 的随机数序列分开；按帧变化，累积关闭时每帧的候选也不同
+	uint32_t seed = Utils::PCG_Hash(pixel) ^ Utils::PCG_Hash(m_ReservoirFrame * 0x9e3779b9u + 1u);
+
+	uint32_t candidateCount = glm::max(settings.CandidateCount, 1u);
+	for (uint32_t candidate = 0; candidate < candidateCount; candidate++)
+	{
+		glm::vec3 random;
+		random.x = Utils::RandomFloat(seed);
+		random.y = Utils::RandomFloat(seed);
+		random.z = Utils::RandomFloat(seed);
+		float select = Utils::RandomFloat(seed);
+
+		LightSampler::Sample sample;
+		if (!m_LightSampler.SampleLight(hitMessage.WorldPosition, hitMessage.WorldNormal, random, sample) || sample.ObjectIndex == hitMessage.ObjectIndex)
+			continue;
+
+		Ray shadowRay;
+		float distance;
+		float targetPdf = Utils::Luminance(EvaluateLightPoint(hitMessage, albedo, sample.ObjectIndex, sample.Normal, shadowRay, distance));
+		float cosLight = -glm::dot(sample.Normal, shadowRay.Direction);
+		if (targetPdf <= 0.0f || cosLight <= 0.0f)
+			continue;
+
+		// 立体角上的概率密度换算到光源表面积上，与目标函数的测度一致，不同像素的样本才能互相复用
+		float areaPdf = sample.Pdf * cosLight / (distance * distance);
+		reservoir.Update(sample.ObjectIndex, sample.Normal, targetPdf, targetPdf / areaPdf / candidateCount, select);
+	}
+	reservoir.M = (float)candidateCount;
+	reservoir.FinalizeWeight();
+
+	if (reservoir.W > 0.0f)
+	{
+		Ray shadowRay;
+		float distance;
+		EvaluateLightPoint(hitMessage, albedo, reservoir.ObjectIndex, reservoir.LightNormal, shadowRay, distance);
+		// 权重和一并清零，之后并入的样本不会沾上这个被遮挡样本的权重
+		if (!IsLightVisible(shadowRay, distance, reservoir.ObjectIndex))
+			reservoir.WeightSum = reservoir.W = 0.0f;
+	}
+
+	// 首次命中投影到上一帧的画面，与那里的首次命中是同一表面时并入，上一帧的候选数限制在本帧的 MaxHistoryLength 倍以内
+	const auto& view = m_ReservoirView;
+	if (!settings.TemporalReuse || m_PreviousReservoirs.size() != view.Width * view.Height || m_PreviousReservoirHits.size() != m_PreviousReservoirs.size())
+		return;
+
+	glm::vec4 clip = view.ViewProjection * glm::vec4(hitMessage.WorldPosition, 1.0f);
+	if (clip.w <= 0.0f)
+		return;
+
+	glm::vec2 ndc = glm::vec2(clip) / clip.w;
+	int previousX = (int)glm::round((ndc.x * 0.5f + 0.5f) * view.Width);
+	int previousY = (int)glm::round((ndc.y * 0.5f + 0.5f) * view.Height);
+	if (previousX < 0 || previousY < 0 || previousX >= (int)view.Width || previousY >= (int)view.Height)
+		return;
+
+	uint32_t previousPixel = previousX + previousY * view.Width;
+	const HitMessage& previousHit = m_PreviousReservoirHits[previousPixel];
+	if (previousHit.HitDistance < 0.0f
+		|| !Utils::IsSimilarSurface(hitMessage.WorldPosition, hitMessage.WorldNormal, hitMessage.HitDistance, previousHit.WorldPosition, previousHit.WorldNormal))
+		return;
+
+	Reservoir previous = m_PreviousReservoirs[previousPixel];
+	if (previous.M <= 0.0f)
+		return;
+	previous.M = glm::min(previous.M, (float)(candidateCount * settings.MaxHistoryLength));
+
+	Reservoir current = reservoir;
+	const HitMessage* hits[] = { &hitMessage, &previousHit };
+	const Reservoir* reservoirs[] = { &current, &previous };
+	reservoir = CombineReservoirs(hits, reservoirs, 2, seed);
+}
+
+// 在 SpatialRadius 像素内随机选 SpatialSamples 个邻域像素，与本像素是同一表面时并入它们时域复用后的蓄水池
+void Renderer::SpatialReuse(uint32_t x, uint32_t y)
+{
+	uint32_t pixel = x + y * m_Width;
+	const HitMessage& hitMessage = m_ReservoirHits[pixel];
+	Reservoir& reservoir = m_Reservoirs[pixel];
+	reservoir = m_TemporalReservoirs[pixel];
+	if (hitMessage.HitDistance < 0.0f)
+		return;
+
+	const Settings::ReSTIRSettings& settings = m_Settings.Resampling;
+	uint32_t seed = Utils::PCG_Hash(pixel) ^ Utils::PCG_Hash(m_ReservoirFrame * 0x9e3779b9u + 2u);
+
+	const HitMessage* hits[MaxCombinedReservoirs] = { &hitMessage };
+	const Reservoir* reservoirs[MaxCombinedReservoirs] = { &m_TemporalReservoirs[pixel] };
+	uint32_t count = 1;
+	uint32_t sampleCount = glm::min(settings.SpatialSamples, MaxCombinedReservoirs - 1);
+	for (uint32_t i = 0; i < sampleCount; i++)
+	{
+		float radius = settings.SpatialRadius * glm::sqrt(Utils::RandomFloat(seed));
+		float angle = glm::two_pi<float>() * Utils::RandomFloat(seed);
+		int neighbourX = (int)x + (int)glm::round(radius * glm::cos(angle));
+		int neighbourY = (int)y + (int)glm::round(radius * glm::sin(angle));
+		if (neighbourX < 0 || neighbourY < 0 || neighbourX >= (int)m_Width || neighbourY >= (int)m_Height)
+			continue;
+
+		uint32_t neighbour = neighbourX + neighbourY * m_Width;
+		const HitMessage& neighbourHit = m_ReservoirHits[neighbour];
+		const Reservoir& candidate = m_TemporalReservoirs[neighbour];
+		if (neighbour == pixel || neighbourHit.HitDistance < 0.0f || candidate.M <= 0.0f
+			|| !Utils::IsSimilarSurface(hitMessage.WorldPosition, hitMessage.WorldNormal, hitMessage.HitDistance, neighbourHit.WorldPosition, neighbourHit.WorldNormal))
+			continue;
+
+		hits[count] = &neighbourHit;
+		reservoirs[count] = &candidate;
+		count++;
+	}
+	reservoir = CombineReservoirs(hits, reservoirs, count, seed);
+}
+
+// 广义平衡启发式：第 i 个蓄水池的样本 y 的权重为 M_i p_i(y) / Σ_j M_j p_j(y)，p_j 在第 j 个蓄水池所属的首次命中处计算。
+// 只按 1/M 平均时，邻域中目标函数为零的样本会冲淡本像素的亮处；样本在邻域处是否被遮挡不考虑，阴影边缘略有偏差
+Reservoir Renderer::CombineReservoirs(const HitMessage* const* hits, const Reservoir* const* reservoirs, uint32_t count, uint32_t& seed) const
+{
+	glm::vec3 albedos[MaxCombinedReservoirs];
+	for (uint32_t i = 0; i < count; i++)
+		albedos[i] = m_ActiveScene->Materials[m_ActiveScene->Sphere[hits[i]->ObjectIndex].MaterialIndex].Albedo;
+
+	Reservoir result;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const Reservoir& input = *reservoirs[i];
+		float select = Utils::RandomFloat(seed);
+		if (input.W <= 0.0f)
+		{
+			result.M += input.M;
+			continue;
+		}
+
+		float denominator = 0.0f;
+		for (uint32_t j = 0; j < count; j++)
+			denominator += reservoirs[j]->M * (j == i ? input.TargetPdf : EvaluateTargetPdf(*hits[j], albedos[j], input));
+		float misWeight = denominator > 0.0f ? input.M * input.TargetPdf / denominator : 0.0f;
+
+		float targetPdf = i == 0 ? input.TargetPdf : EvaluateTargetPdf(*hits[0], albedos[0], input);
+		result.Merge(input, targetPdf, misWeight, select);
+	}
+	result.FinalizeWeight();
+	return result;
+}
+
+// 漫反射 BRDF 为 albedo / π，面积测度下的几何项为 cos(着色点) * cos(光源) / 距离平方
+glm::vec3 Renderer::EvaluateLightPoint(const HitMessage& hitMessage, const glm::vec3& albedo, int objectIndex, const glm::vec3& lightNormal, Ray& shadowRay, float& distance) const
+{
+	const Sphere& light = m_ActiveScene->Sphere[objectIndex];
+	glm::vec3 lightPoint = light.Position + lightNormal * light.Radius;
+
+	shadowRay.Origin = hitMessage.WorldPosition + hitMessage.WorldNormal * 0.0001f;
+	glm::vec3 toLight = lightPoint - shadowRay.Origin;
+	distance = glm::length(toLight);
+	shadowRay.Direction = toLight / distance;
+
+	float cosSurface = glm::dot(hitMessage.WorldNormal, shadowRay.Direction);
+	float cosLight = -glm::dot(lightNormal, shadowRay.Direction);
+	if (cosSurface <= 0.0f || cosLight <= 0.0f)
+		return glm::vec3(0.0f);
+
+	glm::vec3 emission = m_ActiveScene->Materials[light.MaterialIndex].GetEmission();
+	return emission * albedo * (glm::one_over_pi<float>() * cosSurface * cosLight / (distance * distance));
+}
+
+// 复用的蓄水池来自其他像素或上一帧，光源可能已被删除或不再发光，此时目标函数为 0
+float Renderer::EvaluateTargetPdf(const HitMessage& hitMessage, const glm::vec3& albedo, const Reservoir& reservoir) const
+{
+	if (reservoir.ObjectIndex < 0 || reservoir.ObjectIndex >= (int)m_ActiveScene->Sphere.size() || reservoir.ObjectIndex == hitMessage.ObjectIndex)
+		return 0.0f;
+
+	Ray shadowRay;
+	float distance;
+	return Utils::Luminance(EvaluateLightPoint(hitMessage, albedo, reservoir.ObjectIndex, reservoir.LightNormal, shadowRay, distance));
+}
+
+// 采样点朝向着色点，沿阴影光线第一个命中的就是该光源时可见
+bool Renderer::IsLightVisible(const Ray& shadowRay, float distance, int objectIndex)
+{
+	float hitDistance = distance * 1.001f;
+	int hitObject = -1;
+	return Intersect(shadowRay, hitDistance, hitObject) && hitObject == objectIndex;
+}
+
+// 蓄水池选中的光源点对首次命中的直接光照：被积函数 × 贡献权重 W，另追踪一条阴影光线
+glm::vec3 Renderer::ShadeReservoir(uint32_t pixel, const HitMessage& hitMessage, const glm::vec3& albedo)
+{
+	const std::vector<Reservoir>& reservoirs = m_Settings.Resampling.SpatialReuse ? m_Reservoirs : m_TemporalReservoirs;
+	if (pixel >= reservoirs.size())
+		return glm::vec3(0.0f);
+
+	const Reservoir& reservoir = reservoirs[pixel];
+	if (reservoir.W <= 0.0f || reservoir.ObjectIndex < 0 || reservoir.ObjectIndex >= (int)m_ActiveScene->Sphere.size())
+		return glm::vec3(0.0f);
+
+	Ray shadowRay;
+	float distance;
+	glm::vec3 radiance = EvaluateLightPoint(hitMessage, albedo, reservoir.ObjectIndex, reservoir.LightNormal, shadowRay, distance);
+	if (radiance == glm::vec3(0.0f) || !IsLightVisible(shadowRay, distance, reservoir.ObjectIndex))
+		return glm::vec3(0.0f);
+
+	return radiance * reservoir.W;
 }
 
 Renderer::HitMessage Renderer::ClosestHit(const Ray& ray, float hitDistance, int objectIndex)
@@ -233,11 +1892,11 @@ Renderer::HitMessage Renderer::ClosestHit(const Ray& ray, float hitDistance, int
 
 	const Sphere& closestsphere = m_ActiveScene->Sphere[objectIndex];
 
-	// 󽻵
+	// 求交点坐标
 	// a + bt
 	glm::vec3 origin = ray.Origin - closestsphere.Position;
 	hitMessage.WorldPosition = origin + ray.Direction * hitMessage.HitDistance;
-	hitMessage.WorldNormal = glm::normalize(hitMessage.WorldPosition); // Ϊ-ԭ
+	hitMessage.WorldNormal = glm::normalize(hitMessage.WorldPosition); // 法线为交点-原点
 	hitMessage.WorldPosition += closestsphere.Position;
 
 	return hitMessage;
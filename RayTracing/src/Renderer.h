@@ -1,6 +1,8 @@
 #pragma once
 
+#ifndef RT_HEADLESS
 #include "Walnut/Image.h"
+#endif
 
 #include <memory>
 #include <glm/glm.hpp>
@@ -9,24 +11,210 @@
 #include "Scene.h"
 
 #include "Ray.h"
+#include "BVH.h"
+#include "WideBVH.h"
+#include "Grid.h"
+#include "SphereArray.h"
+#include "ThreadPool.h"
+#include "SpaceFillingCurve.h"
+#include "PathQueue.h"
+#include "RadixSort.h"
+#include "TileCuller.h"
+#include "VisibilityBuffer.h"
+#include "PrimaryHitCache.h"
+#include "Denoiser.h"
+#include "LightSampler.h"
+#include "Reservoir.h"
 
 class Renderer
 {
 public:
+	enum class AccelerationType
+	{
+		None = 0, // 暴力遍历所有球体（SIMD 批量求交）
+		BVH,
+		WideBVH,  // 8 叉量化 BVH
+		Grid      // 均匀网格，球体移动时每帧重建
+	};
+
+	enum class IntegratorType
+	{
+		Megakernel = 0, // 每个像素在 PerPixel 中完成全部弹射
+		Wavefront       // 一批路径逐阶段处理：生成、求交、着色、追踪阴影光线，弹射之间压缩掉终止的路径
+	};
+
 	struct Settings
 	{
 		bool Accumulate = true;
+		AccelerationType Acceleration = AccelerationType::BVH;
+		BVH::BuildQuality BVHQuality = BVH::BuildQuality::Balanced;
+		// 只移动球体时先 Refit，SAH 代价劣化超过该倍数才重建子树
+		float RefitThreshold = 1.5f;
+		// 主光线按 4x2 像素一组追踪，之后的弹射逐条追踪
+		bool PacketTracing = true;
+
+		// 画面按 TileSize x TileSize 的 tile 分配给线程，取 4 的倍数；ThreadCount 为 0 时使用全部硬件线程
+		uint32_t TileSize = 32;
+		uint32_t ThreadCount = 0;
+		// 主光线只与所在 tile 的候选球体求交，相机移动或场景变化时重建候选列表
+		bool TileCulling = false;
+		// 主光线的首次命中改为光栅化到可见性缓冲区，相机与场景不变时直接复用；开启后不使用光线组
+		bool UseVisibilityBuffer = false;
+		// 相机与场景不变时复用上一帧缓存的主光线首次命中，省去每帧一次主光线追踪
+		bool CachePrimaryHits = true;
+		// 主光线在像素内随机抖动（抗锯齿）；每帧的主光线不同，开启后不缓存首次命中，也不使用可见性缓冲区
+		bool Jitter = false;
+		// 每次弹射对自发光球体做一次直接光照采样（next event estimation），与 BSDF 采样按多重重要性采样合并
+		bool LightSampling = true;
+		LightSampler::Type LightSelection = LightSampler::Type::LightTree;
+		// ReSTIR：首次命中处的直接光照改为逐像素蓄水池重采样出的一个光源样本。蓄水池由若干候选光源加权抽样得到，
+		// 再并入上一帧重投影处与邻域像素的蓄水池；之后的弹射照常做光源采样。需开启光源采样，只用于 Megakernel，开启后不使用自适应采样、光线组与棋盘格
+		// （棋盘格下上一帧同一像素没有追踪，时域复用找不到历史）
+		bool ReSTIR = false;
+		struct ReSTIRSettings
+		{
+			uint32_t CandidateCount = 8;   // 每个像素每帧的候选光源数
+			bool TemporalReuse = true;
+			uint32_t MaxHistoryLength = 20; // 上一帧蓄水池代表的候选数最多为本帧的该倍数
+			bool SpatialReuse = true;
+			uint32_t SpatialSamples = 4;    // 并入的邻域像素数（至多 8）
+			float SpatialRadius = 8.0f;     // 邻域半径（像素）
+		} Resampling;
+
+		// tile 的分配顺序与 tile 内像素（或 4x2 像素块）的处理顺序
+		SpaceFillingCurve::Type TileOrder = SpaceFillingCurve::Type::Hilbert;
+		SpaceFillingCurve::Type PixelOrder = SpaceFillingCurve::Type::Hilbert;
+
+		IntegratorType Integrator = IntegratorType::Megakernel;
+		// 波前模式下从第二次弹射起，按起点所在格子与方向卦限排序后再求交
+		bool SortRays = false;
+
+		// 自适应采样：跳过误差低于阈值的 tile，省下的采样数分给未收敛的 tile；只用于 Megakernel 且开启累积时
+		bool AdaptiveSampling = false;
+		float AdaptiveThreshold = 0.02f; // tile 内像素亮度的平均相对标准误差
+		uint32_t AdaptiveMinSamples = 16;
+		uint32_t AdaptiveMaxSamplesPerFrame = 4;
+		// 显示每个像素的采样数（蓝色最少，红色最多）而不是颜色
+		bool ShowSampleCount = false;
+
+		// 相机移动时降低渲染分辨率，使帧时间（毫秒）不超过目标，再放大到视口；相机静止后恢复原始分辨率
+		bool DynamicResolution = true;
+		float TargetFrameTime = 33.0f;
+		float MinResolutionScale = 0.25f;
+
+		// 棋盘格渲染：每帧只追踪一半像素，两种棋盘格逐帧交替；其余像素沿用之前累积的结果，没有时从上一帧重投影，
+		// 被遮挡或移出画面时再由邻域按物体与法线边缘重建。只用于 Megakernel，开启 ReSTIR 时不使用
+		bool Checkerboard = false;
+
+		// 累积结果转换为 RGBA8 之前先做边缘感知的 à-trous 滤波降噪
+		bool Denoise = false;
+		Denoiser::Settings Denoising;
+
+		// 相机移动时把之前累积的颜色按首次命中距离重投影到新视角，未被遮挡的像素保留历史采样
+		bool TemporalReprojection = false;
+		uint32_t MaxHistorySamples = 64;
+		float HistoryClampScale = 2.0f; // 历史颜色限制在本帧邻域均值 ± 该倍数的标准差内
+
+		// 附加输出（AOV）：与颜色在同一遍中写入的逐像素缓冲区，不额外追踪光线；关闭的项不写入
+		struct AOVSettings
+		{
+			bool Depth = false;       // 主光线首次命中距离，未命中为 FLT_MAX
+			bool Normal = false;      // 首次命中的世界空间法线，未命中为零向量
+			bool Albedo = false;      // 首次命中的材质反照率，未命中为零
+			bool ObjectID = false;    // 首次命中的球体索引，未命中为 -1
+			bool SampleCount = false; // 已累积的采样数
+		} AOVs;
+	};
+
+	// 波前模式上一帧每次弹射的统计，累计整帧所有批次，耗时单位为毫秒
+	struct WavefrontBounceStats
+	{
+		uint32_t PathCount = 0;
+		uint32_t ShadowRayCount = 0;
+		float SortTime = 0.0f;
+		float ExtendTime = 0.0f;
+		float ShadowTime = 0.0f;
 	};
 
 	Renderer() = default;
 	void OnResize(uint32_t width, uint32_t height);
 	void Render(const Scene& scene,  const Camera& camera);
 
+#ifndef RT_HEADLESS
 	std::shared_ptr<Walnut::Image> GetFinalImage() const { return m_FinalImage; }
+#endif
+	// 上一帧输出的 RGBA8 像素，按渲染分辨率（GetRenderResolution）排列
+	const uint32_t* GetImageData() const { return m_ImageData; }
+	// 上一帧放大到视口大小后的 RGBA8 像素，即最终图像的内容；第 0 行在画面底部
+	const uint32_t* GetFinalImageData() const { return m_Width != m_ViewportWidth || m_Height != m_ViewportHeight ? m_UpscaledImageData.data() : m_ImageData; }
+	glm::uvec2 GetViewportSize() const { return { m_ViewportWidth, m_ViewportHeight }; }
 
 	void ResetFrameIndex() { m_FrameIndex = 1; }
+	// 相机移动后调用：开启时域重投影时下一帧复用可重投影的历史，否则重新累积
+	void OnCameraMoved()
+	{
+		if (m_Settings.TemporalReprojection)
+			m_ReprojectHistory = true;
+		else
+			ResetFrameIndex();
+	}
+	// 球体被增删后调用，下一帧重建加速结构；只修改位置或半径时传入 false，下一帧 Refit
+	void OnSceneChanged(bool topologyChanged = true)
+	{
+		if (topologyChanged)
+			m_SceneDirty = true;
+		else
+			m_GeometryDirty = true;
+		ResetFrameIndex();
+	}
+	// 材质被修改后调用，下一帧重新收集发光的球体
+	void OnMaterialChanged()
+	{
+		m_LightsDirty = true;
+		ResetFrameIndex();
+	}
+
 	Settings& GetSettings() { return m_Settings; }
+	const BVH& GetBVH() const { return m_BVH; }
+	const WideBVH& GetWideBVH() const { return m_WideBVH; }
+	const Grid& GetGrid() const { return m_Grid; }
+	const TileCuller& GetTileCuller() const { return m_TileCuller; }
+	const VisibilityBuffer& GetVisibilityBuffer() const { return m_VisibilityBuffer; }
+	const PrimaryHitCache& GetPrimaryHitCache() const { return m_PrimaryHitCache; }
+	const Denoiser& GetDenoiser() const { return m_Denoiser; }
+	const LightSampler& GetLightSampler() const { return m_LightSampler; }
+
+	// 上一帧每个 tile 的耗时（毫秒），按行优先排列
+	const std::vector<float>& GetTileTimes() const { return m_TileTimes; }
+	glm::uvec2 GetTileCount() const { return { m_TileCountX, m_TileCountY }; }
+	uint32_t GetThreadCount() const { return m_ThreadPool.GetThreadCount(); }
+	uint32_t GetStealCount() const { return m_ThreadPool.GetStealCount(); }
+
+	const std::vector<WavefrontBounceStats>& GetWavefrontStats() const { return m_WavefrontStats; }
+
+	// 上一帧自适应采样的已收敛 tile 数，以及未收敛的 tile 每个像素的采样数
+	uint32_t GetConvergedTileCount() const { return m_ConvergedTileCount; }
+	uint32_t GetAdaptiveSampleCount() const { return m_AdaptiveSampleCount; }
+
+	// 上一帧的渲染分辨率（动态分辨率下可能小于视口）
+	glm::uvec2 GetRenderResolution() const { return { m_Width, m_Height }; }
+
+	// 上一帧写入的 AOV，按渲染分辨率排列；该项未开启时返回 nullptr
+	const float* GetDepthAOV() const { return m_WrittenAOVs.Depth ? m_DepthAOV.data() : nullptr; }
+	const glm::vec3* GetNormalAOV() const { return m_WrittenAOVs.Normal ? m_NormalAOV.data() : nullptr; }
+	const glm::vec3* GetAlbedoAOV() const { return m_WrittenAOVs.Albedo ? m_AlbedoAOV.data() : nullptr; }
+	const int* GetObjectIDAOV() const { return m_WrittenAOVs.ObjectID ? m_ObjectIDAOV.data() : nullptr; }
+	const uint32_t* GetSampleCountAOV() const { return m_WrittenAOVs.SampleCount ? m_SampleCounts.data() : nullptr; }
 private:
+	static constexpr uint32_t PacketWidth = 4, PacketHeight = 2;
+	static constexpr uint32_t Bounces = 5; // 光线弹射次数
+
+	// 波前模式每批处理的路径数与每个任务处理的路径数
+	static constexpr uint32_t WavefrontBatchSize = 1 << 18;
+	static constexpr uint32_t WavefrontChunkSize = 4096;
+	// ReSTIR 一次合并的蓄水池数上限：空间复用时本像素加至多 8 个邻域
+	static constexpr uint32_t MaxCombinedReservoirs = 9;
+
 	struct HitMessage
 	{
 		float HitDistance;
@@ -36,19 +224,222 @@ private:
 		int ObjectIndex;
 	};
 
+	bool UpdateRenderResolution();
+	void UpscaleImage();
+	void SaveHistory(const glm::mat4& viewProjection, const glm::vec3& origin, uint32_t width, uint32_t height);
+	void ReprojectHistory();
+	// useHistory 为 true 时 m_History 为上一帧的结果，缺少的像素先尝试从中重投影
+	void ReconstructCheckerboard(bool useHistory);
+	void ReconstructCheckerboardAOVs();
+	// 像素 (x, y) 的首次命中在上一帧画面中未被遮挡的对应像素；本帧没有追踪的像素依次用上下左右相邻像素的首次命中距离估计
+	bool FindHistoryPixel(uint32_t x, uint32_t y, uint32_t& historyPixel) const;
+	bool UseDenoiser() const { return m_Settings.Denoise && !m_Settings.ShowSampleCount; }
+	// 首次命中的距离、物体与法线供时域重投影、棋盘格重建与降噪使用，都不需要时不写入；AOV 另存一份，互不影响
+	bool NeedPrimarySurface() const
+	{
+		return m_Settings.TemporalReprojection || UseCheckerboard() || UseDenoiser();
+	}
+	void DenoiseImage();
+	void UpdateAccelerationStructure(const Scene& scene);
+	void InvalidatePrimaryCaches();
+	void UpdatePrimaryVisibility(uint32_t tileSize);
+	// tile 边长对齐到光线组覆盖的宽度，光线组不会跨越 tile
+	uint32_t GetTileSize() const
+	{
+		uint32_t alignment = GetPacketSpanX();
+		return glm::max((m_Settings.TileSize + alignment - 1) / alignment * alignment, alignment);
+	}
+	// 一组光线覆盖的像素宽度：棋盘格模式下为 8x2 像素中本帧追踪的 8 个，不追踪的像素不占用通道
+	uint32_t GetPacketSpanX() const { return UseCheckerboard() ? PacketWidth * 2 : PacketWidth; }
+	bool UsePrimaryVisibility() const { return m_Settings.TileCulling || RasterizePrimaryHits(); }
+	bool RasterizePrimaryHits() const { return m_Settings.UseVisibilityBuffer && !m_Settings.Jitter; }
+	bool UsePacketTracing() const { return m_Settings.PacketTracing && !RasterizePrimaryHits() && !m_PrimaryHitCache.IsValid() && !UseReSTIR(); }
+	// 本帧是否把首次命中写入缓存
+	bool StorePrimaryHits() const { return m_Settings.CachePrimaryHits && !m_Settings.Jitter && !m_PrimaryHitCache.IsValid(); }
+	bool UseCheckerboard() const { return m_Settings.Checkerboard && m_Settings.Integrator == IntegratorType::Megakernel && !UseReSTIR(); }
+	// 棋盘格模式下本帧是否追踪该像素
+	bool IsPixelTraced(uint32_t x, uint32_t y) const { return !UseCheckerboard() || ((x + y + m_CheckerboardPhase) & 1) == 0; }
+	bool UseAdaptiveSampling() const { return m_Settings.AdaptiveSampling && m_Settings.Accumulate && m_Settings.Integrator == IntegratorType::Megakernel && !UseReSTIR(); }
+	bool UseReSTIR() const { return m_Settings.ReSTIR && m_Settings.LightSampling && m_Settings.Integrator == IntegratorType::Megakernel; }
+	// 像素下一个采样的序号（从 1 开始），用于随机数种子
+	uint32_t GetSampleIndex(uint32_t pixel) const { return m_SampleCounts[pixel] + 1; }
+
+	bool Intersect(const Ray& ray, float& hitDistance, int& objectIndex);
 	HitMessage TraceRay(const Ray& ray);
-	glm::vec4 PerPixel(int x, int y);
+	void TracePacket(uint32_t tileIndex, const RayPacket& packet, RayPacketHit& hit);
+	// 主光线从可见性缓冲区读取，或只与所在 tile 的候选球体求交
+	bool IntersectPrimary(uint32_t x, uint32_t y, const Ray& ray, float& hitDistance, int& objectIndex);
+	Ray GetPrimaryRay(uint32_t x, uint32_t y) const;
+	HitMessage TracePrimaryRay(uint32_t x, uint32_t y);
+	HitMessage LoadPrimaryHit(uint32_t pixel);
+	void StorePrimarySurface(uint32_t pixel, const HitMessage& hitMessage);
+	void StoreAOVs(uint32_t pixel, const HitMessage& hitMessage);
+	void StorePrimaryHit(uint32_t pixel, const HitMessage& hitMessage);
+	// primaryHit 不为空时跳过第一次求交，直接使用光线组追踪的结果
+	glm::vec4 PerPixel(int x, int y, const HitMessage* primaryHit = nullptr);
+	glm::vec3 SampleDirectLight(const HitMessage& hitMessage, const glm::vec3& albedo, uint32_t& seed, bool misWeight);
+	// SampleDirectLight 的前半部分：采样光源并生成指向 lightIndex 的阴影光线（只在 distance 之前找遮挡），contribution 为未被遮挡时的结果
+	bool GenerateShadowRay(const HitMessage& hitMessage, const glm::vec3& albedo, uint32_t& seed, bool misWeight, Ray& shadowRay, float& distance, int& lightIndex, glm::vec3& contribution);
+	bool IsShadowRayUnoccluded(const Ray& shadowRay, float distance, int lightIndex);
+	float EmissionWeight(const glm::vec3& origin, const glm::vec3& normal, float bsdfPdf, int objectIndex) const;
+
+	// ReSTIR：生成候选并做时域复用、空间复用，之后由 PerPixel 按结果着色
+	void ResampleDirectLight();
+	// 把画面按 tile 分给线程，每个 tile 执行一次 kernel，传入像素范围 [minX, maxX) x [minY, maxY)
+	void ForEachTile(const std::function<void(uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY)>& kernel);
+	void GenerateReservoir(uint32_t x, uint32_t y);
+	void SpatialReuse(uint32_t x, uint32_t y);
+	// 合并 count 个蓄水池（至多 MaxCombinedReservoirs 个），第 0 个属于本像素，hits 为各自所属像素的首次命中
+	Reservoir CombineReservoirs(const HitMessage* const* hits, const Reservoir* const* reservoirs, uint32_t count, uint32_t& seed) const;
+	// 光源 objectIndex 上方向为 lightNormal 的点对 hitMessage 处未遮挡的直接光照，shadowRay 与 distance 为指向该点的阴影光线
+	glm::vec3 EvaluateLightPoint(const HitMessage& hitMessage, const glm::vec3& albedo, int objectIndex, const glm::vec3& lightNormal, Ray& shadowRay, float& distance) const;
+	float EvaluateTargetPdf(const HitMessage& hitMessage, const glm::vec3& albedo, const Reservoir& reservoir) const;
+	bool IsLightVisible(const Ray& shadowRay, float distance, int objectIndex);
+	glm::vec3 ShadeReservoir(uint32_t pixel, const HitMessage& hitMessage, const glm::vec3& albedo);
+	void RenderTiles();
+	void UpdateTraversalOrder(uint32_t tileSize);
+	void RenderTile(uint32_t tileIndex, uint32_t tileSize, uint32_t sampleCount);
+	float EstimateTileError(uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY, uint32_t& minSamples) const;
+	void ResolveImage();
+	// (packetX, packetY) 为 4x2 像素块左上角的像素坐标
+	void RenderPacket(uint32_t tileIndex, uint32_t packetX, uint32_t packetY);
+	void AccumulatePixel(uint32_t x, uint32_t y, const glm::vec4& color);
+	void ResolvePixel(uint32_t pixel);
+
+	void RenderWavefront();
+	// 把 count 项按 WavefrontChunkSize 分块并行执行 kernel(first, last, chunkIndex)；ForEachPathChunk 覆盖 m_PathQueue
+	void ForEachChunk(uint32_t count, const std::function<void(uint32_t first, uint32_t last, uint32_t chunkIndex)>& kernel);
+	void ForEachPathChunk(const std::function<void(uint32_t first, uint32_t last, uint32_t chunkIndex)>& kernel) { ForEachChunk(m_PathQueue.Count, kernel); }
+	void GeneratePaths(uint32_t firstPixel, uint32_t pathCount);
+	void SortPaths();
+	void ExtendPaths(uint32_t bounce);
+	// 着色并把光源采样的阴影光线写入 m_ShadowQueue，之后依次压缩、追踪阴影光线并累加未被遮挡的贡献
+	void ShadePaths(uint32_t bounce);
+	void CompactShadowRays();
+	void TraceShadowRays();
+	void AccumulateShadowRays();
+	void CompactPaths();
 	HitMessage ClosestHit(const Ray& ray, float hitDistance, int objectIndex);
 	HitMessage MissHit(const Ray& ray);
 	
 private:
+#ifndef RT_HEADLESS
 	std::shared_ptr<Walnut::Image> m_FinalImage;
+#endif
+	uint32_t m_ViewportWidth = 0, m_ViewportHeight = 0;
 	uint32_t* m_ImageData = nullptr;
 	glm::vec4* m_AccumulationData = nullptr;
+	// 每个像素已累积的采样数与亮度平方和，用于估计方差
+	std::vector<uint32_t> m_SampleCounts;
+	std::vector<float> m_LuminanceSquared;
+	// 每个像素主光线首次命中的距离、物体与法线，未命中时为 FLT_MAX、-1 与零向量
+	std::vector<float> m_PrimaryDepth;
+	std::vector<int> m_PrimaryObjectIndex;
+	std::vector<glm::vec3> m_PrimaryNormal;
+	// 输出的 AOV，只在对应项开启时分配和写入
+	std::vector<float> m_DepthAOV;
+	std::vector<glm::vec3> m_NormalAOV;
+	std::vector<glm::vec3> m_AlbedoAOV;
+	std::vector<int> m_ObjectIDAOV;
+	// 本帧是否写入首次命中的表面信息与 AOV，本帧写入的 AOV，以及上一帧完整写入的 AOV
+	bool m_StorePrimarySurface = false, m_StoreAOVs = false;
+	Settings::AOVSettings m_StoredAOVs;
+	Settings::AOVSettings m_WrittenAOVs;
+	uint32_t m_CheckerboardPhase = 0;
+	// 首次命中缓存已写入的棋盘格（第 0、1 位），两种都写入后缓存才完整
+	uint32_t m_CachedCheckerboardPhases = 0;
 	const Scene* m_ActiveScene = nullptr;
 	const Camera* m_ActiveCamera = nullptr;
 	Settings m_Settings;
+
+	// 本帧的渲染分辨率与对应的主光线，m_ImageData 等逐像素缓冲区按该分辨率排列
+	uint32_t m_Width = 0, m_Height = 0;
+	PrimaryRayGenerator m_PrimaryRays;
+	std::vector<uint32_t> m_UpscaledImageData;
+	// 动态分辨率：上一帧的相机、是否在移动、整帧耗时（毫秒），以及移动时使用的缩放比例
+	glm::mat4 m_LastViewProjection{ 0.0f };
+	bool m_CameraMoving = false;
+	float m_LastFrameTime = 0.0f;
+	float m_ResolutionScale = 1.0f;
+
+	// 时域重投影：上一帧的累积结果、首次命中距离与相机
+	struct
+	{
+		std::vector<glm::vec4> Color;
+		std::vector<uint32_t> SampleCounts;
+		std::vector<float> LuminanceSquared, Depth;
+		glm::mat4 ViewProjection{ 1.0f };
+		glm::vec3 Origin{ 0.0f };
+		uint32_t Width = 0, Height = 0;
+	} m_History;
+	std::vector<glm::vec4> m_ReprojectedColor;
+	std::vector<float> m_ReprojectedLuminanceSquared;
+	bool m_ReprojectHistory = false;
+
+	BVH m_BVH;
+	WideBVH m_WideBVH;
+	Grid m_Grid;
+	SphereArray m_SphereArray;
+	bool m_SceneDirty = true;
+	bool m_GeometryDirty = false;
+	// 光源需要重新收集（场景或材质已改变）
+	bool m_LightsDirty = true;
+
+	TileCuller m_TileCuller;
+	VisibilityBuffer m_VisibilityBuffer;
+	PrimaryHitCache m_PrimaryHitCache;
+	// 上次生成主光线相关缓存时的相机与画面，任一变化或场景变化（m_PrimaryDirty）时全部失效
+	struct
+	{
+		glm::mat4 ViewProjection{ 0.0f };
+		uint32_t Width = 0, Height = 0;
+	} m_PrimaryViewKey;
+	bool m_PrimaryDirty = true;
 	
 	uint32_t m_FrameIndex = 1;
-	std::vector<uint32_t> m_ImageVerticalIterator, m_ImageHorizontalIterator;
+
+	ThreadPool m_ThreadPool;
+	uint32_t m_TileCountX = 0, m_TileCountY = 0;
+	std::vector<float> m_TileTimes;
+
+	// 自适应采样：每个 tile 是否已收敛，本帧需要渲染的 tile
+	std::vector<uint8_t> m_TileConverged;
+	std::vector<uint32_t> m_ActiveTiles;
+	uint32_t m_ConvergedTileCount = 0, m_AdaptiveSampleCount = 1;
+	bool m_ShowingSampleCount = false;
+
+	Denoiser m_Denoiser;
+	bool m_Denoised = false;
+
+	LightSampler m_LightSampler;
+
+	// ReSTIR：每个像素的首次命中与蓄水池。m_TemporalReservoirs 为时域复用的结果，留到下一帧（m_PreviousReservoirs）作为历史；
+	// m_Reservoirs 为空间复用的结果，只用于本帧着色，不作为历史，避免邻域样本逐帧扩散、相关性越来越强。场景拓扑改变或关闭 ReSTIR 时清空
+	std::vector<HitMessage> m_ReservoirHits, m_PreviousReservoirHits;
+	std::vector<Reservoir> m_Reservoirs, m_TemporalReservoirs, m_PreviousReservoirs;
+	struct
+	{
+		glm::mat4 ViewProjection{ 1.0f };
+		uint32_t Width = 0, Height = 0;
+	} m_ReservoirView; // m_TemporalReservoirs 对应的相机与分辨率
+	uint32_t m_ReservoirFrame = 0;
+
+	// 按曲线顺序排列的 tile 索引，以及 tile 内像素（开启光线组时为像素块）的坐标
+	std::vector<uint32_t> m_TileOrder;
+	std::vector<glm::uvec2> m_TilePixelOrder;
+	struct
+	{
+		uint32_t TileSize = 0, TileCountX = 0, TileCountY = 0;
+		SpaceFillingCurve::Type TileOrder, PixelOrder;
+		uint32_t PacketSpanX; // 不使用光线组时为 0
+	} m_TraversalOrderKey;
+
+	// 波前模式：当前路径队列、压缩的目标队列、阴影光线队列，以及每个像素累计的光照
+	PathQueue m_PathQueue, m_CompactedPathQueue;
+	ShadowQueue m_ShadowQueue, m_CompactedShadowQueue;
+	std::vector<glm::vec3> m_PathRadiance;
+	std::vector<uint32_t> m_ChunkOffsets;
+	std::vector<AABB> m_ChunkBounds;
+	std::vector<uint32_t> m_SortKeys, m_SortIndices, m_SortTempKeys, m_SortTempIndices;
+	std::vector<WavefrontBounceStats> m_WavefrontStats;
 };
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// 加权蓄水池抽样（weighted reservoir sampling）：流式地从一串候选中按权重选出一个，只保存选中的样本与权重和。
+// ReSTIR 中样本是光源球面上的一点；多个蓄水池可以按多重重要性采样权重合并，即时域与空间复用
+struct Reservoir
+{
+	int ObjectIndex = -1;          // 选中光源的球体索引，空蓄水池为 -1
+	glm::vec3 LightNormal{ 0.0f }; // 选中的点相对球心的方向，球体移动后仍落在球面上
+	float TargetPdf = 0.0f;        // 选中样本在所属像素处的目标函数值（未遮挡时直接光照的亮度）
+	float WeightSum = 0.0f;
+	float M = 0.0f;                // 代表的候选数，用于合并时的多重重要性采样权重与限制历史长度
+	float W = 0.0f;                // 选中样本的贡献权重 WeightSum / TargetPdf，着色时乘在被积函数上
+
+	// weight 为 目标函数 / 概率密度 × 多重重要性采样权重，random 为 [0, 1) 的随机数；返回是否选中该候选
+	bool Update(int objectIndex, const glm::vec3& lightNormal, float targetPdf, float weight, float random)
+	{
+		WeightSum += weight;
+		if (weight <= 0.0f || random * WeightSum >= weight)
+			return false;
+
+		ObjectIndex = objectIndex;
+		LightNormal = lightNormal;
+		TargetPdf = targetPdf;
+		return true;
+	}
+
+	// 并入另一个蓄水池：targetPdf 为它选中的样本在本像素处的目标函数值，misWeight 为该样本的多重重要性采样权重
+	bool Merge(const Reservoir& other, float targetPdf, float misWeight, float random)
+	{
+		M += other.M;
+		return Update(other.ObjectIndex, other.LightNormal, targetPdf, targetPdf * other.W * misWeight, random);
+	}
+
+	void FinalizeWeight() { W = TargetPdf > 0.0f ? WeightSum / TargetPdf : 0.0f; }
+};
@@ -25,6 +25,6 @@ struct Sphere
 
 struct Scene
 {
-	std::vector<Sphere> Sphere;
+	std::vector<::Sphere> Sphere;
 	std::vector<Material> Materials;
 };
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include "SpaceFillingCurve.h"
+
+#include <algorithm>
+
+std::vector<glm::uvec2> SpaceFillingCurve::GenerateOrder(uint32_t width, uint32_t height, Type type)
+{
+	std::vector<glm::uvec2> order;
+	order.reserve(width * height);
+	for (uint32_t y = 0; y < height; y++)
+		for (uint32_t x = 0; x < width; x++)
+			order.emplace_back(x, y);
+
+	if (type == Type::RowMajor)
+		return order;
+
+	uint32_t size = 1;
+	while (size < width || size < height)
+		size *= 2;
+
+	auto key = [type, size](const glm::uvec2& coord)
+	{
+		return type == Type::Morton ? MortonEncode(coord.x, coord.y) : HilbertEncode(coord.x, coord.y, size);
+	};
+	std::sort(order.begin(), order.end(), [&key](const glm::uvec2& a, const glm::uvec2& b) { return key(a) < key(b); });
+
+	return order;
+}
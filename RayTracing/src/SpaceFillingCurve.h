@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <utility>
+#include <vector>
+
+// 二维空间填充曲线：相邻的序号对应相邻的像素（或 tile），依次处理时访问的场景区域相近
+namespace SpaceFillingCurve
+{
+	enum class Type
+	{
+		RowMajor = 0,
+		Morton,  // Z 序，位交错即可得到，块内局部性好但块间有跳跃
+		Hilbert  // 相邻序号总是相邻格子，局部性最好
+	};
+
+	// x、y 各取低 16 位交错
+	inline uint32_t MortonEncode(uint32_t x, uint32_t y)
+	{
+		auto part = [](uint32_t v)
+		{
+			v &= 0x0000ffff;
+			v = (v | (v << 8)) & 0x00ff00ff;
+			v = (v | (v << 4)) & 0x0f0f0f0f;
+			v = (v | (v << 2)) & 0x33333333;
+			v = (v | (v << 1)) & 0x55555555;
+			return v;
+		};
+		return part(x) | (part(y) << 1);
+	}
+
+	// x、y、z 各取低 10 位交错
+	inline uint32_t MortonEncode3D(uint32_t x, uint32_t y, uint32_t z)
+	{
+		auto part = [](uint32_t v)
+		{
+			v &= 0x000003ff;
+			v = (v | (v << 16)) & 0x030000ff;
+			v = (v | (v << 8)) & 0x0300f00f;
+			v = (v | (v << 4)) & 0x030c30c3;
+			v = (v | (v << 2)) & 0x09249249;
+			return v;
+		};
+		return part(x) | (part(y) << 1) | (part(z) << 2);
+	}
+
+	// size 为 2 的幂且不小于 x、y
+	inline uint32_t HilbertEncode(uint32_t x, uint32_t y, uint32_t size)
+	{
+		uint32_t d = 0;
+		for (uint32_t s = size / 2; s > 0; s /= 2)
+		{
+			uint32_t rx = (x & s) > 0;
+			uint32_t ry = (y & s) > 0;
+			d += s * s * ((3 * rx) ^ ry);
+
+			// 旋转象限
+			if (ry == 0)
+			{
+				if (rx == 1)
+				{
+					x = s - 1 - x;
+					y = s - 1 - y;
+				}
+				std::swap(x, y);
+			}
+		}
+		return d;
+	}
+
+	// 按曲线顺序列出 width x height 网格的所有坐标，非 2 的幂的网格按外接的 2 的幂网格排序后跳过越界格子
+	std::vector<glm::uvec2> GenerateOrder(uint32_t width, uint32_t height, Type type);
+}
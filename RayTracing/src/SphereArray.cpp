@@ -0,0 +1,262 @@
+#include "SphereArray.h"
+
+#include <cfloat>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+void SphereArray::Update(const std::vector<Sphere>& spheres)
+{
+	m_Count = (uint32_t)spheres.size();
+
+	uint32_t blockCount = (m_Count + Width - 1) / Width;
+	m_CenterX.resize(blockCount);
+	m_CenterY.resize(blockCount);
+	m_CenterZ.resize(blockCount);
+	m_RadiusSquared.resize(blockCount);
+
+	for (uint32_t i = 0; i < blockCount * Width; i++)
+	{
+		uint32_t block = i / Width, lane = i % Width;
+		if (i < m_Count)
+		{
+			const Sphere& sphere = spheres[i];
+			m_CenterX[block].Value[lane] = sphere.Position.x;
+			m_CenterY[block].Value[lane] = sphere.Position.y;
+			m_CenterZ[block].Value[lane] = sphere.Position.z;
+			m_RadiusSquared[block].Value[lane] = sphere.Radius * sphere.Radius;
+		}
+		else
+		{
+			m_CenterX[block].Value[lane] = 0.0f;
+			m_CenterY[block].Value[lane] = 0.0f;
+			m_CenterZ[block].Value[lane] = 0.0f;
+			m_RadiusSquared[block].Value[lane] = -FLT_MAX;
+		}
+	}
+}
+
+void SphereArray::Clear()
+{
+	m_Count = 0;
+	m_CenterX.clear();
+	m_CenterY.clear();
+	m_CenterZ.clear();
+	m_RadiusSquared.clear();
+}
+
+bool SphereArray::Intersect(const Ray& ray, float& hitDistance, int& objectIndex) const
+{
+	// (bx^2 + by^2)t^2 + (2(axbx + ayby))t + (ax^2 + ay^2 - r^2) = 0
+	// a = 光线的起点
+	// b = 光线的方向
+	// r = 圆的半径
+	// t = 交点距离
+	float a = glm::dot(ray.Direction, ray.Direction);
+	uint32_t blockCount = (uint32_t)m_CenterX.size();
+
+#if defined(__AVX2__)
+	// 与标量公式保持相同的运算顺序，不使用 FMA
+	__m256 originX = _mm256_set1_ps(ray.Origin.x);
+	__m256 originY = _mm256_set1_ps(ray.Origin.y);
+	__m256 originZ = _mm256_set1_ps(ray.Origin.z);
+	__m256 directionX = _mm256_set1_ps(ray.Direction.x);
+	__m256 directionY = _mm256_set1_ps(ray.Direction.y);
+	__m256 directionZ = _mm256_set1_ps(ray.Direction.z);
+	__m256 fourA = _mm256_set1_ps(4.0f * a);
+	__m256 twoA = _mm256_set1_ps(2.0f * a);
+	__m256 two = _mm256_set1_ps(2.0f);
+	__m256 zero = _mm256_setzero_ps();
+
+	// 每个通道各自保留最近交点，最后再横向归约
+	__m256 closest = _mm256_set1_ps(hitDistance);
+	__m256i closestIndex = _mm256_set1_epi32(-1);
+	__m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i indexStep = _mm256_set1_epi32(Width);
+
+	for (uint32_t block = 0; block < blockCount; block++)
+	{
+		__m256 ox = _mm256_sub_ps(originX, _mm256_load_ps(m_CenterX[block].Value));
+		__m256 oy = _mm256_sub_ps(originY, _mm256_load_ps(m_CenterY[block].Value));
+		__m256 oz = _mm256_sub_ps(originZ, _mm256_load_ps(m_CenterZ[block].Value));
+
+		__m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ox, directionX), _mm256_mul_ps(oy, directionY)), _mm256_mul_ps(oz, directionZ));
+		b = _mm256_mul_ps(two, b);
+		__m256 c = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ox, ox), _mm256_mul_ps(oy, oy)), _mm256_mul_ps(oz, oz));
+		c = _mm256_sub_ps(c, _mm256_load_ps(m_RadiusSquared[block].Value));
+
+		__m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(fourA, c));
+		__m256 valid = _mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ);
+		if (_mm256_movemask_ps(valid) != 0)
+		{
+			// 无效通道的 sqrt 结果为 NaN，比较时自然被排除
+			__m256 t = _mm256_div_ps(_mm256_sub_ps(_mm256_sub_ps(zero, b), _mm256_sqrt_ps(discriminant)), twoA);
+			__m256 closer = _mm256_and_ps(_mm256_cmp_ps(t, closest, _CMP_LT_OQ), _mm256_cmp_ps(t, zero, _CMP_GT_OQ));
+
+			closest = _mm256_blendv_ps(closest, t, closer);
+			closestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(closestIndex), _mm256_castsi256_ps(index), closer));
+		}
+
+		index = _mm256_add_epi32(index, indexStep);
+	}
+
+	alignas(32) float distances[Width];
+	alignas(32) int indices[Width];
+	_mm256_store_ps(distances, closest);
+	_mm256_store_si256((__m256i*)indices, closestIndex);
+
+	bool hit = false;
+	for (uint32_t lane = 0; lane < Width; lane++)
+	{
+		if (indices[lane] < 0)
+			continue;
+
+		if (distances[lane] < hitDistance || (distances[lane] == hitDistance && hit && indices[lane] < objectIndex))
+		{
+			hitDistance = distances[lane];
+			objectIndex = indices[lane];
+			hit = true;
+		}
+	}
+	return hit;
+#else
+	bool hit = false;
+	for (uint32_t block = 0; block < blockCount; block++)
+	{
+		for (uint32_t lane = 0; lane < Width; lane++)
+		{
+			glm::vec3 origin = ray.Origin - glm::vec3(m_CenterX[block].Value[lane], m_CenterY[block].Value[lane], m_CenterZ[block].Value[lane]);
+			float b = 2.0f * glm::dot(origin, ray.Direction);
+			float c = glm::dot(origin, origin) - m_RadiusSquared[block].Value[lane];
+
+			float discriminant = b * b - 4.0f * a * c;
+			if (discriminant < 0.0f)
+				continue;
+
+			float tclose = (-b - glm::sqrt(discriminant)) / (2.0f * a);
+			if (tclose < hitDistance && tclose > 0.0f)
+			{
+				hitDistance = tclose;
+				objectIndex = (int)(block * Width + lane);
+				hit = true;
+			}
+		}
+	}
+	return hit;
+#endif
+}
+
+void SphereArray::IntersectPacket(const RayPacket& packet, RayPacketHit& hit) const
+{
+#if defined(__AVX2__)
+	__m256 directionX = _mm256_load_ps(packet.DirectionX);
+	__m256 directionY = _mm256_load_ps(packet.DirectionY);
+	__m256 directionZ = _mm256_load_ps(packet.DirectionZ);
+	__m256 zero = _mm256_setzero_ps();
+
+	__m256 a = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(directionX, directionX), _mm256_mul_ps(directionY, directionY)), _mm256_mul_ps(directionZ, directionZ));
+	__m256 fourA = _mm256_mul_ps(_mm256_set1_ps(4.0f), a);
+	__m256 twoA = _mm256_mul_ps(_mm256_set1_ps(2.0f), a);
+
+	__m256 closest = _mm256_load_ps(hit.HitDistance);
+	__m256i closestIndex = _mm256_load_si256((const __m256i*)hit.ObjectIndex);
+
+	__m256 packetOriginX = _mm256_set1_ps(packet.Origin.x);
+	__m256 packetOriginY = _mm256_set1_ps(packet.Origin.y);
+	__m256 packetOriginZ = _mm256_set1_ps(packet.Origin.z);
+
+	uint32_t blockCount = (uint32_t)m_CenterX.size();
+	for (uint32_t block = 0; block < blockCount; block++)
+	{
+		// 起点相同，先对 8 个球体一起算出 origin 与 c，再逐个球体对 8 条光线求交
+		alignas(32) float originX[Width], originY[Width], originZ[Width], cValues[Width];
+		__m256 ox = _mm256_sub_ps(packetOriginX, _mm256_load_ps(m_CenterX[block].Value));
+		__m256 oy = _mm256_sub_ps(packetOriginY, _mm256_load_ps(m_CenterY[block].Value));
+		__m256 oz = _mm256_sub_ps(packetOriginZ, _mm256_load_ps(m_CenterZ[block].Value));
+		__m256 c = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ox, ox), _mm256_mul_ps(oy, oy)), _mm256_mul_ps(oz, oz));
+		_mm256_store_ps(originX, ox);
+		_mm256_store_ps(originY, oy);
+		_mm256_store_ps(originZ, oz);
+		_mm256_store_ps(cValues, _mm256_sub_ps(c, _mm256_load_ps(m_RadiusSquared[block].Value)));
+
+		uint32_t laneCount = glm::min(Width, m_Count - block * Width);
+		for (uint32_t lane = 0; lane < laneCount; lane++)
+		{
+			__m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(originX[lane]), directionX), _mm256_mul_ps(_mm256_set1_ps(originY[lane]), directionY)),
+				_mm256_mul_ps(_mm256_set1_ps(originZ[lane]), directionZ));
+			b = _mm256_add_ps(b, b);
+
+			__m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(fourA, _mm256_set1_ps(cValues[lane])));
+			if (_mm256_movemask_ps(_mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ)) == 0)
+				continue;
+
+			__m256 t = _mm256_div_ps(_mm256_sub_ps(_mm256_sub_ps(zero, b), _mm256_sqrt_ps(discriminant)), twoA);
+			__m256 closer = _mm256_and_ps(_mm256_cmp_ps(t, closest, _CMP_LT_OQ), _mm256_cmp_ps(t, zero, _CMP_GT_OQ));
+
+			closest = _mm256_blendv_ps(closest, t, closer);
+			closestIndex = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(closestIndex), _mm256_castsi256_ps(_mm256_set1_epi32((int)(block * Width + lane))), closer));
+		}
+	}
+
+	_mm256_store_ps(hit.HitDistance, closest);
+	_mm256_store_si256((__m256i*)hit.ObjectIndex, closestIndex);
+#else
+	for (uint32_t i = 0; i < m_Count; i++)
+	{
+		glm::vec4 sphere{ m_CenterX[i / Width].Value[i % Width], m_CenterY[i / Width].Value[i % Width], m_CenterZ[i / Width].Value[i % Width], m_RadiusSquared[i / Width].Value[i % Width] };
+		IntersectPacket(packet, sphere, (int)i, hit);
+	}
+#endif
+}
+
+void SphereArray::IntersectPacket(const RayPacket& packet, const glm::vec4& sphere, int objectIndex, RayPacketHit& hit)
+{
+	// 起点相同，origin 与 c 对整组光线都一样
+	glm::vec3 origin = packet.Origin - glm::vec3(sphere);
+	float c = glm::dot(origin, origin) - sphere.w;
+
+#if defined(__AVX2__)
+	__m256 directionX = _mm256_load_ps(packet.DirectionX);
+	__m256 directionY = _mm256_load_ps(packet.DirectionY);
+	__m256 directionZ = _mm256_load_ps(packet.DirectionZ);
+	__m256 zero = _mm256_setzero_ps();
+
+	__m256 a = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(directionX, directionX), _mm256_mul_ps(directionY, directionY)), _mm256_mul_ps(directionZ, directionZ));
+	__m256 b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(origin.x), directionX), _mm256_mul_ps(_mm256_set1_ps(origin.y), directionY)),
+		_mm256_mul_ps(_mm256_set1_ps(origin.z), directionZ));
+	b = _mm256_mul_ps(_mm256_set1_ps(2.0f), b);
+
+	__m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(4.0f), a), _mm256_set1_ps(c)));
+	if (_mm256_movemask_ps(_mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ)) == 0)
+		return;
+
+	__m256 t = _mm256_div_ps(_mm256_sub_ps(_mm256_sub_ps(zero, b), _mm256_sqrt_ps(discriminant)), _mm256_mul_ps(_mm256_set1_ps(2.0f), a));
+	__m256 closest = _mm256_load_ps(hit.HitDistance);
+	__m256 closer = _mm256_and_ps(_mm256_cmp_ps(t, closest, _CMP_LT_OQ), _mm256_cmp_ps(t, zero, _CMP_GT_OQ));
+
+	_mm256_store_ps(hit.HitDistance, _mm256_blendv_ps(closest, t, closer));
+	__m256i index = _mm256_load_si256((const __m256i*)hit.ObjectIndex);
+	index = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(index), _mm256_castsi256_ps(_mm256_set1_epi32(objectIndex)), closer));
+	_mm256_store_si256((__m256i*)hit.ObjectIndex, index);
+#else
+	for (uint32_t lane = 0; lane < RayPacket::Width; lane++)
+	{
+		glm::vec3 direction{ packet.DirectionX[lane], packet.DirectionY[lane], packet.DirectionZ[lane] };
+
+		float a = glm::dot(direction, direction);
+		float b = 2.0f * glm::dot(origin, direction);
+
+		float discriminant = b * b - 4.0f * a * c;
+		if (discriminant < 0.0f)
+			continue;
+
+		float tclose = (-b - glm::sqrt(discriminant)) / (2.0f * a);
+		if (tclose < hit.HitDistance[lane] && tclose > 0.0f)
+		{
+			hit.HitDistance[lane] = tclose;
+			hit.ObjectIndex[lane] = objectIndex;
+		}
+	}
+#endif
+}
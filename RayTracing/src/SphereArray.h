@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Ray.h"
+#include "Scene.h"
+
+// 渲染时使用的球体 SoA 副本：球心 x / y / z 与半径平方分别连续存放，按 8 个一组对齐并补齐，供 8 路 SIMD 批量求交
+class SphereArray
+{
+public:
+	static constexpr uint32_t Width = 8;
+
+	struct alignas(32) Lanes
+	{
+		float Value[Width];
+	};
+
+	SphereArray() = default;
+
+	void Update(const std::vector<Sphere>& spheres);
+	void Clear();
+
+	// 与 Renderer::TraceRay 的逐个求交结果一致：返回最近的 t > 0 交点，距离相同时取索引较小者
+	bool Intersect(const Ray& ray, float& hitDistance, int& objectIndex) const;
+	// 逐个球体与整组光线 SIMD 求交
+	void IntersectPacket(const RayPacket& packet, RayPacketHit& hit) const;
+	// 单个球体（xyz = 球心，w = 半径平方）与整组光线求交，更新更近的交点；加速结构的叶节点共用
+	static void IntersectPacket(const RayPacket& packet, const glm::vec4& sphere, int objectIndex, RayPacketHit& hit);
+	// 单个球体与单条光线求交，a 为方向的模长平方；交点比 hitDistance 更近时更新并返回 true。网格、tile 剔除与可见性缓冲区共用，保证首次命中一致
+	static bool IntersectSphere(const Ray& ray, float a, const glm::vec4& sphere, float& hitDistance)
+	{
+		glm::vec3 origin = ray.Origin - glm::vec3(sphere);
+		float b = 2.0f * glm::dot(origin, ray.Direction);
+		float c = glm::dot(origin, origin) - sphere.w;
+
+		float discriminant = b * b - 4.0f * a * c;
+		if (discriminant < 0.0f)
+			return false;
+
+		float tclose = (-b - glm::sqrt(discriminant)) / (2.0f * a);
+		if (tclose < hitDistance && tclose > 0.0f)
+		{
+			hitDistance = tclose;
+			return true;
+		}
+		return false;
+	}
+
+	uint32_t GetCount() const { return m_Count; }
+	size_t GetMemory() const { return m_CenterX.size() * sizeof(Lanes) * 4; }
+private:
+	uint32_t m_Count = 0;
+
+	// 补齐的空位半径平方为 -FLT_MAX，判别式恒为负
+	std::vector<Lanes> m_CenterX, m_CenterY, m_CenterZ, m_RadiusSquared;
+};
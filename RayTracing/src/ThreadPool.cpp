@@ -0,0 +1,173 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+	Start(threadCount);
+}
+
+ThreadPool::~ThreadPool()
+{
+	Stop();
+}
+
+void ThreadPool::Resize(uint32_t threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+	if (threadCount == GetThreadCount())
+		return;
+
+	Stop();
+	Start(threadCount);
+}
+
+void ThreadPool::Start(uint32_t threadCount)
+{
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+
+	m_Stopping = false;
+
+	m_Queues.resize(threadCount);
+	for (auto& queue : m_Queues)
+		queue = std::make_unique<WorkQueue>();
+
+	// 0 号队列属于调用线程
+	for (uint32_t i = 1; i < threadCount; i++)
+		m_Threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+void ThreadPool::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+	m_WorkAvailable.notify_all();
+
+	for (std::thread& thread : m_Threads)
+		thread.join();
+
+	m_Threads.clear();
+	m_Queues.clear();
+}
+
+void ThreadPool::ParallelFor(uint32_t taskCount, const Task& task)
+{
+	if (taskCount == 0)
+		return;
+
+	uint32_t threadCount = GetThreadCount();
+	if (threadCount == 1)
+	{
+		for (uint32_t i = 0; i < taskCount; i++)
+			task(i, 0);
+		return;
+	}
+
+	m_StealCount = 0;
+	m_RemainingTasks = taskCount;
+
+	// 连续的任务（相邻的 tile）分给同一个线程
+	for (uint32_t thread = 0; thread < threadCount; thread++)
+	{
+		uint32_t first = (uint32_t)((uint64_t)taskCount * thread / threadCount);
+		uint32_t last = (uint32_t)((uint64_t)taskCount * (thread + 1) / threadCount);
+
+		WorkQueue& queue = *m_Queues[thread];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		for (uint32_t i = first; i < last; i++)
+			queue.Tasks.push_back(i);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Task = &task;
+		m_Generation++;
+	}
+	m_WorkAvailable.notify_all();
+
+	RunTasks(0, task);
+
+	// 等待所有任务完成，并且没有工作线程仍持有 task 的引用
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_WorkDone.wait(lock, [this]() { return m_RemainingTasks == 0 && m_ActiveWorkers == 0; });
+	m_Task = nullptr;
+}
+
+void ThreadPool::WorkerLoop(uint32_t threadIndex)
+{
+	uint64_t generation = 0;
+	while (true)
+	{
+		const Task* task;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkAvailable.wait(lock, [&]() { return m_Stopping || (m_Task && m_Generation != generation); });
+			if (m_Stopping)
+				return;
+
+			generation = m_Generation;
+			task = m_Task;
+			m_ActiveWorkers++;
+		}
+
+		RunTasks(threadIndex, *task);
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_ActiveWorkers--;
+		}
+		m_WorkDone.notify_all();
+	}
+}
+
+void ThreadPool::RunTasks(uint32_t threadIndex, const Task& task)
+{
+	uint32_t taskIndex;
+	while (PopTask(threadIndex, taskIndex) || StealTask(threadIndex, taskIndex))
+	{
+		task(taskIndex, threadIndex);
+
+		if (--m_RemainingTasks == 0)
+		{
+			// 加锁后再通知，避免等待方错过唤醒
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_WorkDone.notify_all();
+		}
+	}
+}
+
+bool ThreadPool::PopTask(uint32_t threadIndex, uint32_t& taskIndex)
+{
+	WorkQueue& queue = *m_Queues[threadIndex];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	if (queue.Tasks.empty())
+		return false;
+
+	taskIndex = queue.Tasks.front();
+	queue.Tasks.pop_front();
+	return true;
+}
+
+bool ThreadPool::StealTask(uint32_t threadIndex, uint32_t& taskIndex)
+{
+	uint32_t threadCount = GetThreadCount();
+	for (uint32_t offset = 1; offset < threadCount; offset++)
+	{
+		WorkQueue& queue = *m_Queues[(threadIndex + offset) % threadCount];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (queue.Tasks.empty())
+			continue;
+
+		// 从尾部窃取，离所有者正在处理的区域最远
+		taskIndex = queue.Tasks.back();
+		queue.Tasks.pop_back();
+		m_StealCount++;
+		return true;
+	}
+	return false;
+}
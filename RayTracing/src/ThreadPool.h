@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 工作窃取线程池：任务按连续区间分到各线程的双端队列，线程从自己队列的头部取任务，空闲时从其他线程队列的尾部窃取
+class ThreadPool
+{
+public:
+	using Task = std::function<void(uint32_t taskIndex, uint32_t threadIndex)>;
+
+	// threadCount 包含调用 ParallelFor 的线程，为 0 时使用全部硬件线程
+	explicit ThreadPool(uint32_t threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void Resize(uint32_t threadCount);
+	uint32_t GetThreadCount() const { return (uint32_t)m_Queues.size(); }
+
+	// 执行 task(0) ... task(taskCount - 1)，调用线程也参与执行，全部完成后返回
+	void ParallelFor(uint32_t taskCount, const Task& task);
+
+	// 上一次 ParallelFor 中被窃取的任务数
+	uint32_t GetStealCount() const { return m_StealCount.load(); }
+private:
+	struct WorkQueue
+	{
+		std::mutex Mutex;
+		std::deque<uint32_t> Tasks;
+	};
+
+	void Start(uint32_t threadCount);
+	void Stop();
+
+	void WorkerLoop(uint32_t threadIndex);
+	void RunTasks(uint32_t threadIndex, const Task& task);
+	bool PopTask(uint32_t threadIndex, uint32_t& taskIndex);
+	bool StealTask(uint32_t threadIndex, uint32_t& taskIndex);
+private:
+	std::vector<std::thread> m_Threads;
+	std::vector<std::unique_ptr<WorkQueue>> m_Queues;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkAvailable;
+	std::condition_variable m_WorkDone;
+
+	// 以下由 m_Mutex 保护
+	const Task* m_Task = nullptr;
+	uint64_t m_Generation = 0;
+	uint32_t m_ActiveWorkers = 0;
+	bool m_Stopping = false;
+
+	std::atomic<uint32_t> m_RemainingTasks{ 0 };
+	std::atomic<uint32_t> m_StealCount{ 0 };
+};
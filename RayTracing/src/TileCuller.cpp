@@ -0,0 +1,178 @@
+#include "TileCuller.h"
+
+#include "SphereArray.h"
+
+#include "Walnut/Timer.h"
+
+#include <algorithm>
+
+namespace Utils
+{
+	static constexpr uint32_t ChunkSize = 1024;
+
+	// 投影误差与像素中心位置的余量（像素）
+	static constexpr float PixelMargin = 1.0f;
+
+	// 球体包围盒在屏幕上覆盖的像素范围；整个位于相机背后时返回 false，跨过相机平面时保守地覆盖全屏
+	static bool ProjectSphere(const Sphere& sphere, const glm::mat4& viewProjection, uint32_t width, uint32_t height, glm::uvec4& pixels)
+	{
+		glm::vec3 radius{ glm::abs(sphere.Radius) };
+		glm::vec2 minNDC{ FLT_MAX }, maxNDC{ -FLT_MAX };
+		uint32_t behindCount = 0;
+		bool crossesCamera = false;
+
+		for (uint32_t corner = 0; corner < 8; corner++)
+		{
+			glm::vec3 sign{ corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, corner & 4 ? 1.0f : -1.0f };
+			glm::vec4 clip = viewProjection * glm::vec4(sphere.Position + sign * radius, 1.0f);
+
+			// 透视投影的 w 为到相机平面的距离
+			if (clip.w <= 1e-5f)
+			{
+				behindCount += clip.w <= 0.0f;
+				crossesCamera = true;
+				continue;
+			}
+
+			glm::vec2 ndc = glm::vec2(clip) / clip.w;
+			minNDC = glm::min(minNDC, ndc);
+			maxNDC = glm::max(maxNDC, ndc);
+		}
+
+		if (behindCount == 8)
+			return false;
+
+		if (crossesCamera)
+		{
+			pixels = { 0, 0, width - 1, height - 1 };
+			return true;
+		}
+
+		// 与 Camera 一致：像素 x 的主光线位于 NDC x / width * 2 - 1
+		glm::vec2 size{ (float)width, (float)height };
+		glm::vec2 minPixel = glm::floor((minNDC + 1.0f) * 0.5f * size) - PixelMargin;
+		glm::vec2 maxPixel = glm::ceil((maxNDC + 1.0f) * 0.5f * size) + PixelMargin;
+		if (maxPixel.x < 0.0f || maxPixel.y < 0.0f || minPixel.x >= size.x || minPixel.y >= size.y)
+			return false;
+
+		minPixel = glm::max(minPixel, glm::vec2(0.0f));
+		maxPixel = glm::min(maxPixel, size - 1.0f);
+		pixels = { (uint32_t)minPixel.x, (uint32_t)minPixel.y, (uint32_t)maxPixel.x, (uint32_t)maxPixel.y };
+		return true;
+	}
+}
+
+void TileCuller::Build(ThreadPool& pool, const std::vector<Sphere>& spheres, const glm::mat4& viewProjection, uint32_t width, uint32_t height, uint32_t tileSize)
+{
+	Walnut::Timer timer;
+
+	m_TileSize = tileSize;
+	m_TileCountX = (width + tileSize - 1) / tileSize;
+	m_TileCountY = (height + tileSize - 1) / tileSize;
+	uint32_t tileCount = m_TileCountX * m_TileCountY;
+
+	uint32_t sphereCount = (uint32_t)spheres.size();
+	m_SpherePixels.resize(sphereCount);
+
+	// 球体分成若干块，每块单独统计各 tile 的引用数：按 (tile, 块) 顺序求前缀和后，写入无需原子操作且 tile 内的顺序确定
+	uint32_t chunkCount = std::min((sphereCount + Utils::ChunkSize - 1) / Utils::ChunkSize, pool.GetThreadCount() * 4);
+	uint32_t chunkSize = chunkCount > 0 ? (sphereCount + chunkCount - 1) / chunkCount : 0;
+	m_ChunkCounts.assign((size_t)chunkCount * tileCount, 0);
+
+	pool.ParallelFor(chunkCount, [&](uint32_t chunk, uint32_t threadIndex)
+		{
+			uint32_t* counts = &m_ChunkCounts[(size_t)chunk * tileCount];
+			uint32_t last = std::min(chunk * chunkSize + chunkSize, sphereCount);
+			for (uint32_t i = chunk * chunkSize; i < last; i++)
+			{
+				glm::uvec4& pixels = m_SpherePixels[i];
+				if (!Utils::ProjectSphere(spheres[i], viewProjection, width, height, pixels))
+				{
+					pixels = { 1, 0, 0, 0 };
+					continue;
+				}
+
+				glm::uvec4 tiles = pixels / tileSize;
+				for (uint32_t y = tiles.y; y <= tiles.w; y++)
+					for (uint32_t x = tiles.x; x <= tiles.z; x++)
+						counts[x + y * m_TileCountX]++;
+			}
+		});
+
+	m_TileStart.resize(tileCount + 1);
+	uint32_t offset = 0;
+	for (uint32_t tile = 0; tile < tileCount; tile++)
+	{
+		m_TileStart[tile] = offset;
+		for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+		{
+			uint32_t& count = m_ChunkCounts[(size_t)chunk * tileCount + tile];
+			uint32_t chunkReferences = count;
+			count = offset;
+			offset += chunkReferences;
+		}
+	}
+	m_TileStart[tileCount] = offset;
+
+	m_ReferenceIndices.resize(offset);
+	m_ReferenceData.resize(offset);
+
+	pool.ParallelFor(chunkCount, [&](uint32_t chunk, uint32_t threadIndex)
+		{
+			uint32_t* offsets = &m_ChunkCounts[(size_t)chunk * tileCount];
+			uint32_t last = std::min(chunk * chunkSize + chunkSize, sphereCount);
+			for (uint32_t i = chunk * chunkSize; i < last; i++)
+			{
+				const glm::uvec4& pixels = m_SpherePixels[i];
+				if (pixels.x > pixels.z)
+					continue;
+
+				glm::uvec4 tiles = pixels / tileSize;
+				glm::vec4 data{ spheres[i].Position, spheres[i].Radius * spheres[i].Radius };
+				for (uint32_t y = tiles.y; y <= tiles.w; y++)
+				{
+					for (uint32_t x = tiles.x; x <= tiles.z; x++)
+					{
+						uint32_t index = offsets[x + y * m_TileCountX]++;
+						m_ReferenceIndices[index] = i;
+						m_ReferenceData[index] = data;
+					}
+				}
+			}
+		});
+
+	m_BuildTime = timer.ElapsedMillis();
+}
+
+void TileCuller::Clear()
+{
+	m_TileSize = 1;
+	m_TileCountX = m_TileCountY = 0;
+	m_SpherePixels.clear();
+	m_ChunkCounts.clear();
+	m_TileStart.clear();
+	m_ReferenceIndices.clear();
+	m_ReferenceData.clear();
+	m_BuildTime = 0.0f;
+}
+
+bool TileCuller::Intersect(uint32_t tileIndex, const Ray& ray, float& hitDistance, int& objectIndex) const
+{
+	float a = glm::dot(ray.Direction, ray.Direction);
+	bool hit = false;
+	for (uint32_t i = m_TileStart[tileIndex]; i < m_TileStart[tileIndex + 1]; i++)
+	{
+		if (SphereArray::IntersectSphere(ray, a, m_ReferenceData[i], hitDistance))
+		{
+			objectIndex = (int)m_ReferenceIndices[i];
+			hit = true;
+		}
+	}
+	return hit;
+}
+
+void TileCuller::IntersectPacket(uint32_t tileIndex, const RayPacket& packet, RayPacketHit& hit) const
+{
+	for (uint32_t i = m_TileStart[tileIndex]; i < m_TileStart[tileIndex + 1]; i++)
+		SphereArray::IntersectPacket(packet, m_ReferenceData[i], (int)m_ReferenceIndices[i], hit);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Ray.h"
+#include "Scene.h"
+#include "ThreadPool.h"
+
+// 主光线的逐 tile 视锥剔除：把每个球体的包围盒投影到屏幕，为每个 tile 列出可能被其主光线击中的球体
+class TileCuller
+{
+public:
+	TileCuller() = default;
+
+	// 相机或球体变化后重新构建；viewProjection 把世界坐标变换到裁剪空间，像素 x 的主光线位于 NDC x / width * 2 - 1
+	// tile 按行优先编号，与 Renderer 的 tile 划分一致
+	void Build(ThreadPool& pool, const std::vector<Sphere>& spheres, const glm::mat4& viewProjection, uint32_t width, uint32_t height, uint32_t tileSize);
+	void Clear();
+
+	// 只与 tile 的候选球体求交，结果与暴力求交一致：返回最近的 t > 0 交点，距离相同时取索引较小者
+	bool Intersect(uint32_t tileIndex, const Ray& ray, float& hitDistance, int& objectIndex) const;
+	void IntersectPacket(uint32_t tileIndex, const RayPacket& packet, RayPacketHit& hit) const;
+
+	uint32_t GetTileIndex(uint32_t x, uint32_t y) const { return x / m_TileSize + y / m_TileSize * m_TileCountX; }
+	uint32_t GetTileSize() const { return m_TileSize; }
+	uint32_t GetTileCountX() const { return m_TileCountX; }
+	uint32_t GetTileCount() const { return m_TileCountX * m_TileCountY; }
+
+	// 第 tileIndex 个 tile 的候选位于引用 [GetTileBegin, GetTileEnd)
+	uint32_t GetTileBegin(uint32_t tileIndex) const { return m_TileStart[tileIndex]; }
+	uint32_t GetTileEnd(uint32_t tileIndex) const { return m_TileStart[tileIndex + 1]; }
+	uint32_t GetReferenceIndex(uint32_t reference) const { return m_ReferenceIndices[reference]; }
+	const glm::vec4& GetReferenceData(uint32_t reference) const { return m_ReferenceData[reference]; }
+	// 球体覆盖的像素范围 (minX, minY, maxX, maxY)，不可见时 minX > maxX
+	const glm::uvec4& GetSpherePixels(uint32_t sphereIndex) const { return m_SpherePixels[sphereIndex]; }
+
+	uint32_t GetReferenceCount() const { return (uint32_t)m_ReferenceIndices.size(); }
+	float GetBuildTime() const { return m_BuildTime; }
+private:
+	uint32_t m_TileSize = 1;
+	uint32_t m_TileCountX = 0, m_TileCountY = 0;
+
+	std::vector<glm::uvec4> m_SpherePixels;
+	// 每块球体在每个 tile 中的引用数，前缀和后为写入位置
+	std::vector<uint32_t> m_ChunkCounts;
+
+	// 第 i 个 tile 的引用位于 [m_TileStart[i], m_TileStart[i + 1])，同一 tile 内按球体索引递增
+	std::vector<uint32_t> m_TileStart;
+	std::vector<uint32_t> m_ReferenceIndices;
+	std::vector<glm::vec4> m_ReferenceData;
+
+	float m_BuildTime = 0.0f;
+};
@@ -0,0 +1,65 @@
+#include "VisibilityBuffer.h"
+
+#include "SphereArray.h"
+
+#include "Walnut/Timer.h"
+
+#include <algorithm>
+
+void VisibilityBuffer::Build(ThreadPool& pool, const TileCuller& culler, const PrimaryRayGenerator& rays, uint32_t width, uint32_t height)
+{
+	Walnut::Timer timer;
+
+	m_Width = width;
+	m_Height = height;
+	m_Depth.resize(width * height);
+	m_ObjectIndex.resize(width * height);
+
+	uint32_t tileSize = culler.GetTileSize();
+	uint32_t tileCountX = culler.GetTileCountX();
+
+	// 每个任务负责一个 tile 的像素，写入互不重叠；候选按球体索引递增，深度相同时保留索引较小者
+	pool.ParallelFor(culler.GetTileCount(), [&](uint32_t tileIndex, uint32_t threadIndex)
+		{
+			glm::uvec2 tileMin{ tileIndex % tileCountX * tileSize, tileIndex / tileCountX * tileSize };
+			glm::uvec2 tileMax = glm::min(tileMin + tileSize, glm::uvec2(width, height)) - 1u;
+
+			for (uint32_t y = tileMin.y; y <= tileMax.y; y++)
+			{
+				std::fill_n(&m_Depth[tileMin.x + y * width], tileMax.x - tileMin.x + 1, FLT_MAX);
+				std::fill_n(&m_ObjectIndex[tileMin.x + y * width], tileMax.x - tileMin.x + 1, -1);
+			}
+
+			for (uint32_t reference = culler.GetTileBegin(tileIndex); reference < culler.GetTileEnd(tileIndex); reference++)
+			{
+				uint32_t sphereIndex = culler.GetReferenceIndex(reference);
+				const glm::vec4& sphere = culler.GetReferenceData(reference);
+
+				// 球体包围矩形与 tile 的交集
+				const glm::uvec4& pixels = culler.GetSpherePixels(sphereIndex);
+				glm::uvec2 first = glm::max(glm::uvec2(pixels.x, pixels.y), tileMin);
+				glm::uvec2 last = glm::min(glm::uvec2(pixels.z, pixels.w), tileMax);
+
+				for (uint32_t y = first.y; y <= last.y; y++)
+				{
+					for (uint32_t x = first.x; x <= last.x; x++)
+					{
+						uint32_t pixel = x + y * width;
+						Ray ray = rays.GetRay((float)x, (float)y);
+						if (SphereArray::IntersectSphere(ray, glm::dot(ray.Direction, ray.Direction), sphere, m_Depth[pixel]))
+							m_ObjectIndex[pixel] = (int)sphereIndex;
+					}
+				}
+			}
+		});
+
+	m_BuildTime = timer.ElapsedMillis();
+}
+
+void VisibilityBuffer::Clear()
+{
+	m_Width = m_Height = 0;
+	m_Depth.clear();
+	m_ObjectIndex.clear();
+	m_BuildTime = 0.0f;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "TileCuller.h"
+
+// 主光线可见性缓冲区：按 tile 并行光栅化每个球体在屏幕上的包围矩形，逐像素精确求交并做深度测试，保存最近的球体索引与距离
+class VisibilityBuffer
+{
+public:
+	VisibilityBuffer() = default;
+
+	// culler 提供每个 tile 的候选球体与每个球体覆盖的像素；rays 生成每个像素的主光线
+	void Build(ThreadPool& pool, const TileCuller& culler, const PrimaryRayGenerator& rays, uint32_t width, uint32_t height);
+	void Clear();
+
+	// 结果与对同一像素的主光线暴力求交一致
+	bool GetHit(uint32_t x, uint32_t y, float& hitDistance, int& objectIndex) const
+	{
+		uint32_t pixel = x + y * m_Width;
+		hitDistance = m_Depth[pixel];
+		objectIndex = m_ObjectIndex[pixel];
+		return objectIndex >= 0;
+	}
+
+	bool IsEmpty() const { return m_Depth.empty(); }
+	float GetBuildTime() const { return m_BuildTime; }
+private:
+	uint32_t m_Width = 0, m_Height = 0;
+
+	std::vector<float> m_Depth;
+	std::vector<int> m_ObjectIndex;
+
+	float m_BuildTime = 0.0f;
+};
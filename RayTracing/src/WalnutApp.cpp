@@ -8,6 +8,11 @@
 
 #include "Renderer.h"
 #include "Camera.h"
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <numeric>
+#include <thread>
 
 using namespace Walnut;
 
@@ -63,24 +68,275 @@ public:
 	{
 		if (m_Camera.OnUpdate(ts))
 		{
-			m_Renderer.ResetFrameIndex();
+			m_Renderer.OnCameraMoved();
 		}
 	}
 
 	virtual void OnUIRender() override
 	{
-		// ҲUI
+		// 右侧参数表UI设计
 		ImGui::Begin("Settings");
 		ImGui::Text("Last Render: %.3fms", m_LastRenderTime);
+		ImGui::Checkbox("Denoise", &m_Renderer.GetSettings().Denoise);
+		if (m_Renderer.GetSettings().Denoise)
+		{
+			Denoiser::Settings& denoising = m_Renderer.GetSettings().Denoising;
+			int iterations = (int)denoising.Iterations;
+			if (ImGui::SliderInt("Iterations", &iterations, 1, 6))
+				denoising.Iterations = (uint32_t)iterations;
+			ImGui::SliderFloat("Color Sigma", &denoising.ColorSigma, 0.1f, 20.0f);
+			ImGui::SliderFloat("Normal Sigma", &denoising.NormalSigma, 1.0f, 256.0f);
+			ImGui::SliderFloat("Depth Sigma", &denoising.DepthSigma, 0.001f, 1.0f, "%.3f");
+			ImGui::SliderFloat("Albedo Sigma", &denoising.AlbedoSigma, 0.01f, 1.0f);
+			ImGui::Text("Denoise: %.3fms", m_Renderer.GetDenoiser().GetTime());
+		}
+		ImGui::Checkbox("Temporal Reprojection", &m_Renderer.GetSettings().TemporalReprojection);
+		if (m_Renderer.GetSettings().TemporalReprojection)
+		{
+			int maxHistorySamples = (int)m_Renderer.GetSettings().MaxHistorySamples;
+			if (ImGui::SliderInt("Max History Samples", &maxHistorySamples, 1, 1024))
+				m_Renderer.GetSettings().MaxHistorySamples = (uint32_t)maxHistorySamples;
+			ImGui::SliderFloat("History Clamp", &m_Renderer.GetSettings().HistoryClampScale, 0.5f, 8.0f);
+		}
+		ImGui::Checkbox("Dynamic Resolution", &m_Renderer.GetSettings().DynamicResolution);
+		if (m_Renderer.GetSettings().DynamicResolution)
+		{
+			ImGui::SliderFloat("Target Frame Time", &m_Renderer.GetSettings().TargetFrameTime, 8.0f, 100.0f, "%.0fms");
+			glm::uvec2 renderResolution = m_Renderer.GetRenderResolution();
+			ImGui::Text("Render Resolution: %ux%u", renderResolution.x, renderResolution.y);
+		}
 		if (ImGui::Button("Render"))
 		{
 			Render();
 		}
 		ImGui::Checkbox("Accumulate", &m_Renderer.GetSettings().Accumulate);
+		ImGui::Checkbox("Packet Tracing", &m_Renderer.GetSettings().PacketTracing);
+		if (ImGui::Checkbox("Jitter", &m_Renderer.GetSettings().Jitter))
+			m_Renderer.ResetFrameIndex();
+		if (ImGui::Checkbox("Checkerboard", &m_Renderer.GetSettings().Checkerboard))
+			m_Renderer.ResetFrameIndex();
+		if (ImGui::Checkbox("Light Sampling", &m_Renderer.GetSettings().LightSampling))
+			m_Renderer.ResetFrameIndex();
+		if (m_Renderer.GetSettings().LightSampling)
+		{
+			const char* lightSelections[] = { "Uniform", "Light Tree" };
+			int lightSelection = (int)m_Renderer.GetSettings().LightSelection;
+			if (ImGui::Combo("Light Selection", &lightSelection, lightSelections, IM_ARRAYSIZE(lightSelections)))
+			{
+				m_Renderer.GetSettings().LightSelection = (LightSampler::Type)lightSelection;
+				m_Renderer.ResetFrameIndex();
+			}
+
+			const LightSampler& lightSampler = m_Renderer.GetLightSampler();
+			ImGui::Text("Lights: %u", lightSampler.GetLightCount());
+			if (lightSampler.GetType() == LightSampler::Type::LightTree)
+				ImGui::Text("Light Tree: %u nodes, %.3fms", lightSampler.GetLightTree().GetNodeCount(), lightSampler.GetLightTree().GetBuildTime());
+
+			Renderer::Settings& settings = m_Renderer.GetSettings();
+			if (ImGui::Checkbox("ReSTIR", &settings.ReSTIR))
+				m_Renderer.ResetFrameIndex();
+			if (settings.ReSTIR)
+			{
+				Renderer::Settings::ReSTIRSettings& resampling = settings.Resampling;
+				int candidateCount = (int)resampling.CandidateCount;
+				if (ImGui::SliderInt("Candidates", &candidateCount, 1, 32))
+					resampling.CandidateCount = (uint32_t)candidateCount;
+				ImGui::Checkbox("Temporal Reuse", &resampling.TemporalReuse);
+				int maxHistoryLength = (int)resampling.MaxHistoryLength;
+				if (ImGui::SliderInt("Max History", &maxHistoryLength, 1, 50))
+					resampling.MaxHistoryLength = (uint32_t)maxHistoryLength;
+				ImGui::Checkbox("Spatial Reuse", &resampling.SpatialReuse);
+				int spatialSamples = (int)resampling.SpatialSamples;
+				if (ImGui::SliderInt("Spatial Samples", &spatialSamples, 1, 8))
+					resampling.SpatialSamples = (uint32_t)spatialSamples;
+				ImGui::SliderFloat("Spatial Radius", &resampling.SpatialRadius, 1.0f, 32.0f, "%.0f px");
+			}
+		}
+		ImGui::Checkbox("Tile Culling", &m_Renderer.GetSettings().TileCulling);
+		ImGui::Checkbox("Visibility Buffer", &m_Renderer.GetSettings().UseVisibilityBuffer);
+		const TileCuller& tileCuller = m_Renderer.GetTileCuller();
+		if (tileCuller.GetTileCount() > 0)
+			ImGui::Text("Culling: %.1f spheres/tile, %.3fms", (float)tileCuller.GetReferenceCount() / tileCuller.GetTileCount(), tileCuller.GetBuildTime());
+		ImGui::Checkbox("Cache Primary Hits", &m_Renderer.GetSettings().CachePrimaryHits);
+		const PrimaryHitCache& primaryHitCache = m_Renderer.GetPrimaryHitCache();
+		if (primaryHitCache.GetMemory() > 0)
+			ImGui::Text("Primary Hit Cache: %.1f MB, %s", primaryHitCache.GetMemory() / (1024.0f * 1024.0f), primaryHitCache.IsValid() ? "valid" : "filling");
+		const VisibilityBuffer& visibilityBuffer = m_Renderer.GetVisibilityBuffer();
+		if (!visibilityBuffer.IsEmpty())
+			ImGui::Text("Visibility Buffer: %.3fms", visibilityBuffer.GetBuildTime());
+
+		const char* integratorTypes[] = { "Megakernel", "Wavefront" };
+		int integrator = (int)m_Renderer.GetSettings().Integrator;
+		if (ImGui::Combo("Integrator", &integrator, integratorTypes, IM_ARRAYSIZE(integratorTypes)))
+			m_Renderer.GetSettings().Integrator = (Renderer::IntegratorType)integrator;
+		if (m_Renderer.GetSettings().Integrator == Renderer::IntegratorType::Wavefront)
+		{
+			ImGui::Checkbox("Sort Rays", &m_Renderer.GetSettings().SortRays);
+
+			const std::vector<Renderer::WavefrontBounceStats>& wavefrontStats = m_Renderer.GetWavefrontStats();
+			for (uint32_t bounce = 0; bounce < wavefrontStats.size(); bounce++)
+			{
+				const Renderer::WavefrontBounceStats& stats = wavefrontStats[bounce];
+				ImGui::Text("Bounce %u: %u paths, sort %.2fms, extend %.2fms, %u shadow rays %.2fms", bounce, stats.PathCount, stats.SortTime, stats.ExtendTime, stats.ShadowRayCount, stats.ShadowTime);
+			}
+		}
+
+		// 自适应采样
+		if (ImGui::Checkbox("Adaptive Sampling", &m_Renderer.GetSettings().AdaptiveSampling))
+			m_Renderer.ResetFrameIndex();
+		ImGui::Checkbox("Show Sample Count", &m_Renderer.GetSettings().ShowSampleCount);
+		if (m_Renderer.GetSettings().AdaptiveSampling)
+		{
+			Renderer::Settings& settings = m_Renderer.GetSettings();
+			ImGui::DragFloat("Error Threshold", &settings.AdaptiveThreshold, 0.001f, 0.001f, 1.0f, "%.3f");
+			int minSamples = (int)settings.AdaptiveMinSamples;
+			if (ImGui::SliderInt("Min Samples", &minSamples, 2, 256))
+				settings.AdaptiveMinSamples = (uint32_t)minSamples;
+			int maxSamplesPerFrame = (int)settings.AdaptiveMaxSamplesPerFrame;
+			if (ImGui::SliderInt("Max Samples/Frame", &maxSamplesPerFrame, 1, 16))
+				settings.AdaptiveMaxSamplesPerFrame = (uint32_t)maxSamplesPerFrame;
+
+			glm::uvec2 tileCount = m_Renderer.GetTileCount();
+			ImGui::Text("Converged: %u/%u tiles, %u spp/frame on the rest", m_Renderer.GetConvergedTileCount(), tileCount.x * tileCount.y, m_Renderer.GetAdaptiveSampleCount());
+		}
+
+		// 多线程调度
+		int tileSize = (int)m_Renderer.GetSettings().TileSize;
+		if (ImGui::SliderInt("Tile Size", &tileSize, 8, 128))
+			m_Renderer.GetSettings().TileSize = (uint32_t)tileSize;
+		int threadCount = (int)m_Renderer.GetSettings().ThreadCount;
+		if (ImGui::SliderInt("Threads (0 = all)", &threadCount, 0, (int)std::thread::hardware_concurrency()))
+			m_Renderer.GetSettings().ThreadCount = (uint32_t)threadCount;
+
+		const char* curveTypes[] = { "Row Major", "Morton", "Hilbert" };
+		int tileOrder = (int)m_Renderer.GetSettings().TileOrder;
+		if (ImGui::Combo("Tile Order", &tileOrder, curveTypes, IM_ARRAYSIZE(curveTypes)))
+			m_Renderer.GetSettings().TileOrder = (SpaceFillingCurve::Type)tileOrder;
+		int pixelOrder = (int)m_Renderer.GetSettings().PixelOrder;
+		if (ImGui::Combo("Pixel Order", &pixelOrder, curveTypes, IM_ARRAYSIZE(curveTypes)))
+			m_Renderer.GetSettings().PixelOrder = (SpaceFillingCurve::Type)pixelOrder;
+
+		const std::vector<float>& tileTimes = m_Renderer.GetTileTimes();
+		if (!tileTimes.empty())
+		{
+			auto [minTime, maxTime] = std::minmax_element(tileTimes.begin(), tileTimes.end());
+			float totalTime = std::accumulate(tileTimes.begin(), tileTimes.end(), 0.0f);
+			glm::uvec2 tileCount = m_Renderer.GetTileCount();
+			ImGui::Text("Tiles: %ux%u on %u threads, %u stolen", tileCount.x, tileCount.y, m_Renderer.GetThreadCount(), m_Renderer.GetStealCount());
+			ImGui::Text("Tile time: min %.3fms, avg %.3fms, max %.3fms", *minTime, totalTime / tileTimes.size(), *maxTime);
+			ImGui::PlotHistogram("Tile Times", tileTimes.data(), (int)tileTimes.size(), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 60));
+		}
 		if (ImGui::Button("Reset"))
 		{
 			m_Renderer.ResetFrameIndex();
 		}
+
+		// 加速结构
+		const char* accelerationTypes[] = { "None", "BVH", "Wide BVH", "Grid" };
+		int acceleration = (int)m_Renderer.GetSettings().Acceleration;
+		if (ImGui::Combo("Acceleration", &acceleration, accelerationTypes, IM_ARRAYSIZE(accelerationTypes)))
+		{
+			m_Renderer.GetSettings().Acceleration = (Renderer::AccelerationType)acceleration;
+			m_Renderer.OnSceneChanged();
+		}
+
+		const char* buildQualities[] = { "Fast", "Balanced", "High" };
+		int buildQuality = (int)m_Renderer.GetSettings().BVHQuality;
+		if (ImGui::Combo("BVH Quality", &buildQuality, buildQualities, IM_ARRAYSIZE(buildQualities)))
+		{
+			m_Renderer.GetSettings().BVHQuality = (BVH::BuildQuality)buildQuality;
+			m_Renderer.OnSceneChanged();
+		}
+		ImGui::DragFloat("Refit Threshold", &m_Renderer.GetSettings().RefitThreshold, 0.05f, 1.0f, 10.0f);
+
+		const BVH& bvh = m_Renderer.GetBVH();
+		uint32_t primitiveCount = glm::max(bvh.GetPrimitiveCount(), 1u);
+		ImGui::Text("BVH: %u nodes, SAH cost %.2f", bvh.GetNodeCount(), bvh.GetSAHCost());
+		ImGui::Text("BVH Build: %.3fms, %.1f bytes/prim", bvh.GetBuildTime(), (float)bvh.GetNodeMemory() / primitiveCount);
+
+		const char* updateTypes[] = { "Refit", "Partial Rebuild", "Rebuild" };
+		ImGui::Text("BVH Update: %s, %.1fus", updateTypes[(int)bvh.GetLastUpdateType()], bvh.GetUpdateTime() * 1000.0f);
+
+		const WideBVH& wideBVH = m_Renderer.GetWideBVH();
+		if (!wideBVH.IsEmpty())
+			ImGui::Text("Wide BVH: %u nodes, %.3fms, %.1f bytes/prim", wideBVH.GetNodeCount(), wideBVH.GetBuildTime(), (float)wideBVH.GetNodeMemory() / primitiveCount);
+
+		const Grid& grid = m_Renderer.GetGrid();
+		if (!grid.IsEmpty())
+		{
+			glm::ivec3 resolution = grid.GetResolution();
+			ImGui::Text("Grid: %dx%dx%d, %.2f refs/sphere, %u large", resolution.x, resolution.y, resolution.z,
+				(float)grid.GetReferenceCount() / grid.GetSphereCount(), grid.GetLargeSphereCount());
+			ImGui::Text("Grid Build: %.3fms, %.1f bytes/prim", grid.GetBuildTime(), (float)grid.GetMemory() / grid.GetSphereCount());
+		}
+		ImGui::End();
+
+		ImGui::Begin("Benchmark");
+		if (ImGui::Button("BVH Build (1M spheres)"))
+		{
+			m_BenchmarkResult = Benchmark::BVHBuild();
+		}
+		if (ImGui::Button("BVH Traversal (100k spheres)"))
+		{
+			m_BenchmarkResult = Benchmark::BVHTraversal();
+		}
+		if (ImGui::Button("BVH Refit (100k spheres)"))
+		{
+			m_BenchmarkResult = Benchmark::BVHRefit();
+		}
+		if (ImGui::Button("Sphere Kernel (scalar vs SoA)"))
+		{
+			m_BenchmarkResult = Benchmark::SphereKernel();
+		}
+		if (ImGui::Button("Packet Tracing (primary rays)"))
+		{
+			m_BenchmarkResult = Benchmark::PacketTracing();
+		}
+		if (ImGui::Button("Thread Scaling (tiles vs per-pixel)"))
+		{
+			m_BenchmarkResult = Benchmark::ThreadScaling();
+		}
+		if (ImGui::Button("Pixel Order"))
+		{
+			m_BenchmarkResult = Benchmark::PixelOrder();
+		}
+		if (ImGui::Button("Primary Visibility"))
+		{
+			m_BenchmarkResult = Benchmark::PrimaryVisibility();
+		}
+		if (ImGui::Button("Adaptive Sampling"))
+		{
+			m_BenchmarkResult = Benchmark::AdaptiveSampling();
+		}
+		if (ImGui::Button("Reprojection (camera pan)"))
+		{
+			m_BenchmarkResult = Benchmark::Reprojection();
+		}
+		if (ImGui::Button("Checkerboard"))
+		{
+			m_BenchmarkResult = Benchmark::Checkerboard();
+		}
+		if (ImGui::Button("Denoiser"))
+		{
+			m_BenchmarkResult = Benchmark::Denoiser();
+		}
+		if (ImGui::Button("Light Sampling"))
+		{
+			m_BenchmarkResult = Benchmark::LightSampling();
+		}
+		if (ImGui::Button("Light Tree"))
+		{
+			m_BenchmarkResult = Benchmark::LightTree();
+		}
+		if (ImGui::Button("ReSTIR"))
+		{
+			m_BenchmarkResult = Benchmark::ReSTIR();
+		}
+		if (ImGui::Button("Grid vs BVH (moving spheres)"))
+		{
+			m_BenchmarkResult = Benchmark::GridVsBVH();
+		}
+		ImGui::TextUnformatted(m_BenchmarkResult.c_str());
 		ImGui::End();
 
 		ImGui::Begin("Scene");
@@ -89,9 +345,12 @@ public:
 			ImGui::PushID(i);
 
 			Sphere& sphere = m_Scene.Sphere[i];
-			ImGui::DragFloat3("Position", glm::value_ptr(sphere.Position), 0.05f);
-			ImGui::DragFloat("Radius", &sphere.Radius, 0.05f);
-			ImGui::DragInt("Material", &sphere.MaterialIndex, 1.0f, 0.0f, (int)m_Scene.Materials.size() - 1);
+			bool moved = ImGui::DragFloat3("Position", glm::value_ptr(sphere.Position), 0.05f);
+			moved |= ImGui::DragFloat("Radius", &sphere.Radius, 0.05f);
+			if (moved)
+				m_Renderer.OnSceneChanged(false);
+			if (ImGui::DragInt("Material", &sphere.MaterialIndex, 1.0f, 0.0f, (int)m_Scene.Materials.size() - 1))
+				m_Renderer.OnMaterialChanged();
 
 			ImGui::Separator();
 
@@ -106,8 +365,10 @@ public:
 			ImGui::ColorEdit3("Albedo", glm::value_ptr(material.Albedo));
 			ImGui::DragFloat("Roughness", &material.Roughness, 0.05f, 0.0f, 1.0f);
 			ImGui::DragFloat("Metallic", &material.Metallic, 0.05f, 0.0f, 1.0f);
-			ImGui::ColorEdit3("EmissionColor", glm::value_ptr(material.EmissionColor));
-			ImGui::DragFloat("EmissionPower", &material.EmissionPower, 0.05f, 0.0f, FLT_MAX);
+			bool emissionChanged = ImGui::ColorEdit3("EmissionColor", glm::value_ptr(material.EmissionColor));
+			emissionChanged |= ImGui::DragFloat("EmissionPower", &material.EmissionPower, 0.05f, 0.0f, FLT_MAX);
+			if (emissionChanged)
+				m_Renderer.OnMaterialChanged();
 
 			ImGui::Separator();
 
@@ -117,20 +378,20 @@ public:
 
 		ImGui::End();
 
-		// ӿUI
-		ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2{ 0.0f, 0.0f }); // ʽڵڱ߾Ϊ0
+		// 视口UI设计
+		ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2{ 0.0f, 0.0f }); // 设置样式窗口的内边距为0
 		ImGui::Begin("Viewport");
 
 		m_ViewportWidth = ImGui::GetContentRegionAvail().x;
 		m_ViewportHeight = ImGui::GetContentRegionAvail().y;
 
-		// ͼʾ
+		// 如果有图像，显示
 		auto image = m_Renderer.GetFinalImage();
 		if (image)
 		{
-			// ߲ʹõImageĿߣʹӿڵĿߣǵͼ񽫻ᱻ죬˵ӿڿ߽б仯ʱҪRenderťImage߲
+			// 这里宽高参数使用的是Image的宽高，如果使用视口的宽高，我们的图像将会被拉伸，因此当视口宽高进行变化时，我们需要单击Render按钮重新设置Image宽高参数
 			ImGui::Image(image->GetDescriptorSet(), { (float)image->GetWidth(), (float)image->GetHeight() }, 
-				ImVec2{ 0, 1 }, ImVec2{ 1, 0 }); // תyuv
+				ImVec2{ 0, 1 }, ImVec2{ 1, 0 }); // 翻转y轴的uv坐标
 		}
 
 		ImGui::End();
@@ -141,19 +402,19 @@ public:
 
 	void Render()
 	{
-		// Ӽʱ
+		// 添加计时器
 		Timer timer;
 
-		// ӿڿ
+		// 重置视口宽高
 		m_Renderer.OnResize(m_ViewportWidth, m_ViewportHeight);
 		
-		// 
+		// 重置相机参数
 		m_Camera.OnResize(m_ViewportWidth, m_ViewportHeight);
 
-		// Ⱦ
+		// 渲染
 		m_Renderer.Render(m_Scene, m_Camera);
 
-		// һ֡Ⱦʱ䵥λΪ루ms
+		// 设置上一帧渲染时间单位为毫秒（ms）
 		m_LastRenderTime = timer.ElapsedMillis();
 	}
 private:
@@ -163,6 +424,8 @@ private:
 
 	uint32_t m_ViewportWidth, m_ViewportHeight;
 	float m_LastRenderTime = 0.0f;
+
+	std::string m_BenchmarkResult;
 };
 
 Walnut::Application* Walnut::CreateApplication(int argc, char** argv)
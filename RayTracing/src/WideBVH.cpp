@@ -0,0 +1,326 @@
+#include "WideBVH.h"
+
+#include "Walnut/Timer.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace Utils
+{
+	// 遍历栈：每层最多压入 7 个兄弟节点
+	static constexpr uint32_t MaxStackSize = 7 * 64 + 1;
+
+	// 2^exponent，直接拼出浮点数的位
+	static float ExponentToScale(int8_t exponent)
+	{
+		uint32_t bits = (uint32_t)(exponent + 127) << 23;
+		float scale;
+		memcpy(&scale, &bits, sizeof(float));
+		return scale;
+	}}
+
+void WideBVH::Build(const BVH& bvh)
+{
+	Walnut::Timer timer;
+
+	Clear();
+
+	if (bvh.IsEmpty())
+		return;
+
+	m_PrimitiveIndices = bvh.GetPrimitiveIndices();
+	m_PrimitiveData = bvh.GetPrimitiveData();
+
+	const std::vector<BVH::Node>& binaryNodes = bvh.GetNodes();
+
+	struct BuildEntry
+	{
+		uint32_t WideIndex;
+		uint32_t BinaryIndex;
+	};
+
+	std::vector<BuildEntry> stack;
+	stack.push_back({ 0, 0 });
+	m_Nodes.reserve(bvh.GetNodeCount() / 4 + 1);
+	m_Nodes.emplace_back();
+
+	while (!stack.empty())
+	{
+		BuildEntry entry = stack.back();
+		stack.pop_back();
+
+		const BVH::Node& binaryNode = binaryNodes[entry.BinaryIndex];
+
+		// 反复展开面积最大的内部子节点，直到凑满 8 个子节点
+		uint32_t children[Width];
+		uint32_t childCount = 0;
+		if (binaryNode.IsLeaf())
+		{
+			children[childCount++] = entry.BinaryIndex;
+		}
+		else
+		{
+			children[childCount++] = binaryNode.LeftFirst;
+			children[childCount++] = binaryNode.LeftFirst + 1;
+		}
+
+		while (childCount < Width)
+		{
+			int largest = -1;
+			float largestArea = -1.0f;
+			for (uint32_t i = 0; i < childCount; i++)
+			{
+				const BVH::Node& child = binaryNodes[children[i]];
+				float area = child.GetBounds().GetSurfaceArea();
+				if (!child.IsLeaf() && area > largestArea)
+				{
+					largest = (int)i;
+					largestArea = area;
+				}
+			}
+
+			if (largest < 0)
+				break;
+
+			uint32_t expanded = binaryNodes[children[largest]].LeftFirst;
+			children[largest] = expanded;
+			children[childCount++] = expanded + 1;
+		}
+
+		// 量化网格：原点为父包围盒最小点，步长取能以 255 格覆盖父包围盒的最小 2 的幂
+		glm::vec3 origin = binaryNode.BoundsMin;
+		glm::vec3 extent = binaryNode.BoundsMax - binaryNode.BoundsMin;
+
+		Node node;
+		node.Origin = origin;
+		node.ChildCount = (uint8_t)childCount;
+
+		glm::vec3 scale;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			int exponent = extent[axis] > 0.0f ? (int)std::ceil(std::log2(extent[axis] / 255.0f)) : -126;
+			exponent = glm::clamp(exponent, -126, 127);
+			while (exponent < 127 && std::ldexp(255.0f, exponent) < extent[axis])
+				exponent++;
+
+			node.Exponent[axis] = (int8_t)exponent;
+			scale[axis] = Utils::ExponentToScale(node.Exponent[axis]);
+		}
+
+		uint8_t* quantizedMin[3] = { node.QuantizedMinX, node.QuantizedMinY, node.QuantizedMinZ };
+		uint8_t* quantizedMax[3] = { node.QuantizedMaxX, node.QuantizedMaxY, node.QuantizedMaxZ };
+		for (uint32_t i = 0; i < Width; i++)
+		{
+			if (i >= childCount)
+			{
+				for (int axis = 0; axis < 3; axis++)
+				{
+					quantizedMin[axis][i] = 0;
+					quantizedMax[axis][i] = 0;
+				}
+				node.ChildIndex[i] = 0;
+				node.PrimitiveCount[i] = 0;
+				continue;
+			}
+
+			const BVH::Node& child = binaryNodes[children[i]];
+
+			// 向外取整并校验解码结果，保证量化后的包围盒不小于原包围盒
+			for (int axis = 0; axis < 3; axis++)
+			{
+				int qmin = (int)std::floor((child.BoundsMin[axis] - origin[axis]) / scale[axis]);
+				int qmax = (int)std::ceil((child.BoundsMax[axis] - origin[axis]) / scale[axis]);
+				qmin = glm::clamp(qmin, 0, 255);
+				qmax = glm::clamp(qmax, 0, 255);
+				while (qmin > 0 && origin[axis] + (float)qmin * scale[axis] > child.BoundsMin[axis])
+					qmin--;
+				while (qmax < 255 && origin[axis] + (float)qmax * scale[axis] < child.BoundsMax[axis])
+					qmax++;
+
+				quantizedMin[axis][i] = (uint8_t)qmin;
+				quantizedMax[axis][i] = (uint8_t)qmax;
+			}
+
+			if (child.IsLeaf())
+			{
+				node.ChildIndex[i] = child.LeftFirst;
+				node.PrimitiveCount[i] = (uint8_t)child.PrimitiveCount;
+			}
+			else
+			{
+				uint32_t wideIndex = (uint32_t)m_Nodes.size();
+				m_Nodes.emplace_back();
+				stack.push_back({ wideIndex, children[i] });
+
+				node.ChildIndex[i] = wideIndex;
+				node.PrimitiveCount[i] = 0;
+			}
+		}
+
+		m_Nodes[entry.WideIndex] = node;
+	}
+
+	m_Nodes.shrink_to_fit();
+
+	m_BuildTime = timer.ElapsedMillis();
+}
+
+void WideBVH::Clear()
+{
+	m_Nodes.clear();
+	m_PrimitiveIndices.clear();
+	m_PrimitiveData.clear();
+	m_BuildTime = 0.0f;
+}
+
+bool WideBVH::Intersect(const Ray& ray, float& hitDistance, int& objectIndex) const
+{
+	if (m_Nodes.empty())
+		return false;
+
+	struct StackEntry
+	{
+		uint32_t Index;
+		uint32_t PrimitiveCount; // 为 0 表示内部节点
+		float Distance;
+	};
+
+	glm::vec3 inverseDirection = SafeInverse(ray.Direction);
+	float a = glm::dot(ray.Direction, ray.Direction);
+
+	bool hit = false;
+
+	StackEntry stack[Utils::MaxStackSize];
+	uint32_t stackSize = 0;
+	stack[stackSize++] = { 0, 0, 0.0f };
+
+#if defined(__AVX2__)
+	__m256 rayOrigin[3], rayInverse[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		rayOrigin[axis] = _mm256_set1_ps(ray.Origin[axis]);
+		rayInverse[axis] = _mm256_set1_ps(inverseDirection[axis]);
+	}
+#endif
+
+	while (stackSize > 0)
+	{
+		StackEntry entry = stack[--stackSize];
+		if (entry.Distance >= hitDistance)
+			continue;
+
+		if (entry.PrimitiveCount > 0)
+		{
+			// 叶子：与 Renderer::TraceRay 相同的求根公式
+			for (uint32_t i = 0; i < entry.PrimitiveCount; i++)
+			{
+				const glm::vec4& sphere = m_PrimitiveData[entry.Index + i];
+
+				glm::vec3 origin = ray.Origin - glm::vec3(sphere);
+				float b = 2.0f * glm::dot(origin, ray.Direction);
+				float c = glm::dot(origin, origin) - sphere.w;
+
+				float discriminant = b * b - 4.0f * a * c;
+				if (discriminant < 0.0f)
+					continue;
+
+				float tclose = (-b - glm::sqrt(discriminant)) / (2.0f * a);
+				if (tclose < hitDistance && tclose > 0.0f)
+				{
+					hitDistance = tclose;
+					objectIndex = (int)m_PrimitiveIndices[entry.Index + i];
+					hit = true;
+				}
+			}
+			continue;
+		}
+
+		const Node& node = m_Nodes[entry.Index];
+
+		// t = (Origin + Q * Scale - ray.Origin) / ray.Direction = Q * (Scale / ray.Direction) + (Origin - ray.Origin) / ray.Direction
+		alignas(32) float entryDistances[Width];
+		uint32_t hitMask;
+
+#if defined(__AVX2__)
+		{
+			const uint8_t* quantizedMin[3] = { node.QuantizedMinX, node.QuantizedMinY, node.QuantizedMinZ };
+			const uint8_t* quantizedMax[3] = { node.QuantizedMaxX, node.QuantizedMaxY, node.QuantizedMaxZ };
+
+			__m256 tEnter = _mm256_setzero_ps();
+			__m256 tExit = _mm256_set1_ps(hitDistance);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				__m256 scale = _mm256_mul_ps(_mm256_set1_ps(Utils::ExponentToScale(node.Exponent[axis])), rayInverse[axis]);
+				__m256 offset = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(node.Origin[axis]), rayOrigin[axis]), rayInverse[axis]);
+
+				__m256 qmin = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)quantizedMin[axis])));
+				__m256 qmax = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)quantizedMax[axis])));
+
+				__m256 t0 = _mm256_fmadd_ps(qmin, scale, offset);
+				__m256 t1 = _mm256_fmadd_ps(qmax, scale, offset);
+				tEnter = _mm256_max_ps(tEnter, _mm256_min_ps(t0, t1));
+				tExit = _mm256_min_ps(tExit, _mm256_max_ps(t0, t1));
+			}
+
+			hitMask = (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(tEnter, tExit, _CMP_LE_OQ));
+			_mm256_store_ps(entryDistances, tEnter);
+		}
+#else
+		{
+			hitMask = 0;
+			glm::vec3 scale, offset;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				scale[axis] = Utils::ExponentToScale(node.Exponent[axis]) * inverseDirection[axis];
+				offset[axis] = (node.Origin[axis] - ray.Origin[axis]) * inverseDirection[axis];
+			}
+
+			for (uint32_t i = 0; i < node.ChildCount; i++)
+			{
+				glm::vec3 qmin{ node.QuantizedMinX[i], node.QuantizedMinY[i], node.QuantizedMinZ[i] };
+				glm::vec3 qmax{ node.QuantizedMaxX[i], node.QuantizedMaxY[i], node.QuantizedMaxZ[i] };
+
+				glm::vec3 t0 = qmin * scale + offset;
+				glm::vec3 t1 = qmax * scale + offset;
+				glm::vec3 tNear = glm::min(t0, t1);
+				glm::vec3 tFar = glm::max(t0, t1);
+
+				float tEnter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+				float tExit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, hitDistance));
+
+				entryDistances[i] = tEnter;
+				if (tEnter <= tExit)
+					hitMask |= 1u << i;
+			}
+		}
+#endif
+
+		hitMask &= (1u << node.ChildCount) - 1;
+
+		// 命中的子节点按进入距离从远到近压栈，最近的先出栈
+		uint32_t firstEntry = stackSize;
+		while (hitMask)
+		{
+			uint32_t child = 0;
+			while (!(hitMask & (1u << child)))
+				child++;
+			hitMask &= hitMask - 1;
+
+			StackEntry childEntry = { node.ChildIndex[child], node.PrimitiveCount[child], entryDistances[child] };
+
+			uint32_t position = stackSize++;
+			while (position > firstEntry && stack[position - 1].Distance < childEntry.Distance)
+			{
+				stack[position] = stack[position - 1];
+				position--;
+			}
+			stack[position] = childEntry;
+		}
+	}
+
+	return hit;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "BVH.h"
+#include "Ray.h"
+
+// 由二叉 BVH 折叠而成的 8 叉 BVH，子节点包围盒相对父节点量化为 8 位，遍历时一次测试全部 8 个子节点
+class WideBVH
+{
+public:
+	static constexpr uint32_t Width = 8;
+
+	struct Node
+	{
+		// 子节点包围盒 = Origin + Q * 2^Exponent
+		glm::vec3 Origin;
+		int8_t Exponent[3];
+		uint8_t ChildCount;
+
+		uint8_t QuantizedMinX[Width], QuantizedMinY[Width], QuantizedMinZ[Width];
+		uint8_t QuantizedMaxX[Width], QuantizedMaxY[Width], QuantizedMaxZ[Width];
+
+		// 内部子节点为节点索引，叶子为第一个图元索引
+		uint32_t ChildIndex[Width];
+		// 为 0 表示内部子节点
+		uint8_t PrimitiveCount[Width];
+	};
+
+	WideBVH() = default;
+
+	void Build(const BVH& bvh);
+	void Clear();
+
+	bool Intersect(const Ray& ray, float& hitDistance, int& objectIndex) const;
+
+	bool IsEmpty() const { return m_Nodes.empty(); }
+	uint32_t GetNodeCount() const { return (uint32_t)m_Nodes.size(); }
+	size_t GetNodeMemory() const { return m_Nodes.size() * sizeof(Node); }
+	float GetBuildTime() const { return m_BuildTime; }
+private:
+	std::vector<Node> m_Nodes;
+
+	// 与二叉 BVH 相同的叶节点顺序
+	std::vector<uint32_t> m_PrimitiveIndices;
+	std::vector<glm::vec4> m_PrimitiveData;
+
+	float m_BuildTime = 0.0f;
+};
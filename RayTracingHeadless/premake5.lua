@@ -0,0 +1,59 @@
+project "RayTracingHeadless"
+   kind "ConsoleApp"
+   language "C++"
+   cppdialect "C++17"
+   staticruntime "off"
+   vectorextensions "AVX2"
+
+   -- Only the renderer core is shared with the GUI; no Walnut, GLFW or Vulkan
+   files
+   {
+      "src/**.h",
+      "src/**.cpp",
+
+      "../RayTracing/src/**.h",
+      "../RayTracing/src/**.cpp",
+   }
+
+   removefiles
+   {
+      "../RayTracing/src/WalnutApp.cpp",
+      "../RayTracing/src/Benchmark.h",
+      "../RayTracing/src/Benchmark.cpp",
+   }
+
+   includedirs
+   {
+      "src",
+      "../RayTracing/src",
+      "../Walnut/src",
+      "../vendor/glm",
+   }
+
+   defines { "RT_HEADLESS" }
+
+   targetdir ("../bin/" .. outputdir .. "/%{prj.name}")
+   objdir ("../bin-int/" .. outputdir .. "/%{prj.name}")
+
+   filter "system:windows"
+      systemversion "latest"
+
+   filter "system:linux"
+      -- /arch:AVX2 implies FMA on MSVC, GCC and Clang need it spelled out
+      buildoptions { "-mfma" }
+      -- libstdc++ runs std::execution::par (BVH and grid builds) on TBB
+      links { "pthread", "tbb" }
+
+   filter "configurations:Debug"
+      runtime "Debug"
+      symbols "On"
+
+   filter "configurations:Release"
+      runtime "Release"
+      optimize "On"
+      symbols "On"
+
+   filter "configurations:Dist"
+      runtime "Release"
+      optimize "On"
+      symbols "Off"
@@ -0,0 +1,205 @@
+#include "Renderer.h"
+#include "Camera.h"
+#include "SceneFile.h"
+
+#include "Walnut/Timer.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Utils
+{
+	// 单边与总像素数的上限，超过时逐像素缓冲区的分配不现实
+	static constexpr uint32_t MaxImageSize = 16384;
+	static constexpr uint64_t MaxPixelCount = 8192ull * 8192ull;
+	static constexpr uint32_t MaxThreadCount = 1024;
+
+	// 只接受 [minValue, maxValue] 内的十进制整数，拒绝负号、非数字字符与溢出
+	static bool ParseUInt(const char* text, uint32_t minValue, uint32_t maxValue, uint32_t& value)
+	{
+		if (text[0] < '0' || text[0] > '9')
+			return false;
+
+		errno = 0;
+		char* end = nullptr;
+		unsigned long long parsed = strtoull(text, &end, 10);
+		if (errno == ERANGE || *end != '\0' || parsed < minValue || parsed > maxValue)
+			return false;
+
+		value = (uint32_t)parsed;
+		return true;
+	}
+
+	static void PrintUsage()
+	{
+		printf("usage: RayTracingHeadless <scene> [options]\n"
+			"  -o <file>    output image (binary PPM), default output.ppm\n"
+			"  -w <width>   default 1920, at most 16384\n"
+			"  -h <height>  default 1080, at most 16384 (width x height at most 8192 x 8192)\n"
+			"  -s <samples> samples per pixel, default 64\n"
+			"  -t <threads> worker threads, default all hardware threads\n"
+			"  --denoise    denoise the final accumulation\n"
+			"  --aov        also write depth, normal, albedo and object ID as <output>.<aov>.pfm\n");
+	}
+
+	// Renderer 的第 0 行在画面底部，PPM 从顶部一行开始
+	static bool WritePPM(const std::string& path, const uint32_t* pixels, uint32_t width, uint32_t height)
+	{
+		FILE* file = fopen(path.c_str(), "wb");
+		if (!file)
+			return false;
+
+		fprintf(file, "P6\n%u %u\n255\n", width, height);
+		std::vector<uint8_t> row(width * 3);
+		for (uint32_t y = height; y-- > 0;)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				uint32_t color = pixels[x + y * width];
+				row[x * 3 + 0] = color & 0xff;
+				row[x * 3 + 1] = (color >> 8) & 0xff;
+				row[x * 3 + 2] = (color >> 16) & 0xff;
+			}
+			fwrite(row.data(), 1, row.size(), file);
+		}
+		return fclose(file) == 0;
+	}
+
+	// PFM 本身从底部一行开始，与 Renderer 的排列一致；比例为负表示小端
+	static bool WritePFM(const std::string& path, const float* data, uint32_t channels, uint32_t width, uint32_t height)
+	{
+		FILE* file = fopen(path.c_str(), "wb");
+		if (!file)
+			return false;
+
+		fprintf(file, "%s\n%u %u\n-1.0\n", channels == 3 ? "PF" : "Pf", width, height);
+		fwrite(data, sizeof(float), (size_t)width * height * channels, file);
+		return fclose(file) == 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string scenePath, outputPath = "output.ppm";
+	uint32_t width = 1920, height = 1080, samples = 64, threads = 0;
+	bool denoise = false, writeAOVs = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (arg == "-o" && hasValue)
+			outputPath = argv[++i];
+		else if (arg == "-w" && hasValue && Utils::ParseUInt(argv[i + 1], 1, Utils::MaxImageSize, width))
+			i++;
+		else if (arg == "-h" && hasValue && Utils::ParseUInt(argv[i + 1], 1, Utils::MaxImageSize, height))
+			i++;
+		else if (arg == "-s" && hasValue && Utils::ParseUInt(argv[i + 1], 1, UINT32_MAX, samples))
+			i++;
+		else if (arg == "-t" && hasValue && Utils::ParseUInt(argv[i + 1], 0, Utils::MaxThreadCount, threads))
+			i++;
+		else if (arg == "--denoise")
+			denoise = true;
+		else if (arg == "--aov")
+			writeAOVs = true;
+		else if (arg[0] != '-' && scenePath.empty())
+			scenePath = arg;
+		else
+		{
+			Utils::PrintUsage();
+			return 1;
+		}
+	}
+
+	if (scenePath.empty() || (uint64_t)width * height > Utils::MaxPixelCount)
+	{
+		Utils::PrintUsage();
+		return 1;
+	}
+
+	Scene scene;
+	SceneCamera sceneCamera;
+	std::string error;
+	if (!SceneFile::Load(scenePath, scene, sceneCamera, error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	Camera camera(sceneCamera.VerticalFOV, 0.1f, 100.0f);
+	camera.OnResize(width, height);
+	camera.SetView(sceneCamera.Position, sceneCamera.Direction);
+
+	// 相机固定，逐帧累积到 samples 帧；不需要交互预览的动态分辨率与重投影，AOV 与降噪只在最后一帧打开
+	Renderer renderer;
+	Renderer::Settings& settings = renderer.GetSettings();
+	settings.Accumulate = true;
+	settings.ThreadCount = threads;
+	settings.DynamicResolution = false;
+	settings.TemporalReprojection = false;
+	renderer.OnResize(width, height);
+
+	printf("Scene: %zu spheres, %zu materials\n", scene.Sphere.size(), scene.Materials.size());
+
+	Walnut::Timer timer;
+	float firstFrameTime = 0.0f;
+	for (uint32_t i = 0; i < samples; i++)
+	{
+		bool lastFrame = i + 1 == samples;
+		settings.Denoise = denoise && lastFrame;
+		settings.AOVs.Depth = settings.AOVs.Normal = settings.AOVs.Albedo = settings.AOVs.ObjectID = writeAOVs && lastFrame;
+
+		renderer.Render(scene, camera);
+
+		if (i == 0)
+			firstFrameTime = timer.ElapsedMillis();
+	}
+	float totalTime = timer.ElapsedMillis();
+
+	printf("Resolution: %ux%u, %u spp, %u threads\n", width, height, samples, renderer.GetThreadCount());
+	printf("First frame (including acceleration structure build): %.2fms\n", firstFrameTime);
+	printf("Total: %.2fms, %.2fms/sample, %.2f Msamples/s\n", totalTime, totalTime / samples,
+		(double)width * height * samples / (totalTime * 1000.0f));
+	if (denoise)
+		printf("Denoise: %.2fms\n", renderer.GetDenoiser().GetTime());
+
+	if (!Utils::WritePPM(outputPath, renderer.GetFinalImageData(), width, height))
+	{
+		fprintf(stderr, "cannot write %s\n", outputPath.c_str());
+		return 1;
+	}
+	printf("Wrote %s\n", outputPath.c_str());
+
+	if (writeAOVs)
+	{
+		uint32_t pixelCount = width * height;
+		std::vector<float> objectIDs(pixelCount);
+		const int* objectIndices = renderer.GetObjectIDAOV();
+		for (uint32_t i = 0; i < pixelCount; i++)
+			objectIDs[i] = (float)objectIndices[i];
+
+		struct { const char* Name; const float* Data; uint32_t Channels; } aovs[] = {
+			{ "depth", renderer.GetDepthAOV(), 1 },
+			{ "normal", &renderer.GetNormalAOV()->x, 3 },
+			{ "albedo", &renderer.GetAlbedoAOV()->x, 3 },
+			{ "objectid", objectIDs.data(), 1 },
+		};
+		for (const auto& aov : aovs)
+		{
+			std::string path = outputPath + "." + aov.Name + ".pfm";
+			if (!Utils::WritePFM(path, aov.Data, aov.Channels, width, height))
+			{
+				fprintf(stderr, "cannot write %s\n", path.c_str());
+				return 1;
+			}
+			printf("Wrote %s\n", path.c_str());
+		}
+	}
+
+	return 0;
+}
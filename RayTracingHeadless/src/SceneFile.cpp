@@ -0,0 +1,98 @@
+#include "SceneFile.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace Utils
+{
+	// 依次读取 count 个浮点数，数量不足时返回 false
+	static bool ReadFloats(std::istringstream& stream, float* values, int count)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			if (!(stream >> values[i]))
+				return false;
+		}
+		return true;
+	}
+}
+
+bool SceneFile::Load(const std::string& path, Scene& scene, SceneCamera& camera, std::string& error)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		error = "cannot open " + path;
+		return false;
+	}
+
+	scene = Scene();
+	camera = SceneCamera();
+
+	std::string line;
+	for (uint32_t lineNumber = 1; std::getline(file, line); lineNumber++)
+	{
+		line = line.substr(0, line.find('#'));
+
+		std::istringstream stream(line);
+		std::string type;
+		if (!(stream >> type))
+			continue;
+
+		auto fail = [&](const std::string& reason)
+		{
+			error = path + ":" + std::to_string(lineNumber) + ": " + reason;
+			return false;
+		};
+
+		float values[8];
+		if (type == "camera")
+		{
+			if (!Utils::ReadFloats(stream, values, 6))
+				return fail("camera expects position and direction");
+			camera.Position = { values[0], values[1], values[2] };
+			camera.Direction = { values[3], values[4], values[5] };
+			if (glm::dot(camera.Direction, camera.Direction) == 0.0f)
+				return fail("camera direction is zero");
+			if (Utils::ReadFloats(stream, values, 1))
+				camera.VerticalFOV = values[0];
+		}
+		else if (type == "material")
+		{
+			if (!Utils::ReadFloats(stream, values, 5))
+				return fail("material expects albedo, roughness and metallic");
+			Material& material = scene.Materials.emplace_back();
+			material.Albedo = { values[0], values[1], values[2], 1.0f };
+			material.Roughness = values[3];
+			material.Metallic = values[4];
+			if (Utils::ReadFloats(stream, values, 4))
+			{
+				material.EmissionColor = { values[0], values[1], values[2] };
+				material.EmissionPower = values[3];
+			}
+		}
+		else if (type == "sphere")
+		{
+			int materialIndex;
+			if (!Utils::ReadFloats(stream, values, 4) || !(stream >> materialIndex))
+				return fail("sphere expects position, radius and material index");
+			Sphere& sphere = scene.Sphere.emplace_back();
+			sphere.Position = { values[0], values[1], values[2] };
+			sphere.Radius = values[3];
+			sphere.MaterialIndex = materialIndex;
+		}
+		else
+			return fail("unknown record '" + type + "'");
+	}
+
+	for (const Sphere& sphere : scene.Sphere)
+	{
+		if (sphere.MaterialIndex < 0 || sphere.MaterialIndex >= (int)scene.Materials.size())
+		{
+			error = path + ": sphere material index " + std::to_string(sphere.MaterialIndex) + " out of range";
+			return false;
+		}
+	}
+
+	return true;
+}
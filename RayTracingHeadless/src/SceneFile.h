@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <glm/glm.hpp>
+
+#include "Scene.h"
+
+struct SceneCamera
+{
+	glm::vec3 Position{ 0.0f, 0.0f, 6.0f };
+	glm::vec3 Direction{ 0.0f, 0.0f, -1.0f };
+	float VerticalFOV = 45.0f;
+};
+
+// 文本场景文件，每行一条记录，# 之后为注释：
+//   camera <位置 xyz> <朝向 xyz> [垂直视角]
+//   material <反照率 rgb> <粗糙度> <金属度> [<自发光颜色 rgb> <自发光强度>]
+//   sphere <位置 xyz> <半径> <材质索引>
+namespace SceneFile
+{
+	// 读取失败时返回 false，error 为出错的行号与原因
+	bool Load(const std::string& path, Scene& scene, SceneCamera& camera, std::string& error);
+}
@@ -2,9 +2,19 @@
 workspace "RayTracing"
    architecture "x64"
    configurations { "Debug", "Release", "Dist" }
-   startproject "RayTracing"
+   -- RayTracing only exists on Windows
+   if os.target() == "windows" then
+      startproject "RayTracing"
+   else
+      startproject "RayTracingHeadless"
+   end
 
 outputdir = "%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
 
-include "WalnutExternal.lua"
-include "RayTracing"
\ No newline at end of file
+-- The interactive app needs Vulkan and GLFW and is Windows-only for now;
+-- the headless renderer builds everywhere
+if os.target() == "windows" then
+   include "WalnutExternal.lua"
+   include "RayTracing"
+end
+include "RayTracingHeadless"
\ No newline at end of file
@@ -0,0 +1,5 @@
+#!/bin/sh
+# Generates makefiles for the headless renderer (premake5 must be on PATH)
+
+cd "$(dirname "$0")/.."
+premake5 gmake2